@@ -8,4 +8,5 @@ cp /ucrt64/bin/libintl-8.dll build/
 cp /ucrt64/bin/libiconv-2.dll build/
 cp /ucrt64/bin/libepoxy-0.dll build/
 cp /ucrt64/bin/glfw3.dll build/
+cp /ucrt64/bin/zlib1.dll build/
 cp start_modding_suite.bat build/
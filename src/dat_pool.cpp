@@ -0,0 +1,46 @@
+#include "dat_pool.hpp"
+
+#include "spdlog/spdlog.h"
+
+using namespace wgrd_files;
+
+std::shared_ptr<const MappedFile> DatPool::get(const fs::path &path) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto it = m_files.find(path.string());
+  if (it != m_files.end()) {
+    return it->second;
+  }
+  auto file = std::make_shared<MappedFile>();
+  if (!file->open(path)) {
+    return nullptr;
+  }
+  spdlog::debug("mapped dat file {} with {} bytes", path.string(),
+                file->size());
+  m_files.insert({path.string(), file});
+  return file;
+}
+
+std::optional<DatView> DatPool::get_view(const fs::path &path, size_t offset,
+                                         size_t size) {
+  auto file = get(path);
+  if (!file) {
+    return std::nullopt;
+  }
+  if (offset > file->size() || size > file->size() - offset) {
+    spdlog::warn("range {:0X} + {:0X} is outside of {}", offset, size,
+                 path.string());
+    return std::nullopt;
+  }
+  auto data = std::span<const char>(file->data() + offset, size);
+  return DatView(std::move(file), data);
+}
+
+void DatPool::release(const fs::path &path) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_files.erase(path.string());
+}
+
+void DatPool::clear() {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_files.clear();
+}
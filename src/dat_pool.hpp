@@ -0,0 +1,56 @@
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <string>
+#include <unordered_map>
+
+#include "mapped_file.hpp"
+
+namespace wgrd_files {
+
+// view of an entry inside a mapped dat file, keeps the mapping alive as long
+// as the view exists
+class DatView {
+private:
+  std::shared_ptr<const MappedFile> m_file;
+  std::span<const char> m_data;
+
+public:
+  DatView() = default;
+  DatView(std::shared_ptr<const MappedFile> file, std::span<const char> data)
+      : m_file(std::move(file)), m_data(data) {}
+  const char *data() const { return m_data.data(); }
+  size_t size() const { return m_data.size(); }
+  bool empty() const { return m_data.empty(); }
+  std::span<const char> span() const { return m_data; }
+};
+
+/*
+ * Shared memory mappings of the dat files of a workspace.
+ *
+ * Every dat file is only mapped once and shared between all files reading
+ * from it. This is thread safe, so files can read their data from the thread
+ * pool.
+ * */
+class DatPool {
+private:
+  std::mutex m_mutex;
+  // fs_path -> mapping
+  std::unordered_map<std::string, std::shared_ptr<const MappedFile>> m_files;
+
+public:
+  // returns nullptr if the file can not be mapped
+  std::shared_ptr<const MappedFile> get(const fs::path &path);
+  // returns nullopt if the file can not be mapped or the range is invalid
+  std::optional<DatView> get_view(const fs::path &path, size_t offset,
+                                  size_t size);
+  // drops the mapping, needs to be called before overwriting the dat file.
+  // views still holding the mapping keep it alive until they are destroyed.
+  void release(const fs::path &path);
+  void clear();
+};
+
+} // namespace wgrd_files
@@ -0,0 +1,172 @@
+#include "edat_reader.hpp"
+
+#include "spdlog/spdlog.h"
+
+#include <algorithm>
+#include <cstring>
+
+using namespace wgrd_files;
+
+namespace {
+
+template <typename T> T read_le(const char *data) {
+  T ret;
+  std::memcpy(&ret, data, sizeof(T));
+  return ret;
+}
+
+} // namespace
+
+bool EDatReader::is_edat(const MappedFile &file) {
+  if (file.size() < edat_header::size) {
+    return false;
+  }
+  return !std::memcmp(file.data() + edat_header::magic, "edat", 4);
+}
+
+bool EDatReader::open(const fs::path &path) {
+  if (!m_file.open(path)) {
+    return false;
+  }
+  if (!is_edat(m_file)) {
+    spdlog::warn("{} is not an edat file", path.string());
+    m_file.close();
+    return false;
+  }
+  const char *data = m_file.data();
+  uint32_t version = read_le<uint32_t>(data + edat_header::version);
+  if (version != 2) {
+    spdlog::warn("unsupported edat version {} in {}", version, path.string());
+    m_file.close();
+    return false;
+  }
+  m_dict_offset = read_le<uint32_t>(data + edat_header::dict_offset);
+  m_dict_length = read_le<uint32_t>(data + edat_header::dict_length);
+  m_file_offset = read_le<uint32_t>(data + edat_header::file_offset);
+  if (m_file.subspan(m_dict_offset, m_dict_length).empty()) {
+    spdlog::warn("edat dictionary out of bounds in {}", path.string());
+    m_file.close();
+    return false;
+  }
+  return true;
+}
+
+std::optional<std::vector<EDatEntry>> EDatReader::read_entries() const {
+  if (!m_file.is_open()) {
+    return std::nullopt;
+  }
+  const char *data = m_file.data();
+  const size_t dict_end = m_dict_offset + m_dict_length;
+
+  std::vector<EDatEntry> ret;
+  // the path parts of the currently opened directories
+  std::vector<std::string_view> dirs;
+  // the dictionary offsets where the currently opened directories end
+  std::vector<size_t> endings;
+
+  // reads the null terminated name, names are padded to an even length
+  auto read_name = [&](size_t &pos) -> std::optional<std::string_view> {
+    const char *begin = data + pos;
+    const char *end = static_cast<const char *>(
+        std::memchr(begin, '\0', dict_end - pos));
+    if (!end) {
+      return std::nullopt;
+    }
+    std::string_view name(begin, end - begin);
+    pos += name.size() + 1;
+    if (name.size() % 2 == 0) {
+      pos += 1;
+    }
+    return name;
+  };
+
+  size_t pos = m_dict_offset;
+  while (pos < dict_end) {
+    const size_t entry_start = pos;
+    if (dict_end - pos < 8) {
+      spdlog::warn("truncated edat dictionary entry at {:0X}", pos);
+      return std::nullopt;
+    }
+    int32_t group_id = read_le<int32_t>(data + pos);
+    uint32_t entry_size = read_le<uint32_t>(data + pos + 4);
+    pos += 8;
+
+    if (group_id == 0) {
+      // file entry
+      if (dict_end - pos < 32) {
+        spdlog::warn("truncated edat file entry at {:0X}", entry_start);
+        return std::nullopt;
+      }
+      size_t dict_pos = pos;
+      uint64_t offset = read_le<uint64_t>(data + pos);
+      uint64_t size = read_le<uint64_t>(data + pos + 8);
+      // skip the md5 checksum
+      pos += 32;
+      auto name = read_name(pos);
+      if (!name) {
+        spdlog::warn("unterminated edat file name at {:0X}", entry_start);
+        return std::nullopt;
+      }
+      size_t path_size = name->size();
+      for (auto &dir : dirs) {
+        path_size += dir.size();
+      }
+      EDatEntry entry;
+      entry.path.reserve(path_size);
+      for (auto &dir : dirs) {
+        entry.path += dir;
+      }
+      entry.path += name.value();
+      entry.offset = m_file_offset + offset;
+      entry.size = size;
+      entry.dict_pos = dict_pos;
+      if (m_file.subspan(entry.offset, entry.size).empty() && size != 0) {
+        spdlog::warn("edat entry {} out of bounds", entry.path);
+        return std::nullopt;
+      }
+      ret.push_back(std::move(entry));
+
+      // close all directories ending with this entry
+      while (!endings.empty() && pos == endings.back()) {
+        dirs.pop_back();
+        endings.pop_back();
+      }
+    } else if (group_id > 0) {
+      // directory entry
+      if (entry_size != 0) {
+        endings.push_back(entry_start + entry_size);
+      } else if (!endings.empty()) {
+        endings.push_back(endings.back());
+      }
+      auto name = read_name(pos);
+      if (!name) {
+        spdlog::warn("unterminated edat dir name at {:0X}", entry_start);
+        return std::nullopt;
+      }
+      dirs.push_back(name.value());
+    } else {
+      spdlog::warn("invalid edat group id {} at {:0X}", group_id, entry_start);
+      return std::nullopt;
+    }
+  }
+
+  return ret;
+}
+
+std::vector<fs::path> EDatReader::get_dat_paths(const fs::path &path) {
+  std::vector<fs::path> ret;
+  std::error_code ec;
+  for (auto &entry : fs::recursive_directory_iterator(
+           path, fs::directory_options::skip_permission_denied, ec)) {
+    if (entry.is_regular_file() && entry.path().extension() == ".dat") {
+      ret.push_back(entry.path());
+    }
+  }
+  if (ec) {
+    spdlog::warn("failed to iterate {}: {}", path.string(), ec.message());
+  }
+  // the game patches are in folders named by their version, so sorting the
+  // paths puts the patches after the original files
+  std::sort(ret.begin(), ret.end());
+  return ret;
+}
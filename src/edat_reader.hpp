@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "mapped_file.hpp"
+
+namespace wgrd_files {
+
+// the edat header is packed, so these are the raw offsets into the file
+namespace edat_header {
+constexpr size_t magic = 0x00;
+constexpr size_t version = 0x04;
+constexpr size_t checksum = 0x08;
+constexpr size_t dict_offset = 0x19;
+constexpr size_t dict_length = 0x1D;
+constexpr size_t file_offset = 0x21;
+constexpr size_t file_length = 0x25;
+constexpr size_t sector_size = 0x2D;
+constexpr size_t checksum_size = 16;
+constexpr size_t size = 0x41;
+} // namespace edat_header
+
+struct EDatEntry {
+  // path inside the dat file, uses backslashes like the game does
+  std::string path;
+  // absolute offset inside the dat file
+  size_t offset;
+  size_t size;
+  // absolute offset of the dictionary entry's offset field, followed by the
+  // size and the md5 checksum of the data
+  size_t dict_pos;
+};
+
+/*
+ * Native reader for the dictionary of edat (version 2) files.
+ *
+ * The dictionary is a prefix tree, every directory entry contains a part of
+ * the path and the size of its subtree, every file entry the remaining part of
+ * the path and the offset / size of the data.
+ * */
+class EDatReader {
+private:
+  MappedFile m_file;
+  size_t m_dict_offset = 0;
+  size_t m_dict_length = 0;
+  size_t m_file_offset = 0;
+
+public:
+  bool open(const fs::path &path);
+  const MappedFile &get_file() const { return m_file; }
+  // returns nullopt if the dictionary is broken
+  std::optional<std::vector<EDatEntry>> read_entries() const;
+
+  static bool is_edat(const MappedFile &file);
+  // returns all dat files below the given path, sorted so that patches are
+  // after the files they are patching
+  static std::vector<fs::path> get_dat_paths(const fs::path &path);
+};
+
+} // namespace wgrd_files
@@ -0,0 +1,313 @@
+#include "edat_writer.hpp"
+
+#include "edat_reader.hpp"
+
+#include "spdlog/spdlog.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <format>
+#include <numeric>
+#include <random>
+#include <vector>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+using namespace wgrd_files;
+
+namespace {
+
+template <typename T> T read_le(const char *data) {
+  T ret;
+  std::memcpy(&ret, data, sizeof(T));
+  return ret;
+}
+
+template <typename T> void write_le(char *data, T value) {
+  std::memcpy(data, &value, sizeof(T));
+}
+
+// output file that can copy ranges of another file without reading them
+class OutFile {
+private:
+#ifdef _WIN32
+  std::FILE *m_file = nullptr;
+#else
+  int m_fd = -1;
+  // cleared once copy_file_range turns out to not work for these files
+  bool m_copy_range = true;
+#endif
+  uint64_t m_pos = 0;
+
+public:
+  OutFile() = default;
+  OutFile(const OutFile &) = delete;
+  OutFile &operator=(const OutFile &) = delete;
+  ~OutFile() { close(); }
+
+  bool open(const fs::path &path) {
+#ifdef _WIN32
+    m_file = std::fopen(path.string().c_str(), "wb");
+    return m_file != nullptr;
+#else
+    m_fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    return m_fd >= 0;
+#endif
+  }
+
+  // syncs the data to disk before closing, false if anything failed
+  bool close() {
+#ifdef _WIN32
+    if (!m_file) {
+      return true;
+    }
+    bool ret = std::fflush(m_file) == 0 && _commit(_fileno(m_file)) == 0;
+    ret &= std::fclose(m_file) == 0;
+    m_file = nullptr;
+#else
+    if (m_fd < 0) {
+      return true;
+    }
+    bool ret = fsync(m_fd) == 0;
+    ret &= ::close(m_fd) == 0;
+    m_fd = -1;
+#endif
+    return ret;
+  }
+
+  uint64_t pos() const { return m_pos; }
+
+  bool write(const char *data, size_t size) {
+#ifdef _WIN32
+    if (std::fwrite(data, 1, size, m_file) != size) {
+      return false;
+    }
+#else
+    size_t written = 0;
+    while (written < size) {
+      ssize_t ret = ::write(m_fd, data + written, size - written);
+      if (ret < 0 && errno == EINTR) {
+        continue;
+      }
+      if (ret <= 0) {
+        return false;
+      }
+      written += ret;
+    }
+#endif
+    m_pos += size;
+    return true;
+  }
+
+  bool pad_to(uint64_t pos) {
+    static const char zeros[4096] = {};
+    while (m_pos < pos) {
+      if (!write(zeros, std::min<uint64_t>(pos - m_pos, sizeof(zeros)))) {
+        return false;
+      }
+    }
+    return true;
+  }
+
+  // copies size bytes from offset of src_fd, data is the same range mapped
+  // into memory, which is written instead if the range can't be copied
+  bool copy(int src_fd, uint64_t offset, const char *data, size_t size) {
+#ifdef __linux__
+    size_t copied = 0;
+    while (m_copy_range && copied < size) {
+      loff_t src_offset = offset + copied;
+      ssize_t ret = copy_file_range(src_fd, &src_offset, m_fd, nullptr,
+                                    size - copied, 0);
+      if (ret < 0 && errno == EINTR) {
+        continue;
+      }
+      if (ret <= 0) {
+        if (ret < 0 && errno != EXDEV && errno != ENOSYS &&
+            errno != EOPNOTSUPP && errno != EINVAL) {
+          return false;
+        }
+        // e.g. different filesystems on old kernels, the rest is written
+        spdlog::debug("copy_file_range not usable, writing the data instead");
+        m_copy_range = false;
+        break;
+      }
+      copied += ret;
+      m_pos += ret;
+    }
+    return write(data + copied, size - copied);
+#else
+    (void)src_fd;
+    (void)offset;
+    return write(data, size);
+#endif
+  }
+};
+
+// the path as it is stored in the dictionary
+std::string to_dict_path(const std::string &vfs_path) {
+  std::string ret = vfs_path.starts_with("$/") ? vfs_path.substr(2) : vfs_path;
+  std::replace(ret.begin(), ret.end(), '/', '\\');
+  return ret;
+}
+
+uint64_t align_up(uint64_t pos, uint64_t alignment) {
+  return (pos + alignment - 1) / alignment * alignment;
+}
+
+} // namespace
+
+void EDatWriter::replace(const std::string &vfs_path, fs::path data_path) {
+  m_replacements[to_dict_path(vfs_path)] = std::move(data_path);
+}
+
+bool EDatWriter::write(const fs::path &src_path,
+                       const fs::path &dst_path) const {
+  EDatReader reader;
+  if (!reader.open(src_path)) {
+    return false;
+  }
+  auto entries = reader.read_entries();
+  if (!entries) {
+    spdlog::error("couldn't read edat dictionary of {}", src_path.string());
+    return false;
+  }
+  const MappedFile &src = reader.get_file();
+
+  // replaced entries, indexed like entries
+  std::vector<MappedFile> replaced(entries->size());
+  std::vector<bool> is_replaced(entries->size(), false);
+  size_t found = 0;
+  for (size_t idx = 0; idx < entries->size(); idx++) {
+    auto it = m_replacements.find(entries->at(idx).path);
+    if (it == m_replacements.end()) {
+      continue;
+    }
+    is_replaced[idx] = true;
+    found++;
+    // empty files can't be mapped, but don't need to be either
+    if (fs::file_size(it->second) != 0 && !replaced[idx].open(it->second)) {
+      return false;
+    }
+  }
+  if (found != m_replacements.size()) {
+    spdlog::error("{} of the changed files are not part of {}",
+                  m_replacements.size() - found, src_path.string());
+    return false;
+  }
+
+  const char *header = src.data();
+  uint64_t file_offset = read_le<uint32_t>(header + edat_header::file_offset);
+  uint32_t sector_size = read_le<uint32_t>(header + edat_header::sector_size);
+  if (file_offset > src.size()) {
+    spdlog::error("edat data offset out of bounds in {}", src_path.string());
+    return false;
+  }
+
+  // the data is written in the order of the source file, keeping its
+  // alignment if it had one
+  std::vector<size_t> order(entries->size());
+  std::iota(order.begin(), order.end(), 0);
+  std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+    return entries->at(a).offset < entries->at(b).offset;
+  });
+  uint64_t alignment = sector_size;
+  for (auto &entry : entries.value()) {
+    if (alignment <= 1 || (entry.offset - file_offset) % alignment != 0) {
+      alignment = 1;
+      break;
+    }
+  }
+
+  // header and dictionary, the entries are patched in this copy
+  std::string head(src.data(), file_offset);
+  std::vector<uint64_t> new_offsets(entries->size());
+  uint64_t data_size = 0;
+  for (size_t idx : order) {
+    auto &entry = entries->at(idx);
+    uint64_t size = is_replaced[idx] ? replaced[idx].size() : entry.size;
+    data_size = align_up(data_size, alignment);
+    new_offsets[idx] = data_size;
+    write_le<uint64_t>(head.data() + entry.dict_pos, data_size);
+    write_le<uint64_t>(head.data() + entry.dict_pos + 8, size);
+    if (is_replaced[idx]) {
+      // like the python packer with disabled checksums
+      std::memset(head.data() + entry.dict_pos + 16, 0,
+                  edat_header::checksum_size);
+    }
+    data_size += size;
+  }
+  write_le<uint64_t>(head.data() + edat_header::file_length, data_size);
+  // the dictionary changed, so its checksum doesn't match anymore either
+  std::memset(head.data() + edat_header::checksum, 0,
+              edat_header::checksum_size);
+
+  int src_fd = -1;
+#ifdef __linux__
+  src_fd = ::open(src_path.c_str(), O_RDONLY);
+  if (src_fd < 0) {
+    spdlog::error("Could not open {}", src_path.string());
+    return false;
+  }
+#endif
+
+  // unique per writer, other workspaces or a headless run may write the same
+  // dat at the same time
+  std::random_device rd;
+  fs::path tmp_path = dst_path;
+  tmp_path += std::format(".{:08x}{:08x}.tmp", rd(), rd());
+  OutFile out;
+  bool ret = out.open(tmp_path);
+  if (!ret) {
+    spdlog::error("Could not create {}", tmp_path.string());
+  }
+  ret = ret && out.write(head.data(), head.size());
+  for (size_t idx : order) {
+    if (!ret) {
+      break;
+    }
+    auto &entry = entries->at(idx);
+    ret = out.pad_to(file_offset + new_offsets[idx]);
+    if (!ret) {
+      break;
+    }
+    if (is_replaced[idx]) {
+      ret = out.write(replaced[idx].data(), replaced[idx].size());
+    } else {
+      ret = out.copy(src_fd, entry.offset, src.data() + entry.offset,
+                     entry.size);
+    }
+  }
+  ret = ret && out.pad_to(file_offset + data_size);
+  ret &= out.close();
+#ifdef __linux__
+  ::close(src_fd);
+#endif
+
+  if (!ret) {
+    spdlog::error("Could not write {}", tmp_path.string());
+    std::error_code ec;
+    fs::remove(tmp_path, ec);
+    return false;
+  }
+
+  // the source may be replaced, it must not be mapped anymore on windows
+  replaced.clear();
+  reader = EDatReader();
+  std::error_code ec;
+  fs::rename(tmp_path, dst_path, ec);
+  if (ec) {
+    spdlog::error("Could not replace {}: {}", dst_path.string(), ec.message());
+    fs::remove(tmp_path, ec);
+    return false;
+  }
+  spdlog::info("Wrote {} with {} replaced entries, {} bytes of data",
+               dst_path.string(), found, data_size);
+  return true;
+}
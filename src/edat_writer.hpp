@@ -0,0 +1,34 @@
+#pragma once
+
+#include <string>
+#include <unordered_map>
+
+#include <filesystem>
+namespace fs = std::filesystem;
+
+namespace wgrd_files {
+
+/*
+ * Rebuilds an edat (version 2) file with some of its entries replaced.
+ *
+ * The dictionary keeps its layout, only the offsets and sizes of the entries
+ * change, so it is copied and patched in place. The data of unchanged
+ * entries is streamed straight from the source file, on linux with
+ * copy_file_range so filesystems supporting it can share the extents instead
+ * of copying them. Nothing of the source gets extracted.
+ * */
+class EDatWriter {
+private:
+  // dictionary path (with backslashes) -> file containing the new data
+  std::unordered_map<std::string, fs::path> m_replacements;
+
+public:
+  // vfs_path may start with $/ and use forward slashes
+  void replace(const std::string &vfs_path, fs::path data_path);
+  bool empty() const { return m_replacements.empty(); }
+  // writes the new file to a temporary file next to dst_path and swaps it in
+  // when done, so dst_path may be the same as src_path
+  bool write(const fs::path &src_path, const fs::path &dst_path) const;
+};
+
+} // namespace wgrd_files
@@ -2,30 +2,196 @@
 #include <imgui.h>
 #include <imgui_stdlib.h>
 #include <iostream>
+#include <magic_enum.hpp>
 #include <memory>
 
+#include "edat_reader.hpp"
+#include "files/file_type.hpp"
+#include "vfs_cache.hpp"
 #include "helpers.hpp"
+#include "python_executor.hpp"
+#include "trace.hpp"
 #include "spdlog/spdlog.h"
 
 using namespace wgrd_files;
 
+namespace {
+
+// converts the result of create_vfs, the vfs paths of the metas are set by
+// fill_filetree. needs the gil
+std::vector<std::pair<std::string, FileMetaList>>
+to_vfs_files(py::dict files) {
+  std::vector<std::pair<std::string, FileMetaList>> ret;
+  for (auto [py_path, value_lst] : files) {
+    assert(py::isinstance<py::list>(value_lst));
+    FileMetaList meta_lst;
+    for (auto &value : value_lst) {
+      assert(py::isinstance<py::tuple>(value));
+      py::tuple tup = value.cast<py::tuple>();
+      py::str file = tup[0].cast<py::str>();
+      size_t offset = tup[1].cast<size_t>();
+      size_t size = tup[2].cast<size_t>();
+      unsigned int idx = tup[4].cast<unsigned int>();
+      meta_lst.push_back(
+          FileMeta("", file.cast<std::string>(), offset, size, idx));
+    }
+    ret.emplace_back(py_path.cast<std::string>(), std::move(meta_lst));
+  }
+  return ret;
+}
+
+} // namespace
+
+bool FileTree::create_filetree_native(fs::path path, bool is_file) {
+  std::vector<fs::path> dat_paths;
+  if (!is_file) {
+    dat_paths = EDatReader::get_dat_paths(path);
+  } else {
+    dat_paths.push_back(path);
+  }
+
+  std::vector<VfsCacheDat> dats;
+  for (auto &dat_path : dat_paths) {
+    auto dat = VfsCacheDat::from_path(dat_path);
+    if (!dat) {
+      spdlog::warn("couldn't stat dat file {}", dat_path.string());
+      return false;
+    }
+    dats.push_back(std::move(dat.value()));
+  }
+
+  fs::path cache_path;
+  if (!m_cache_dir.empty()) {
+    cache_path = VfsCache::get_cache_path(m_cache_dir, path);
+    auto cache = VfsCache::load(cache_path);
+    if (cache && cache->dats == dats) {
+      spdlog::info("loading file tree of {} from cache {}", path.string(),
+                   cache_path.string());
+      load_cache(cache.value());
+      filter_filetree();
+      return true;
+    }
+  }
+
+  std::map<std::string, FileMetaList> files;
+  for (size_t idx = 0; idx < dat_paths.size(); idx++) {
+    const fs::path &dat_path = dat_paths[idx];
+    EDatReader reader;
+    if (!reader.open(dat_path)) {
+      return false;
+    }
+    auto entries = reader.read_entries();
+    if (!entries) {
+      spdlog::error("couldn't read edat dictionary of {}", dat_path.string());
+      return false;
+    }
+    for (auto &entry : entries.value()) {
+      std::replace(entry.path.begin(), entry.path.end(), '\\', '/');
+      std::string full_vfs_path = "$/" + entry.path;
+      // the dat is already mapped, so detecting the types here is cheap
+      auto header = reader.get_file().subspan(
+          entry.offset, std::min(entry.size, file_type_header_size));
+      FileMeta meta(full_vfs_path, dat_path, entry.offset, entry.size, idx);
+      meta.type = detect_file_type(full_vfs_path, header);
+      files[full_vfs_path].push_back(std::move(meta));
+    }
+  }
+
+  if (!cache_path.empty()) {
+    save_cache(cache_path, std::move(dats), files);
+  }
+
+  for (auto &[full_vfs_path, meta_lst] : files) {
+    add_indexed_file(full_vfs_path);
+    vfs_files[full_vfs_path] = std::move(meta_lst);
+  }
+  filter_filetree();
+  return true;
+}
+
+void FileTree::load_cache(const VfsCache &cache) {
+  // the string ids of the cache are local to it, map them to ours
+  std::vector<uint32_t> string_ids;
+  string_ids.reserve(cache.strings.size());
+  for (auto &str : cache.strings) {
+    string_ids.push_back(get_string_id(str));
+  }
+
+  for (auto &entry : cache.entries) {
+    std::vector<uint32_t> vec;
+    vec.reserve(entry.parts.size());
+    std::string full_vfs_path = "$";
+    for (uint32_t part : entry.parts) {
+      vec.push_back(string_ids[part]);
+      full_vfs_path += "/" + cache.strings[part];
+    }
+    FileMetaList meta_lst;
+    meta_lst.reserve(entry.metas.size());
+    for (auto &meta : entry.metas) {
+      meta_lst.push_back(FileMeta(full_vfs_path, cache.dats[meta.dat_idx].path,
+                                  meta.offset, meta.size, meta.dat_idx,
+                                  meta.type));
+    }
+    vfs_files[full_vfs_path] = std::move(meta_lst);
+    vfs_indexed_files[std::move(vec)] = std::move(full_vfs_path);
+  }
+}
+
+void FileTree::save_cache(const fs::path &cache_path,
+                          std::vector<VfsCacheDat> dats,
+                          const std::map<std::string, FileMetaList> &files) {
+  VfsCache cache;
+  cache.dats = std::move(dats);
+  std::unordered_map<std::string, uint32_t> string_ids;
+  cache.entries.reserve(files.size());
+  for (auto &[full_vfs_path, meta_lst] : files) {
+    VfsCacheEntry entry;
+    std::string_view path = std::string_view(full_vfs_path).substr(2);
+    for (auto str_it : std::views::split(path, '/')) {
+      std::string str = std::string(str_it.begin(), str_it.end());
+      auto it = string_ids.find(str);
+      if (it == string_ids.end()) {
+        it = string_ids.insert({str, cache.strings.size()}).first;
+        cache.strings.push_back(str);
+      }
+      entry.parts.push_back(it->second);
+    }
+    for (auto &meta : meta_lst) {
+      entry.metas.push_back({(uint32_t)meta.idx, meta.offset, meta.size,
+                             meta.type.value_or(FileType::UNKNOWN)});
+    }
+    cache.entries.push_back(std::move(entry));
+  }
+  if (cache.save(cache_path)) {
+    spdlog::info("saved file tree cache to {}", cache_path.string());
+  }
+}
+
 void FileTree::create_filetree(fs::path path, bool is_file) {
-  py::gil_scoped_acquire acquire;
+  ScopedTrace trace("create_filetree", path.string());
+  if (create_filetree_native(path, is_file)) {
+    return;
+  }
+  spdlog::warn("native edat parsing failed for {}, falling back to create_vfs",
+               path.string());
+
   try {
-    py::object get_dat_paths =
-        py::module_::import("wgrd_cons_tools.create_vfs").attr("get_dat_paths");
-    py::object create_vfs =
-        py::module_::import("wgrd_cons_tools.create_vfs").attr("create_vfs");
-    py::object dat_paths;
-    if (!is_file) {
-      dat_paths = get_dat_paths((path).string());
-    } else {
-      dat_paths = py::list();
-      dat_paths.attr("append")(py::str(path.string()));
-    }
-    py::dict files = create_vfs(dat_paths);
-    fill_filetree(files);
-  } catch (py::error_already_set &e) {
+    auto files = PythonExecutor::get_instance().run([&path, is_file]() {
+      py::module_ module = py::module_::import("wgrd_cons_tools.create_vfs");
+      py::object get_dat_paths = module.attr("get_dat_paths");
+      py::object create_vfs = module.attr("create_vfs");
+      py::object dat_paths;
+      if (!is_file) {
+        dat_paths = get_dat_paths((path).string());
+      } else {
+        dat_paths = py::list();
+        dat_paths.attr("append")(py::str(path.string()));
+      }
+      py::dict py_files = create_vfs(dat_paths);
+      return to_vfs_files(py_files);
+    });
+    fill_filetree(std::move(files));
+  } catch (const PythonError &e) {
     spdlog::error(e.what());
     spdlog::error("couldn't create_filetree from: {} is_file {}", path.string(),
                   is_file);
@@ -59,39 +225,37 @@ bool FileTree::init_from_stream(std::ifstream &stream) {
   return false;
 }
 
-void FileTree::fill_filetree(py::dict files) {
-  for (auto [py_path, value_lst] : files) {
-    // spdlog::debug("parsing filetree item {}", path.cast<std::string>());
-    std::string path = py_path.cast<std::string>();
+void FileTree::fill_filetree(
+    std::vector<std::pair<std::string, FileMetaList>> files) {
+  for (auto &[path, meta_lst] : files) {
     std::replace(path.begin(), path.end(), '\\', '/');
     std::string full_vfs_path = "$/" + path;
-    assert(py::isinstance<py::list>(value_lst));
-    FileMetaList meta_lst;
-    for (auto &value : value_lst) {
-      assert(py::isinstance<py::tuple>(value));
-      py::tuple tup = value.cast<py::tuple>();
-      py::str file = tup[0].cast<py::str>();
-      size_t offset = tup[1].cast<size_t>();
-      size_t size = tup[2].cast<size_t>();
-      unsigned int idx = tup[4].cast<unsigned int>();
-      auto meta =
-          FileMeta(full_vfs_path, file.cast<std::string>(), offset, size, idx);
-      meta_lst.push_back(std::move(meta));
+    for (auto &meta : meta_lst) {
+      meta.vfs_path = full_vfs_path;
     }
     vfs_files[full_vfs_path] = std::move(meta_lst);
-    std::vector<uint32_t> vec;
-    for (auto str_it : std::views::split(path, '/')) {
-      std::string str = std::string(str_it.begin(), str_it.end());
-      if (!vfs_string_table.contains(str)) {
-        vfs_string_table[str] = vfs_string_table.size();
-      }
-      vec.push_back(vfs_string_table[str]);
-    }
-    vfs_indexed_files[vec] = full_vfs_path;
+    add_indexed_file(full_vfs_path);
   }
   filter_filetree();
 }
 
+void FileTree::add_indexed_file(const std::string &full_vfs_path) {
+  std::vector<uint32_t> vec;
+  std::string_view path = std::string_view(full_vfs_path).substr(2);
+  for (auto str_it : std::views::split(path, '/')) {
+    vec.push_back(get_string_id(std::string(str_it.begin(), str_it.end())));
+  }
+  vfs_indexed_files[vec] = full_vfs_path;
+}
+
+uint32_t FileTree::get_string_id(const std::string &str) {
+  auto it = vfs_string_table.find(str);
+  if (it == vfs_string_table.end()) {
+    it = vfs_string_table.insert({str, vfs_string_table.size()}).first;
+  }
+  return it->second;
+}
+
 void FileTree::filter_filetree() {
   if (m_search_lower.empty()) {
     vfs_filtered_files = vfs_indexed_files;
@@ -105,6 +269,35 @@ void FileTree::filter_filetree() {
   }
 }
 
+std::vector<FileMetaList> FileTree::get_files_of_type(FileType type) {
+  std::vector<FileMetaList> ret;
+  for (auto &[_, metas] : vfs_files) {
+    if (metas.empty()) {
+      continue;
+    }
+    auto &meta = metas.back();
+    // types are only missing if the file tree was created by create_vfs
+    FileType meta_type = meta.type ? meta.type.value() : detect_file_type(meta);
+    if (meta_type == type) {
+      ret.push_back(metas);
+    }
+  }
+  return ret;
+}
+
+void FileTree::render_file_type(const std::string &vfs_path) {
+  auto it = vfs_files.find(vfs_path);
+  if (it == vfs_files.end() || it->second.empty()) {
+    return;
+  }
+  auto &type = it->second.back().type;
+  if (!type || type.value() == FileType::UNKNOWN) {
+    return;
+  }
+  ImGui::SameLine();
+  ImGui::TextDisabled("%s", magic_enum::enum_name(type.value()).data());
+}
+
 std::optional<std::string> FileTree::render_file_list() {
   std::optional<std::string> ret = std::nullopt;
 
@@ -126,6 +319,7 @@ std::optional<std::string> FileTree::render_file_list() {
         selected_vfs_path = vfs_path;
         ret = vfs_path;
       }
+      render_file_type(vfs_path);
 
       if (vfs_path == selected_vfs_path) {
         ImGui::SetItemDefaultFocus();
@@ -199,6 +393,7 @@ std::optional<std::string> FileTree::render_file_tree() {
           selected_vfs_path = vfs_path;
           ret = vfs_path;
         }
+        render_file_type(vfs_path);
         if (vfs_path == selected_vfs_path) {
           ImGui::SetItemDefaultFocus();
         }
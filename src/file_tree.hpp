@@ -18,9 +18,13 @@ namespace fs = std::filesystem;
 #include <fstream>
 #include <spdlog/spdlog.h>
 
+#include "files/configs.hpp"
+
 namespace wgrd_files {
 
 class FileTree;
+struct VfsCache;
+struct VfsCacheDat;
 
 struct FileMeta {
   // path in the vfs of the game
@@ -34,6 +38,8 @@ struct FileMeta {
   // unique index of the dat file for the workspace
   // FIXME: technically useless now
   size_t idx;
+  // type detected from the header of the file, nullopt if not detected yet
+  std::optional<FileType> type = std::nullopt;
 };
 
 typedef std::vector<FileMeta> FileMetaList;
@@ -52,31 +58,36 @@ private:
   std::map<std::vector<uint32_t>, std::string> vfs_filtered_files;
 
   std::string selected_vfs_path = "";
+  // parses the dat dictionaries natively, returns false if any dat file could
+  // not be parsed
+  bool create_filetree_native(fs::path path, bool is_file);
   void create_filetree(fs::path path, bool is_file = false);
-  void fill_filetree(py::dict files);
+  // vfs paths relative to $/ with their metas
+  void fill_filetree(std::vector<std::pair<std::string, FileMetaList>> files);
+  // adds the path to vfs_string_table / vfs_indexed_files
+  void add_indexed_file(const std::string &full_vfs_path);
+  uint32_t get_string_id(const std::string &str);
+  // directory containing the vfs caches, caching is disabled if empty
+  fs::path m_cache_dir;
+  void load_cache(const VfsCache &cache);
+  void save_cache(const fs::path &cache_path, std::vector<VfsCacheDat> dats,
+                  const std::map<std::string, FileMetaList> &files);
   void filter_filetree();
+  // renders the detected type of the file next to its entry
+  void render_file_type(const std::string &vfs_path);
   std::optional<std::string> render_file_list();
   std::optional<std::string> render_file_tree();
 
 public:
+  // enables the on-disk cache of the parsed dat dictionaries
+  void set_cache_dir(fs::path cache_dir) { m_cache_dir = std::move(cache_dir); }
   bool init_from_wgrd_path(fs::path wgrd_path);
   bool init_from_dat_path(fs::path path);
   bool init_from_path(fs::path path);
   bool init_from_stream(std::ifstream &stream);
   std::optional<FileMetaList> render();
-  std::vector<FileMetaList> get_all_files() {
-    std::vector<FileMetaList> ret;
-    for (auto &[_, metas] : vfs_files) {
-      ret.push_back({});
-      for (auto &meta : metas) {
-        if (meta.vfs_path.ends_with(".ndfbin")) {
-          spdlog::info("all files contains {}", meta.vfs_path);
-          ret.back().push_back(meta);
-        }
-      }
-    }
-    return ret;
-  }
+  // returns the metas of all files, whose current version has the given type
+  std::vector<FileMetaList> get_files_of_type(FileType type);
 };
 
 } // namespace wgrd_files
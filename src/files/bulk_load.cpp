@@ -0,0 +1,147 @@
+#include "bulk_load.hpp"
+
+#include "files/file.hpp"
+#include "threadpool.hpp"
+
+#include <algorithm>
+#include <format>
+
+#include <imgui.h>
+#include <libintl.h>
+#include <magic_enum.hpp>
+
+using namespace wgrd_files;
+
+BulkLoad::BulkLoad(const std::vector<File *> &files) : m_entries(files.size()) {
+  for (size_t i = 0; i < files.size(); i++) {
+    auto &entry = m_entries[i];
+    entry.file = files[i];
+    entry.vfs_path = files[i]->get_meta().vfs_path;
+    entry.size = files[i]->get_meta().size;
+    m_total_bytes += entry.size;
+  }
+  m_future = m_promise.get_future().share();
+}
+
+std::shared_future<bool> BulkLoad::start(size_t max_concurrency) {
+  m_start = std::chrono::steady_clock::now();
+  if (m_entries.empty()) {
+    m_elapsed_ms = 0;
+    m_promise.set_value(true);
+    return m_future;
+  }
+  size_t workers = std::clamp<size_t>(max_concurrency, 1, m_entries.size());
+  m_running_workers = workers;
+  spdlog::info("Loading {} files with {} workers", m_entries.size(), workers);
+  for (size_t i = 0; i < workers; i++) {
+    submit_work();
+  }
+  return m_future;
+}
+
+void BulkLoad::submit_work() {
+  // the workers keep the bulk load alive, even if its owner drops it
+  ThreadPoolSingleton::get_instance().submit(
+      TaskPriority::BACKGROUND,
+      [self = shared_from_this()]() { self->work(); });
+}
+
+void BulkLoad::work() {
+  size_t idx = m_entries.size();
+  {
+    std::lock_guard lock(m_mutex);
+    if (!m_cancelled && m_next < m_entries.size()) {
+      idx = m_next++;
+      m_parsing++;
+    }
+  }
+  if (idx < m_entries.size()) {
+    auto &entry = m_entries[idx];
+    entry.state = State::PARSING;
+    auto start = std::chrono::steady_clock::now();
+    bool ret = entry.file->parse();
+    entry.duration_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                            std::chrono::steady_clock::now() - start)
+                            .count();
+    entry.state = ret ? State::DONE : State::FAILED;
+    if (!ret) {
+      m_failed++;
+    }
+    m_bytes_finished += entry.size;
+    m_finished++;
+    {
+      std::lock_guard lock(m_mutex);
+      m_parsing--;
+    }
+    m_idle.notify_all();
+    // queued again instead of looping, so interactive tasks get in between
+    submit_work();
+    return;
+  }
+  // the last worker fulfills the promise
+  if (--m_running_workers == 0) {
+    m_elapsed_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                       std::chrono::steady_clock::now() - m_start)
+                       .count();
+    spdlog::info("Loaded {} of {} files in {}ms, {} failed", m_finished.load(),
+                 m_entries.size(), m_elapsed_ms.load(), m_failed.load());
+    m_promise.set_value(m_failed == 0 && is_done());
+  }
+}
+
+void BulkLoad::cancel() {
+  std::unique_lock lock(m_mutex);
+  m_cancelled = true;
+  m_idle.wait(lock, [this]() { return m_parsing == 0; });
+}
+
+void BulkLoad::render() {
+  size_t finished = m_finished;
+  size_t total = m_entries.size();
+  int64_t elapsed_ms = m_elapsed_ms;
+  if (elapsed_ms < 0) {
+    elapsed_ms = std::chrono::duration_cast<std::chrono::milliseconds>(
+                     std::chrono::steady_clock::now() - m_start)
+                     .count();
+  }
+  double seconds = std::max<double>(elapsed_ms, 1) / 1000.0;
+  double mib = m_bytes_finished / (1024.0 * 1024.0);
+
+  std::string overlay = std::format("{}/{}", finished, total);
+  ImGui::ProgressBar(total ? (float)finished / total : 1.0f,
+                     ImVec2(-FLT_MIN, 0), overlay.c_str());
+  ImGui::Text(gettext("%zu failed, %.1f files/s, %.1f MiB/s, %.1fs"),
+              m_failed.load(), finished / seconds, mib / seconds, seconds);
+
+  if (!ImGui::TreeNode(gettext("Loaded files"))) {
+    return;
+  }
+  if (ImGui::BeginTable("bulk_load", 3,
+                        ImGuiTableFlags_ScrollY | ImGuiTableFlags_RowBg,
+                        ImVec2(0, ImGui::GetTextLineHeight() * 12))) {
+    ImGui::TableSetupScrollFreeze(0, 1);
+    ImGui::TableSetupColumn(gettext("File"));
+    ImGui::TableSetupColumn(gettext("State"));
+    ImGui::TableSetupColumn(gettext("Time"));
+    ImGui::TableHeadersRow();
+    ImGuiListClipper clipper;
+    clipper.Begin(m_entries.size());
+    while (clipper.Step()) {
+      for (int i = clipper.DisplayStart; i < clipper.DisplayEnd; i++) {
+        auto &entry = m_entries[i];
+        State state = entry.state;
+        ImGui::TableNextRow();
+        ImGui::TableNextColumn();
+        ImGui::TextUnformatted(entry.vfs_path.c_str());
+        ImGui::TableNextColumn();
+        ImGui::TextUnformatted(magic_enum::enum_name(state).data());
+        ImGui::TableNextColumn();
+        if (state == State::DONE || state == State::FAILED) {
+          ImGui::Text("%lldms", (long long)entry.duration_ms.load());
+        }
+      }
+    }
+    ImGui::EndTable();
+  }
+  ImGui::TreePop();
+}
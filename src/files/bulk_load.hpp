@@ -0,0 +1,77 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "files/files.hpp"
+
+namespace wgrd_files {
+
+/*
+ * Parses a set of files in the background with a bounded number of workers.
+ *
+ * Only the given number of parses run at the same time, so loading every
+ * ndfbin of a workspace does not flood the scheduler and the memory. Every
+ * parse is its own background task, so anything the user waits for runs
+ * before the next file is started.
+ * Progress is tracked per file and in aggregate, the future returned by start
+ * is ready once every file is done and is true if all of them parsed.
+ * The files are borrowed from their workspace, which cancels the load before
+ * it drops them.
+ * */
+class BulkLoad : public std::enable_shared_from_this<BulkLoad> {
+public:
+  enum class State { QUEUED, PARSING, DONE, FAILED };
+
+  struct Entry {
+    File *file = nullptr;
+    std::string vfs_path;
+    size_t size = 0;
+    std::atomic<State> state = State::QUEUED;
+    std::atomic<int64_t> duration_ms = 0;
+  };
+
+private:
+  std::vector<Entry> m_entries;
+  // guards m_next, m_cancelled and m_parsing, so no parse starts once cancel
+  // waits for the running ones
+  std::mutex m_mutex;
+  std::condition_variable m_idle;
+  size_t m_next = 0;
+  bool m_cancelled = false;
+  size_t m_parsing = 0;
+  std::atomic_size_t m_finished = 0;
+  std::atomic_size_t m_failed = 0;
+  std::atomic_size_t m_bytes_finished = 0;
+  std::atomic_size_t m_running_workers = 0;
+  size_t m_total_bytes = 0;
+
+  std::chrono::steady_clock::time_point m_start;
+  std::atomic<int64_t> m_elapsed_ms = -1;
+
+  std::promise<bool> m_promise;
+  std::shared_future<bool> m_future;
+
+  // parses the next queued entry and requeues the worker
+  void work();
+  void submit_work();
+
+public:
+  // the files need to be prepared with File::prepare_parsing
+  explicit BulkLoad(const std::vector<File *> &files);
+  std::shared_future<bool> start(size_t max_concurrency);
+  std::shared_future<bool> get_future() const { return m_future; }
+  bool is_done() const { return m_finished == m_entries.size(); }
+  // starts no more parses and blocks until the running ones are done, the
+  // files can be dropped afterwards
+  void cancel();
+  void render();
+};
+
+} // namespace wgrd_files
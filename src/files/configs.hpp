@@ -36,6 +36,9 @@ struct WorkspaceConfig {
   fs::path db_path;
   // temp folder
   fs::path tmp_path;
+  // undo steps kept in memory per file, older ones are spilled to db_path
+  size_t undo_history_entries = 1000;
+  size_t undo_history_bytes = 64 * 1024 * 1024;
   toml::table to_toml() {
     toml::table table;
     table["name"] = name;
@@ -45,8 +48,22 @@ struct WorkspaceConfig {
     table["xml_path"] = xml_path.string();
     table["db_path"] = db_path.string();
     table["tmp_path"] = tmp_path.string();
+    table["undo_history_entries"] = static_cast<int64_t>(undo_history_entries);
+    table["undo_history_bytes"] = static_cast<int64_t>(undo_history_bytes);
     return table;
   }
+  // values <= 0 would wrap around, those keep the default
+  static void read_undo_budget(toml::table &table, const char *key,
+                               size_t &value) {
+    int64_t read = table[key].as_integer();
+    if (read <= 0) {
+      spdlog::error("{} of the workspace config must be positive, got {}, "
+                    "using {}",
+                    key, read, value);
+      return;
+    }
+    value = static_cast<size_t>(read);
+  }
   bool from_toml(toml::table table) noexcept {
     try {
       name = table["name"].as_string();
@@ -56,6 +73,13 @@ struct WorkspaceConfig {
       xml_path = table["xml_path"].as_string();
       db_path = table["db_path"].as_string();
       tmp_path = table["tmp_path"].as_string();
+      // optional, older project files don't have them
+      if (table.contains("undo_history_entries")) {
+        read_undo_budget(table, "undo_history_entries", undo_history_entries);
+      }
+      if (table.contains("undo_history_bytes")) {
+        read_undo_budget(table, "undo_history_bytes", undo_history_bytes);
+      }
     } catch (const toml::type_error &e) {
       spdlog::error("error while parsing workspace config: {}", e.what());
       return false;
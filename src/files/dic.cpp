@@ -1,31 +1,66 @@
 #include "dic.hpp"
 #include "helpers.hpp"
+#include "python_executor.hpp"
+#include "trace.hpp"
 
 #include <imgui.h>
 #include <imgui_stdlib.h>
 
 using namespace pybind11::literals;
 
+namespace {
+
+typedef std::vector<std::pair<std::string, std::string>> DicEntries;
+
+// needs the gil
+DicEntries to_dic_entries(py::handle entries) {
+  DicEntries ret;
+  for (auto &entry : entries) {
+    spdlog::debug("Entry: {}", py::str(entry).cast<std::string>());
+    std::string hash =
+        py::str(entry["hash"].attr("hex")()).cast<std::string>();
+    std::string str = py::str(entry["string"]).cast<std::string>();
+    spdlog::debug("Dic Hash: {}, String: {}", hash, str);
+    ret.emplace_back(std::move(hash), std::move(str));
+  }
+  return ret;
+}
+
+// needs the gil
+py::dict to_py_dic(const std::map<std::string, std::string> &dic_data) {
+  py::dict py_dic_data;
+  py_dic_data["entries"] = py::list();
+  for (auto &[hash, str] : dic_data) {
+    py::bytes hash_bytes;
+    hash_bytes = hash_bytes.attr("fromhex")(py::str(hash));
+    py::dict entry;
+    entry["hash"] = hash_bytes;
+    entry["string"] = py::str(str);
+    py_dic_data["entries"].attr("append")(entry);
+  }
+  return py_dic_data;
+}
+
+} // namespace
+
 bool wgrd_files::Dic::load_stream() {
   spdlog::info("Parsing Dic: {}", meta.vfs_path);
+  ScopedTrace trace("load_stream", meta.vfs_path);
 
   try {
-    py::gil_scoped_acquire acquire;
-    py::object dic = py::module::import("wgrd_cons_parsers.dic").attr("Dic");
-    std::vector<char> vec_data = get_data();
-    py::bytes data(vec_data.data(), vec_data.size());
-    py::object parsed = dic.attr("parse")(data);
-    spdlog::debug("parsed dic successfully {} {}", py::len(parsed),
-                  py::str(parsed).cast<std::string>());
-    for (auto &entry : parsed["entries"]) {
-      spdlog::debug("Entry: {}", py::str(entry).cast<std::string>());
-      std::string hash =
-          py::str(entry["hash"].attr("hex")()).cast<std::string>();
-      std::string str = py::str(entry["string"]).cast<std::string>();
-      spdlog::debug("Dic Hash: {}, String: {}", hash, str);
+    DatView view = get_data();
+    DicEntries entries = PythonExecutor::get_instance().run([&view]() {
+      py::object dic = py::module::import("wgrd_cons_parsers.dic").attr("Dic");
+      py::bytes data(view.data(), view.size());
+      py::object parsed = dic.attr("parse")(data);
+      spdlog::debug("parsed dic successfully {} {}", py::len(parsed),
+                    py::str(parsed).cast<std::string>());
+      return to_dic_entries(parsed["entries"]);
+    });
+    for (auto &[hash, str] : entries) {
       dic_data[hash] = str;
     }
-  } catch (const py::error_already_set &e) {
+  } catch (const PythonError &e) {
     spdlog::error("Error parsing Dic: {}", e.what());
     return false;
   }
@@ -35,20 +70,20 @@ bool wgrd_files::Dic::load_stream() {
 
 bool wgrd_files::Dic::load_xml(fs::path path) {
   spdlog::info("Loading Dic XML: {} from {}", meta.vfs_path, path.string());
+  ScopedTrace trace("load_xml", meta.vfs_path);
 
   try {
-    py::gil_scoped_acquire acquire;
-    py::module ET = py::module::import("xml.etree.ElementTree");
-    py::object dic = py::module::import("wgrd_cons_parsers.dic").attr("Dic");
-    py::object xml = ET.attr("parse")(path.string());
-    py::dict py_dic_data = dic.attr("fromET")(xml.attr("getroot")());
-    for (auto &entry : py_dic_data["entries"]) {
-      std::string hash =
-          py::str(entry["hash"].attr("hex")()).cast<std::string>();
-      std::string str = py::str(entry["string"]).cast<std::string>();
+    DicEntries entries = PythonExecutor::get_instance().run([&path]() {
+      py::module ET = py::module::import("xml.etree.ElementTree");
+      py::object dic = py::module::import("wgrd_cons_parsers.dic").attr("Dic");
+      py::object xml = ET.attr("parse")(path.string());
+      py::dict py_dic_data = dic.attr("fromET")(xml.attr("getroot")());
+      return to_dic_entries(py_dic_data["entries"]);
+    });
+    for (auto &[hash, str] : entries) {
       dic_data[hash] = str;
     }
-  } catch (const py::error_already_set &e) {
+  } catch (const PythonError &e) {
     spdlog::error("Error loading Dic XML: {}", e.what());
     return false;
   }
@@ -58,30 +93,23 @@ bool wgrd_files::Dic::load_xml(fs::path path) {
 
 bool wgrd_files::Dic::save_xml(fs::path path) {
   spdlog::info("Saving Dic XML: {} to {}", meta.vfs_path, path.string());
+  ScopedTrace trace("save_xml", meta.vfs_path);
 
   try {
-    py::gil_scoped_acquire acquire;
-    py::dict py_dic_data;
-    py_dic_data["entries"] = py::list();
-    for (auto &[hash, str] : dic_data) {
-      py::bytes hash_bytes;
-      hash_bytes = hash_bytes.attr("fromhex")(py::str(hash));
-      py::dict entry;
-      entry["hash"] = hash_bytes;
-      entry["string"] = py::str(str);
-      py_dic_data["entries"].attr("append")(entry);
-    }
-
-    py::module ET = py::module::import("xml.etree.ElementTree");
-    py::object dic = py::module::import("wgrd_cons_parsers.dic").attr("Dic");
-    py::object xml =
-        dic.attr("toET")(py_dic_data, "name"_a = "Dic", "is_root"_a = false);
-    ET.attr("indent")(xml, "space"_a = "  ", "level"_a = 0);
-    py::str xml_string = ET.attr("tostring")(xml).attr("decode")("utf-8");
+    std::string xml_string = PythonExecutor::get_instance().run([this]() {
+      py::dict py_dic_data = to_py_dic(dic_data);
+      py::module ET = py::module::import("xml.etree.ElementTree");
+      py::object dic = py::module::import("wgrd_cons_parsers.dic").attr("Dic");
+      py::object xml =
+          dic.attr("toET")(py_dic_data, "name"_a = "Dic", "is_root"_a = false);
+      ET.attr("indent")(xml, "space"_a = "  ", "level"_a = 0);
+      py::str ret = ET.attr("tostring")(xml).attr("decode")("utf-8");
+      return ret.cast<std::string>();
+    });
     fs::create_directories(path.parent_path());
     std::ofstream file(path, std::ios::out | std::ios::trunc);
-    file << xml_string.cast<std::string>();
-  } catch (const py::error_already_set &e) {
+    file << xml_string;
+  } catch (const PythonError &e) {
     spdlog::error("Error saving Dic XML: {}", e.what());
     return false;
   }
@@ -91,31 +119,22 @@ bool wgrd_files::Dic::save_xml(fs::path path) {
 
 bool wgrd_files::Dic::save_bin(fs::path path) {
   spdlog::info("Saving Dic: {}", meta.vfs_path);
+  ScopedTrace trace("write dic", meta.vfs_path);
 
   try {
-    py::gil_scoped_acquire acquire;
-    py::dict py_dic_data;
-    py_dic_data["entries"] = py::list();
-    for (auto &[hash, str] : dic_data) {
-      py::bytes hash_bytes;
-      hash_bytes = hash_bytes.attr("fromhex")(py::str(hash));
-      py::dict entry;
-      entry["hash"] = hash_bytes;
-      entry["string"] = py::str(str);
-      py_dic_data["entries"].attr("append")(entry);
-    }
-
-    py::object dic = py::module::import("wgrd_cons_parsers.dic").attr("Dic");
-    py::tuple preprocessed_tuple = dic.attr("preprocess")(py_dic_data);
-    py::object preprocessed = preprocessed_tuple[0];
     fs::create_directories(path.parent_path());
-    dic.attr("build_file")(preprocessed, path.string());
-  } catch (const py::error_already_set &e) {
+    PythonExecutor::get_instance().run([this, &path]() {
+      py::dict py_dic_data = to_py_dic(dic_data);
+      py::object dic = py::module::import("wgrd_cons_parsers.dic").attr("Dic");
+      py::tuple preprocessed_tuple = dic.attr("preprocess")(py_dic_data);
+      py::object preprocessed = preprocessed_tuple[0];
+      dic.attr("build_file")(preprocessed, path.string());
+    });
+  } catch (const PythonError &e) {
     spdlog::error("Error saving Dic: {}", e.what());
     return false;
   }
 
-  m_is_changed = false;
   return true;
 }
 
@@ -142,6 +161,7 @@ void wgrd_files::Dic::render_window() {
         transactions.push_back(std::move(trans));
         transactions.back()->apply(dic_data);
         m_is_changed = true;
+        m_generation++;
       }
       ImGui::TableNextColumn();
       std::string value_str = str;
@@ -154,6 +174,7 @@ void wgrd_files::Dic::render_window() {
         transactions.push_back(std::move(trans));
         transactions.back()->apply(dic_data);
         m_is_changed = true;
+        m_generation++;
       }
       ImGui::TableNextColumn();
       ImGui::PopID();
@@ -161,20 +182,3 @@ void wgrd_files::Dic::render_window() {
     ImGui::EndTable();
   }
 }
-
-bool wgrd_files::Dic::is_file(const FileMeta &meta) {
-  auto stream_opt = open_file(meta.fs_path);
-  if (!stream_opt) {
-    return false;
-  }
-  auto &stream = stream_opt.value();
-  stream.seekg(meta.offset);
-
-  char magic[4];
-  stream.read(magic, sizeof(magic));
-
-  if (!strncmp(magic, "TRAD", 4)) {
-    return true;
-  }
-  return false;
-}
@@ -55,7 +55,6 @@ public:
   bool save_xml(fs::path path) override;
   bool save_bin(fs::path path) override;
   void render_window() override;
-  static bool is_file(const FileMeta &meta);
 };
 
 } // namespace wgrd_files
@@ -14,23 +14,6 @@ void wgrd_files::EDat::render_window() { workspace->render_window(); }
 
 void wgrd_files::EDat::render_extra() { workspace->render_extra(); }
 
-bool wgrd_files::EDat::is_file(const FileMeta &meta) {
-  auto stream_opt = open_file(meta.fs_path);
-  if (!stream_opt) {
-    return false;
-  }
-  auto &stream = stream_opt.value();
-  stream.seekg(meta.offset);
-
-  char magic[4];
-  stream.read(magic, sizeof(magic));
-
-  if (!strcmp(magic, "edat")) {
-    return true;
-  }
-  return false;
-}
-
 bool wgrd_files::EDat::load_bin(fs::path path) {
   workspace = std::make_unique<Workspace>();
   WorkspaceConfig config;
@@ -14,7 +14,6 @@ public:
   FileType get_type() override { return FileType::EDAT; }
   void render_window() override;
   void render_extra() override;
-  static bool is_file(const FileMeta &meta);
   bool is_parsed() override {
     if (!workspace) {
       return false;
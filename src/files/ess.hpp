@@ -15,7 +15,6 @@ public:
       : File(files, std::move(meta)) {}
   FileType get_type() override { return FileType::ESS; }
   void render_window() override;
-  static bool is_file(const FileMeta &meta);
   bool load_bin();
 };
 
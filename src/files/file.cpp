@@ -2,8 +2,11 @@
 
 #include "imgui.h"
 #include "imgui_stdlib.h"
+#include "mapped_file.hpp"
 #include "threadpool.hpp"
+#include "trace.hpp"
 #include <helpers.hpp>
+#include <zlib.h>
 
 #include "ImGuiFileDialog.h"
 
@@ -18,7 +21,7 @@ void wgrd_files::File::render_shortcuts() {
     start_parsing();
   }
   if (ImGui::Shortcut(ImGuiMod_Ctrl | ImGuiKey_S)) {
-    save_xml(xml_path);
+    save_snapshot();
   }
 }
 
@@ -27,11 +30,17 @@ void wgrd_files::File::render_menu() {
     if (ImGui::MenuItem(gettext("Rebuild"), gettext("Ctrl+R"))) {
       start_parsing();
     }
-    if (ImGui::MenuItem(gettext("Save XML"), gettext("Ctrl+S"))) {
+    if (ImGui::MenuItem(gettext("Save"), gettext("Ctrl+S"))) {
+      save_snapshot();
+    }
+    if (ImGui::MenuItem(gettext("Export XML"))) {
       save_xml(xml_path);
     }
+    if (ImGui::MenuItem(gettext("Import XML"))) {
+      import_xml();
+    }
     if (ImGui::MenuItem(gettext("Save Bin"))) {
-      save_bin(bin_path);
+      save_bin_cached();
     }
     if (ImGui::MenuItem(gettext("Save XML to..."))) {
     }
@@ -72,46 +81,116 @@ void wgrd_files::File::render_window() {
   }
 }
 
-std::vector<char> File::get_data() {
-  std::vector<char> ret;
-  ret.resize(meta.size);
+bool File::import_xml() {
+  ScopedTrace trace("import_xml", meta.vfs_path);
+  if (!load_xml(xml_path)) {
+    return false;
+  }
+  m_is_changed = true;
+  m_generation++;
+  return true;
+}
+
+namespace {
 
-  auto stream_opt = open_file(meta.fs_path);
-  if (!stream_opt) {
-    throw std::runtime_error("Failed to open file");
+std::optional<uint32_t> file_crc(const fs::path &path) {
+  std::error_code ec;
+  auto size = fs::file_size(path, ec);
+  if (ec) {
+    return std::nullopt;
+  }
+  uLong crc = crc32(0L, nullptr, 0);
+  // empty files can't be mapped
+  if (size == 0) {
+    return crc;
+  }
+  MappedFile file;
+  if (!file.open(path)) {
+    return std::nullopt;
   }
-  auto &stream = stream_opt.value();
-  stream.seekg(meta.offset);
+  return crc32(crc, reinterpret_cast<const Bytef *>(file.data()),
+               file.size());
+}
 
-  stream.read(ret.data(), meta.size);
+} // namespace
 
-  return std::move(ret);
+bool File::save_bin_cached() {
+  uint64_t generation = get_generation();
+  if (m_bin_cache && m_bin_cache->generation == generation &&
+      file_crc(bin_path) == m_bin_cache->crc) {
+    spdlog::debug("Reusing binary of {} at {}", meta.vfs_path,
+                  bin_path.string());
+    return true;
+  }
+  m_bin_cache.reset();
+  ScopedTrace trace("save_bin", meta.vfs_path);
+  if (!save_bin(bin_path)) {
+    return false;
+  }
+  auto crc = file_crc(bin_path);
+  if (crc) {
+    m_bin_cache = BinCache{generation, crc.value()};
+  }
+  return true;
+}
+
+DatView File::get_data() {
+  auto view =
+      files->get_dat_pool().get_view(meta.fs_path, meta.offset, meta.size);
+  if (!view) {
+    throw std::runtime_error("Failed to open file");
+  }
+  return std::move(view.value());
 }
 
-void File::start_parsing(bool try_xml) {
+bool File::prepare_parsing() {
   if (is_parsing()) {
     spdlog::error("Already parsing {}", meta.vfs_path);
-    return;
+    return false;
   }
   m_is_parsing = true;
   m_is_parsed = false;
 
   m_parsed_promise = std::promise<bool>();
   m_parsed_future = m_parsed_promise->get_future();
+  return true;
+}
 
-  ThreadPoolSingleton::get_instance().submit([this, try_xml]() {
-    bool ret = false;
-    if (try_xml) {
-      ret = load_xml(xml_path);
+bool File::parse(bool try_cache) {
+  ScopedTrace trace("parse", meta.vfs_path);
+  bool ret = false;
+  try {
+    unload();
+    if (try_cache) {
+      ScopedTrace trace("load_snapshot", meta.vfs_path);
+      ret = load_snapshot();
     }
     if (!ret) {
-      ret = load_stream();
+      {
+        ScopedTrace trace("load_stream", meta.vfs_path);
+        ret = load_stream();
+      }
       if (ret) {
-        save_xml(xml_path);
+        ScopedTrace trace("save_snapshot", meta.vfs_path);
+        save_snapshot();
       }
     }
-    m_parsed_promise->set_value(ret);
-  });
+  } catch (const std::exception &e) {
+    spdlog::error("Failed to parse {}: {}", meta.vfs_path, e.what());
+    ret = false;
+  }
+  m_generation++;
+  m_parsed_promise->set_value(ret);
+  return ret;
+}
+
+void File::start_parsing(bool try_cache, TaskPriority priority) {
+  if (!prepare_parsing()) {
+    return;
+  }
+
+  ThreadPoolSingleton::get_instance().submit(
+      priority, [this, try_cache]() { parse(try_cache); });
 }
 
 bool File::copy_to_file(std::filesystem::path path) {
@@ -124,25 +203,13 @@ bool File::copy_to_file(std::filesystem::path path) {
   }
   auto &of = of_opt.value();
 
-  auto stream_opt = open_file(meta.fs_path);
-  if (!stream_opt) {
+  auto view =
+      files->get_dat_pool().get_view(meta.fs_path, meta.offset, meta.size);
+  if (!view) {
     return false;
   }
-  auto &stream = stream_opt.value();
-
-  stream.seekg(meta.offset);
-  size_t end = meta.offset + meta.size;
-
-  while (!stream.eof() && stream.tellg() < end) {
-    char buffer[1024];
-    size_t count = std::min(sizeof(buffer), end - stream.tellg());
-    stream.read(buffer, count);
-    of.write(buffer, count);
-  }
+  // the entry is already mapped, so it can be written in one go
+  of.write(view->data(), view->size());
 
-  if (stream.tellg() < end) {
-    return false;
-  }
-
-  return true;
+  return of.good();
 }
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "files/files.hpp"
+#include "task_scheduler.hpp"
 
 namespace wgrd_files {
 
@@ -23,16 +24,29 @@ protected:
   fs::path tmp_path;
   // path to the binary output file of this file
   fs::path bin_path;
-  // path to the xml file describing this file
-  // (may not exist, will be created if it doesn't exist yet on parsing or
-  // save_xml call)
+  // path to the xml file describing this file, only written and read on
+  // explicit export and import (may not exist)
   fs::path xml_path;
+  // path to the binary snapshot of the parsed file, restored on warm starts
+  // instead of parsing the file again
+  fs::path snapshot_path;
   // FIXME: maybe we should just create a transaction list here instead
   // of having different transaction lists that mark this flag themselves
   bool m_is_changed = false;
+  // bumped whenever the content of the file changes, see get_generation.
+  // bumped by the ui thread and read by save_bin_cached on the pool.
+  std::atomic_uint64_t m_generation = 0;
 
   friend class Files;
 
+private:
+  // the binary last written to bin_path by save_bin_cached
+  struct BinCache {
+    uint64_t generation;
+    uint32_t crc;
+  };
+  std::optional<BinCache> m_bin_cache;
+
 public:
   explicit File(const Files *files, FileMeta meta);
   virtual FileType get_type() { return FileType::UNKNOWN; }
@@ -46,13 +60,29 @@ public:
   // this function is called *outside* the window (e.g. ndfbin uses this to
   // spawn new object windows)
   virtual void render_extra() {};
-  // this function returns the bytes stored in the given filestream
-  std::vector<char> get_data();
-  // this function just plainly copies from the given filestream to the given
+  // this function returns a view of the bytes stored in the dat file, the view
+  // keeps the mapping of the dat file alive
+  DatView get_data();
+  // this function just plainly copies the bytes from the dat file to the given
   // path
   bool copy_to_file(fs::path path);
 
-  void start_parsing(bool try_xml = true);
+  const FileMeta &get_meta() const { return meta; }
+
+  // parses on the scheduler, by default ahead of all background work since
+  // the user usually waits for the file
+  void start_parsing(bool try_cache = true,
+                     TaskPriority priority = TaskPriority::INTERACTIVE);
+  // marks the file as parsing, returns false if it is already parsing.
+  // needs to be called before parse.
+  bool prepare_parsing();
+  // parses the file in the calling thread and fulfills the parsed promise.
+  // if try_cache is set, the file is restored with load_snapshot if possible
+  bool parse(bool try_cache = true);
+
+  // drops what the file published to the workspace, e.g. the imports of a
+  // ndfbin. called before the file is (re)loaded.
+  virtual void unload() {}
 
   // default implementation, may be overridden
   virtual bool load_stream() {
@@ -70,6 +100,12 @@ public:
                   meta.vfs_path, path.string());
     return false;
   }
+  // restores the file from the fastest format it was saved in, defaults to
+  // the xml
+  virtual bool load_snapshot() { return load_xml(xml_path); }
+  virtual bool save_snapshot() { return save_xml(xml_path); }
+  // loads the edits from xml_path, the file is changed afterwards
+  bool import_xml();
   virtual bool load_bin(fs::path path) {
     spdlog::error("NOT IMPLEMENTED cannot save bin file {} into {}",
                   meta.vfs_path, path.string());
@@ -80,6 +116,13 @@ public:
                   meta.vfs_path, path.string());
     return false;
   }
+  // saves the binary to bin_path, unless the file didn't change since the
+  // last call and bin_path still holds what that call wrote
+  bool save_bin_cached();
+  const fs::path &get_bin_path() const { return bin_path; }
+  const fs::path &get_xml_path() const { return xml_path; }
+  // changes whenever the content of the file changes
+  virtual uint64_t get_generation() const { return m_generation; }
 
   virtual bool undo() {
     spdlog::error("NOT IMPLEMENTED cannot undo {}", meta.vfs_path);
@@ -0,0 +1,82 @@
+#include "file_type.hpp"
+
+#include "helpers.hpp"
+
+#include <array>
+#include <cstring>
+
+using namespace wgrd_files;
+
+namespace {
+
+struct FileTypeMagic {
+  size_t offset;
+  std::string_view magic;
+};
+
+struct FileTypeEntry {
+  FileType type;
+  // empty if the extension does not matter
+  std::string_view extension;
+  // all magics need to match, empty magics are ignored
+  std::array<FileTypeMagic, 2> magics;
+};
+
+using namespace std::string_view_literals;
+
+// checked in order, the first matching entry wins
+constexpr std::array file_type_table = {
+    FileTypeEntry{FileType::DIC, "", {{{0, "TRAD"}}}},
+    FileTypeEntry{FileType::EDAT, "", {{{0, "edat"}}}},
+    FileTypeEntry{FileType::ESS, "", {{{0, "\x01\x00\x02\x02"sv}}}},
+    FileTypeEntry{FileType::SFORMAT, ".sformat", {}},
+    FileTypeEntry{FileType::TGV, ".tgv", {{{0, "\x02\x00\x00\x00"sv}}}},
+    FileTypeEntry{FileType::PPK, ".ppk", {{{0, "PRXYPCPC"}}}},
+    FileTypeEntry{FileType::SCENARIO, "", {{{0, "SCENARIO"}}}},
+    FileTypeEntry{FileType::NDFBIN, "", {{{0, "EUG0"}, {8, "CNDF"}}}},
+};
+
+bool matches(const FileTypeEntry &entry, std::string_view vfs_path,
+             std::span<const char> header) {
+  if (!entry.extension.empty() && !vfs_path.ends_with(entry.extension)) {
+    return false;
+  }
+  for (auto &[offset, magic] : entry.magics) {
+    if (magic.empty()) {
+      continue;
+    }
+    if (header.size() < offset + magic.size()) {
+      return false;
+    }
+    if (std::memcmp(header.data() + offset, magic.data(), magic.size())) {
+      return false;
+    }
+  }
+  return true;
+}
+
+} // namespace
+
+FileType wgrd_files::detect_file_type(std::string_view vfs_path,
+                                      std::span<const char> header) {
+  for (auto &entry : file_type_table) {
+    if (matches(entry, vfs_path, header)) {
+      return entry.type;
+    }
+  }
+  return FileType::UNKNOWN;
+}
+
+FileType wgrd_files::detect_file_type(const FileMeta &meta) {
+  char header[file_type_header_size];
+  size_t count = std::min(meta.size, sizeof(header));
+  auto stream_opt = open_file(meta.fs_path);
+  if (!stream_opt) {
+    return FileType::UNKNOWN;
+  }
+  auto &stream = stream_opt.value();
+  stream.seekg(meta.offset);
+  stream.read(header, count);
+  return detect_file_type(meta.vfs_path,
+                          std::span<const char>(header, stream.gcount()));
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <span>
+#include <string_view>
+
+#include "files/configs.hpp"
+
+#include "file_tree.hpp"
+
+namespace wgrd_files {
+
+// number of bytes of a file needed to detect its type
+constexpr size_t file_type_header_size = 16;
+
+// detects the type from the vfs path and the first bytes of the file
+FileType detect_file_type(std::string_view vfs_path,
+                          std::span<const char> header);
+// reads the first bytes of the file from the dat file, only used if the file
+// tree did not already detect the type
+FileType detect_file_type(const FileMeta &meta);
+
+} // namespace wgrd_files
@@ -11,6 +11,7 @@
 #include <libintl.h>
 
 #include "helpers.hpp"
+#include "trace.hpp"
 
 #include <filesystem>
 
@@ -18,8 +19,10 @@
 #include "files/dic.hpp"
 #include "files/edat.hpp"
 #include "files/ess.hpp"
+#include "files/file_type.hpp"
 #include "files/ndfbin.hpp"
 #include "files/ppk.hpp"
+#include "files/save_job.hpp"
 #include "files/scenario.hpp"
 #include "files/sformat.hpp"
 #include "files/tgv.hpp"
@@ -37,6 +40,9 @@ void wgrd_files::Files::render_menu(const std::unique_ptr<File> &file) {
 }
 
 void wgrd_files::Files::render() {
+  // the files are read by the save job, so they must not be edited meanwhile
+  bool saving = is_saving();
+  ImGui::BeginDisabled(saving);
   for (auto &[vfs_path, p_open] : open_file_windows) {
     if (!p_open) {
       continue;
@@ -51,7 +57,9 @@ void wgrd_files::Files::render() {
     auto &file = file_list[idx];
     if (ImGui::Begin(file->meta.vfs_path.c_str(), &p_open,
                      ImGuiWindowFlags_MenuBar)) {
-      file->render_shortcuts();
+      if (!saving) {
+        file->render_shortcuts();
+      }
       render_menu(file);
       file->check_parsing();
       if (!file->is_parsed()) {
@@ -70,16 +78,17 @@ void wgrd_files::Files::render() {
       file->render_extra();
     }
   }
+  ImGui::EndDisabled();
 }
 
 void wgrd_files::Files::open_window(std::string vfs_path) {
   open_file_windows[vfs_path] = true;
 }
 
-void wgrd_files::Files::add_file(FileMetaList file_metas) {
+File *Files::add_file(FileMetaList file_metas, bool start_parsing) {
   if (file_metas.size() == 0) {
     spdlog::debug("Files::add_file called with empty file_metas");
-    return;
+    return nullptr;
   }
   std::string vfs_path = file_metas[0].vfs_path;
   for (auto &meta : file_metas) {
@@ -87,7 +96,7 @@ void wgrd_files::Files::add_file(FileMetaList file_metas) {
   }
   if (files.contains(vfs_path)) {
     spdlog::debug("Files::add_file vfs_path {} already exists", vfs_path);
-    return;
+    return get_file(vfs_path);
   }
 
   FileList file_list;
@@ -97,28 +106,41 @@ void wgrd_files::Files::add_file(FileMetaList file_metas) {
 
     std::unique_ptr<File> file;
     fs::path vfs_path = remove_dollar(meta.vfs_path);
-    if (Dic::is_file(meta)) {
+    // the file tree usually already detected the type while parsing the dat
+    FileType type = meta.type ? meta.type.value() : detect_file_type(meta);
+    switch (type) {
+    case FileType::DIC:
       file = std::make_unique<Dic>(this, std::move(meta));
-    } else if (EDat::is_file(meta)) {
+      break;
+    case FileType::EDAT:
       file = std::make_unique<EDat>(this, std::move(meta));
-    } else if (Ess::is_file(meta)) {
+      break;
+    case FileType::ESS:
       file = std::make_unique<Ess>(this, std::move(meta));
-    } else if (SFormat::is_file(meta)) {
+      break;
+    case FileType::SFORMAT:
       file = std::make_unique<SFormat>(this, std::move(meta));
-    } else if (TGV::is_file(meta)) {
+      break;
+    case FileType::TGV:
       file = std::make_unique<TGV>(this, std::move(meta));
-    } else if (PPK::is_file(meta)) {
+      break;
+    case FileType::PPK:
       file = std::make_unique<PPK>(this, std::move(meta));
-    } else if (Scenario::is_file(meta)) {
+      break;
+    case FileType::SCENARIO:
       file = std::make_unique<Scenario>(this, std::move(meta));
-    } else if (NdfBin::is_file(meta)) {
+      break;
+    case FileType::NDFBIN:
       file = std::make_unique<NdfBin>(this, std::move(meta));
-    } else {
+      break;
+    default:
       file = std::make_unique<File>(this, std::move(meta));
+      break;
     }
     file->db_path = m_config.db_path;
     file->bin_path = m_config.bin_path / vfs_path;
     file->tmp_path = m_config.tmp_path / vfs_path;
+    file->snapshot_path = fs::path(file->bin_path) += ".snapshot";
     std::string new_ext = vfs_path.extension().string() + ".xml";
     file->xml_path = m_config.xml_path / vfs_path.replace_extension(new_ext);
     std::string file_type =
@@ -127,112 +149,60 @@ void wgrd_files::Files::add_file(FileMetaList file_metas) {
                   vfs_path.string(), file_type);
     file_list.push_back(std::move(file));
   }
-  file_list.back()->start_parsing();
+  File *ret = file_list.back().get();
+  if (start_parsing) {
+    ret->start_parsing();
+  }
   size_t len = file_list.size() - 1;
   files.insert({vfs_path, {std::move(file_list), len}});
+  return ret;
 }
 
-void wgrd_files::Files::copy_bin_changes(fs::path fs_path,
-                                         fs::path out_folder_path) {
-  for (auto &[vfs_path, files_idx] : files) {
-    auto &[file_list, idx] = files_idx;
-    auto &file = file_list[idx];
-    if (file->is_changed()) {
-      if (file->meta.fs_path == fs_path) {
-        // vfs_path contains $/ at the beginning, drop it
-        fs::path bin_path =
-            out_folder_path / remove_dollar(file->meta.vfs_path);
-        spdlog::info("Saving binary for {} to {}", file->meta.vfs_path,
-                     bin_path.string());
-        file->save_bin(bin_path);
-      }
-    }
+std::shared_future<bool>
+wgrd_files::Files::save_changes_to_dat(bool save_to_fs_path) {
+  if (is_saving()) {
+    spdlog::warn("Already saving the dat files of {}",
+                 m_config.fs_path.string());
+    return m_save_job->get_future();
   }
-}
-
-void wgrd_files::Files::save_changes_to_dat(bool save_to_fs_path) {
   fs::path parent_out_path = m_config.dat_path;
   if (save_to_fs_path) {
     parent_out_path = m_config.fs_path.parent_path();
   }
 
-  spdlog::info("Saving changes to dat files with tmp_path {}",
-               m_config.tmp_path.string());
-  // get all changed dat files
-  std::unordered_set<std::string> changed_files_paths;
+  spdlog::info("Saving changes to dat files of {}",
+               m_config.fs_path.string());
+  ScopedTrace trace("save_changes_to_dat", m_config.fs_path.string());
+  // get all changed files, grouped by their dat file
+  std::vector<std::pair<fs::path, fs::path>> dat_paths;
+  std::unordered_map<std::string, size_t> dat_indices;
+  std::vector<std::pair<File *, size_t>> changed_files;
   for (const auto &[_, files_idx] : files) {
     const auto &[file_list, idx] = files_idx;
     const auto &file = file_list[idx];
-    if (file->is_changed()) {
-      changed_files_paths.insert(file->meta.fs_path.string());
-    }
-  }
-  // iterate all changed dat files in this workspace
-  for (const auto &fs_path_str : changed_files_paths) {
-    fs::path fs_path = fs_path_str;
-    fs::path part_path = fs::relative(fs_path, m_config.fs_path);
-    fs::path out_path = parent_out_path / part_path.parent_path();
-    if (save_to_fs_path) {
-      assert(out_path == fs_path.parent_path());
-    }
-    fs::create_directories(out_path);
-
-    // unpack dat file to tmp directory
-    fs::create_directories(m_config.tmp_path);
-
-    spdlog::info("Saving changes in {} to {}", m_config.fs_path.string(),
-                 out_path.string());
-    {
-      py::gil_scoped_acquire acquire;
-      try {
-        py::object edat = py::module::import("wgrd_cons_parsers")
-                              .attr("edat")
-                              .attr("EdatMain")();
-        // as the EdatMain uses the . instead of [] for accessing, we need the
-        // dingsda Container
-        py::object container =
-            py::module::import("dingsda.lib.containers").attr("Container");
-        py::dict args = py::dict();
-        args["no_alignment"] = true;
-        args["disable_checksums"] = true;
-        edat.attr("args") = container(args);
-        py::object data = edat.attr("get_data")(m_config.fs_path.string());
-        edat.attr("unpack")(m_config.fs_path.string(),
-                            m_config.tmp_path.string(), data);
-      } catch (const py::error_already_set &e) {
-        spdlog::error(e.what());
-      }
+    if (!file->is_changed()) {
+      continue;
     }
-
-    copy_bin_changes(m_config.fs_path.string(), m_config.tmp_path / "out");
-
-    // since now all changed binary files are in the directory, rebuild the dat
-    // file
-    {
-      py::gil_scoped_acquire acquire;
-      try {
-        py::object edat = py::module::import("wgrd_cons_parsers")
-                              .attr("edat")
-                              .attr("EdatMain")();
-        py::object container =
-            py::module::import("dingsda.lib.containers").attr("Container");
-        py::dict args = py::dict();
-        args["no_alignment"] = true;
-        args["disable_checksums"] = true;
-        edat.attr("args") = container(args);
-        fs::path gen_xml_path =
-            m_config.tmp_path /
-            m_config.fs_path.filename().replace_extension(".dat.xml");
-        py::object data = edat.attr("get_data")(gen_xml_path.string());
-        edat.attr("pack")(gen_xml_path.string(), out_path.string(), data);
-      } catch (const py::error_already_set &e) {
-        spdlog::error(e.what());
+    const fs::path &fs_path = file->meta.fs_path;
+    auto [it, inserted] =
+        dat_indices.try_emplace(fs_path.string(), dat_paths.size());
+    if (inserted) {
+      fs::path part_path = fs::relative(fs_path, m_config.fs_path);
+      fs::path out_path = parent_out_path / part_path.parent_path();
+      if (save_to_fs_path) {
+        assert(out_path == fs_path.parent_path());
       }
+      fs::create_directories(out_path);
+      dat_paths.emplace_back(fs_path, out_path);
     }
-
-    // remove the tmp directory
-    fs::remove_all(m_config.tmp_path);
+    changed_files.emplace_back(file.get(), it->second);
   }
+  m_save_job = std::make_shared<SaveJob>(m_dat_pool, dat_paths, changed_files);
+  return m_save_job->start();
+}
+
+bool wgrd_files::Files::is_saving() const {
+  return m_save_job && !m_save_job->is_done();
 }
 
 File *Files::get_file(std::string vfs_path) const {
@@ -19,6 +19,9 @@ namespace py = pybind11;
 
 #include "configs.hpp"
 
+#include "dat_pool.hpp"
+#include "reference_index.hpp"
+
 #include "file_tree.hpp"
 
 #include "toml.hpp"
@@ -26,6 +29,7 @@ namespace py = pybind11;
 namespace wgrd_files {
 
 class File;
+class SaveJob;
 typedef std::vector<std::unique_ptr<File>> FileList;
 
 class Files {
@@ -37,14 +41,30 @@ private:
 
   const WorkspaceConfig &m_config;
 
+  // mutable, since the files only hold a const pointer to this and the pool
+  // is thread safe
+  mutable DatPool m_dat_pool;
+  // imports of all loaded ndfbins, same reasoning as for the pool
+  mutable ReferenceIndex m_reference_index;
+
+  std::shared_ptr<SaveJob> m_save_job;
+
 public:
   explicit Files(const WorkspaceConfig &config) : m_config(config) {}
+  DatPool &get_dat_pool() const { return m_dat_pool; }
+  ReferenceIndex &get_reference_index() const { return m_reference_index; }
+  const WorkspaceConfig &get_config() const { return m_config; }
   void render_menu(const std::unique_ptr<File> &file);
   void render();
-  void add_file(FileMetaList file_metas);
+  // returns the current version of the file, nullptr if file_metas is empty
+  File *add_file(FileMetaList file_metas, bool start_parsing = true);
   void open_window(std::string vfs_path);
-  void copy_bin_changes(fs::path dat_path, fs::path out_folder_path);
-  void save_changes_to_dat(bool save_to_fs_path);
+  // starts saving all changed dat files in the background. The future is
+  // true once all of them are written successfully.
+  std::shared_future<bool> save_changes_to_dat(bool save_to_fs_path);
+  bool is_saving() const;
+  // the last started save, nullptr if nothing was saved yet
+  const std::shared_ptr<SaveJob> &get_save_job() const { return m_save_job; }
   File *get_file(std::string vfs_path) const;
   std::vector<std::string> get_files_of_type(FileType type) const;
   bool is_changed();
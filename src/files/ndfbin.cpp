@@ -8,10 +8,33 @@ using namespace wgrd_files;
 #include "misc/cpp/imgui_stdlib.h"
 
 #include "magic_enum.hpp"
+#include "trace.hpp"
+#include "vfs_cache.hpp"
 
 #include <random>
 
+const std::string &wgrd_files::NdfBin::get_row_label(Symbol object_name) {
+  if (row_labels.size() <= object_name) {
+    row_labels.resize(ndfbin.get_symbols().size());
+  }
+  auto &label = row_labels[object_name];
+  if (label.empty()) {
+    // a row of an object removed this frame is left empty, the id keeps it
+    // apart from other such rows. The label is reset when the object comes
+    // back.
+    if (!ndfbin.contains_object(object_name)) {
+      label = std::format("##{}", object_name);
+      return label;
+    }
+    const auto &object = ndfbin.get_object(object_name);
+    label = std::format("{} - {} - {}", object.name, object.class_name,
+                        object.export_path);
+  }
+  return label;
+}
+
 void wgrd_files::NdfBin::render_object_list() {
+  object_list_timer.begin();
   if (ImGui::BeginTable("filters", 2,
                         ImGuiTableFlags_RowBg | ImGuiTableFlags_Borders)) {
     ImGui::TableSetupColumn(gettext("Filter"),
@@ -48,27 +71,40 @@ void wgrd_files::NdfBin::render_object_list() {
     filter_changed = true;
   }
   if (filter_changed) {
-    // filter objects
-    object_list_filtered.clear();
-    for (auto &object_name :
-         ndfbin.filter_objects(object_filter_lower, class_filter_lower)) {
-      object_list_filtered.push_back(object_name);
+    // filter objects, without filters the list is in the order of the file
+    if (object_filter.empty() && class_filter.empty()) {
+      object_search->cancel();
+      object_list_filtered = ndfbin.get_object_names();
+    } else {
+      // supersedes the query of the previous keystroke
+      object_search->start_query(object_filter_lower, class_filter_lower);
     }
     // filter classes
     class_list_filtered.clear();
-    if (!class_filter.empty()) {
-      for (auto &[class_name, _] : class_list) {
-        if (str_tolower(class_name).contains(class_filter_lower)) {
-          class_list_filtered.push_back(class_name);
-        }
+    for (auto &[class_name, _] : class_list) {
+      if (class_filter.empty() ||
+          str_tolower(std::string(ndfbin.get_symbols().str(class_name)))
+              .contains(class_filter_lower)) {
+        class_list_filtered.push_back(class_name);
       }
-    } else {
-      auto class_list_it = class_list | std::views::keys;
-      class_list_filtered =
-          std::vector<std::string>(class_list_it.begin(), class_list_it.end());
     }
+    std::sort(class_list_filtered.begin(), class_list_filtered.end(),
+              [this](Symbol a, Symbol b) {
+                return ndfbin.get_symbols().str(a) <
+                       ndfbin.get_symbols().str(b);
+              });
     filter_changed = false;
   }
+  if (auto result = object_search->take_result()) {
+    object_list_filtered = std::move(result.value());
+    // the query may have started before objects were removed or renamed
+    std::erase_if(object_list_filtered, [this](Symbol object_name) {
+      return !ndfbin.contains_object(object_name);
+    });
+  }
+  if (object_search->is_pending()) {
+    ImGui::TextDisabled(gettext("Filtering..."));
+  }
 
   if (item_current_idx >= object_list_filtered.size()) {
     item_current_idx = -1;
@@ -82,16 +118,11 @@ void wgrd_files::NdfBin::render_object_list() {
 
     while (clipper.Step()) {
       for (int it = clipper.DisplayStart; it < clipper.DisplayEnd; it++) {
-        const auto &object = ndfbin.get_object(object_list_filtered[it]);
-
         const bool is_selected = (item_current_idx == it);
-        if (ImGui::Selectable(std::format("{} - {} - {}", object.name,
-                                          object.class_name, object.export_path)
-                                  .c_str(),
+        if (ImGui::Selectable(get_row_label(object_list_filtered[it]).c_str(),
                               is_selected)) {
           item_current_idx = it;
-          std::string object_name = object_list_filtered[item_current_idx];
-          open_window(object_name);
+          open_window(object_list_filtered[item_current_idx]);
         }
 
         // Set the initial focus when opening the combo (scrolling + keyboard
@@ -103,76 +134,241 @@ void wgrd_files::NdfBin::render_object_list() {
     }
     ImGui::EndListBox();
   }
+  object_list_timer.end();
+  object_list_timer.render(gettext("Object list"));
 }
 
 void wgrd_files::NdfBin::fill_class_list() {
+  ScopedTrace trace("fill_class_list", meta.vfs_path);
   class_list.clear();
+  indexed_objects.clear();
+  indexed_objects.reserve(ndfbin.get_object_count());
   object_references.clear();
   object_references.reserve(ndfbin.get_object_count());
   import_references.clear();
   import_references.reserve(ndfbin.get_object_count());
-  std::unordered_set<std::string> export_paths;
-  export_paths.reserve(ndfbin.get_object_count());
-  for (auto &object_name : ndfbin.filter_objects("", "")) {
-    auto &object = ndfbin.get_object(object_name);
-    export_paths.insert(object.export_path);
+  object_search->clear();
+  row_labels.clear();
+  pending_reindex.clear();
+  // the changes are already contained in the new indexes
+  ndfbin.take_changes();
+  for (Symbol object_name : ndfbin.get_object_names()) {
+    index_object(object_name);
+  }
 
-    auto class_it = class_list.find(object.class_name);
-    if (class_it == class_list.end()) {
-      class_list.emplace(object.class_name, Class());
-      class_it = class_list.find(object.class_name);
+  // the imports of other files are only published by those files
+  changed_imports.clear();
+  std::unordered_map<std::string, std::unordered_set<std::string>> imports;
+  for (auto &[export_path, object_names] : import_references) {
+    auto &names = imports[std::string(ndfbin.get_symbols().str(export_path))];
+    for (Symbol object_name : object_names) {
+      names.emplace(ndfbin.get_symbols().str(object_name));
     }
+  }
+  files->get_reference_index().set_file_imports(meta.vfs_path, imports);
+}
 
-    class_it->second.objects.push_back(object_name);
-    for (auto &property : object.properties) {
-      {
-        auto refs = property->get_object_references();
-        for (auto &ref : refs) {
-          if (!object_references.contains(ref)) {
-            object_references.emplace(ref, std::unordered_set<std::string>());
-          }
-          object_references[ref].insert(object_name);
+void wgrd_files::NdfBin::index_object(Symbol object_name, bool update_class) {
+  auto &object = ndfbin.get_object(object_name);
+  IndexedObject indexed;
+  indexed.class_name = ndfbin.intern(object.class_name);
+
+  auto &class_ = class_list[indexed.class_name];
+  if (update_class) {
+    class_.objects.push_back(object_name);
+    object_search->add_object(object_name, object.name, indexed.class_name,
+                              object.class_name);
+  }
+  // only entries that were actually inserted are recorded, so removing them
+  // again never touches an entry twice
+  auto digest = ndfbin.get_digest(object_name);
+  for (Symbol ref_name : digest.object_references) {
+    if (object_references[ref_name].insert(object_name).second) {
+      indexed.object_references.push_back(ref_name);
+    }
+  }
+  for (Symbol ref_name : digest.import_references) {
+    if (import_references[ref_name].insert(object_name).second) {
+      indexed.import_references.push_back(ref_name);
+      changed_imports.insert(ref_name);
+    }
+  }
+  for (auto &property : digest.properties) {
+    auto &values = class_.properties[property.property_name].values;
+    auto value = digest.value(property);
+    auto value_it = values.find(value);
+    if (value_it == values.end()) {
+      value_it = values.try_emplace(std::string(value)).first;
+    }
+    if (value_it->second.insert(object_name).second) {
+      indexed.values.emplace_back(property.property_name, value_it);
+    }
+  }
+  indexed_objects.insert_or_assign(object_name, std::move(indexed));
+}
+
+void wgrd_files::NdfBin::unindex_object(Symbol object_name,
+                                        bool update_class) {
+  auto it = indexed_objects.find(object_name);
+  if (it == indexed_objects.end()) {
+    return;
+  }
+  auto &indexed = it->second;
+
+  auto class_it = class_list.find(indexed.class_name);
+  if (class_it != class_list.end()) {
+    auto &class_ = class_it->second;
+    for (auto &[property_name, value_it] : indexed.values) {
+      value_it->second.erase(object_name);
+      if (value_it->second.empty()) {
+        class_.properties.at(property_name).values.erase(value_it);
+      }
+    }
+    if (update_class) {
+      std::erase(class_.objects, object_name);
+      object_search->remove_object(object_name);
+      if (class_.objects.empty()) {
+        class_list.erase(class_it);
+        filter_changed = true;
+      }
+    }
+  }
+
+  auto remove_reference = [object_name](auto &references, Symbol ref_name) {
+    auto ref_it = references.find(ref_name);
+    if (ref_it == references.end()) {
+      return;
+    }
+    ref_it->second.erase(object_name);
+    if (ref_it->second.empty()) {
+      references.erase(ref_it);
+    }
+  };
+  for (Symbol ref_name : indexed.object_references) {
+    remove_reference(object_references, ref_name);
+  }
+  for (Symbol ref_name : indexed.import_references) {
+    remove_reference(import_references, ref_name);
+    changed_imports.insert(ref_name);
+  }
+  indexed_objects.erase(it);
+}
+
+void wgrd_files::NdfBin::reindex_object(Symbol object_name) {
+  // the class of an object can not change, so its position in the class
+  // object list is kept
+  unindex_object(object_name, false);
+  index_object(object_name, false);
+}
+
+void wgrd_files::NdfBin::apply_index_changes() {
+  auto changes = ndfbin.take_changes();
+  for (auto &change : changes) {
+    // the label shows name, class and export path, so any change of the
+    // object invalidates it
+    for (auto *name : {&change.object_name, &change.new_name}) {
+      auto symbol = ndfbin.get_symbols().find(*name);
+      if (symbol && symbol.value() < row_labels.size()) {
+        row_labels[symbol.value()].clear();
+      }
+    }
+  }
+  for (size_t i = 0; i < changes.size(); i++) {
+    auto &change = changes[i];
+    Symbol object_name = ndfbin.intern(change.object_name);
+    switch (change.kind) {
+    case NdfChange::Kind::ADD_OBJECT: {
+      unindex_object(object_name);
+      if (ndfbin.contains_object(object_name)) {
+        index_object(object_name);
+      }
+      filter_changed = true;
+      break;
+    }
+    case NdfChange::Kind::REMOVE_OBJECT: {
+      unindex_object(object_name);
+      std::erase(object_list_filtered, object_name);
+      filter_changed = true;
+      break;
+    }
+    case NdfChange::Kind::RENAME_OBJECT: {
+      // renames of a bulk rename are handled together, since the names can
+      // be swapped between the objects
+      size_t end = i;
+      while (end < changes.size() &&
+             changes[end].kind == NdfChange::Kind::RENAME_OBJECT) {
+        end++;
+      }
+      // objects referencing the old names got their references renamed
+      std::unordered_set<Symbol> referencing;
+      std::vector<Symbol> new_names;
+      for (size_t j = i; j < end; j++) {
+        Symbol old_name = ndfbin.intern(changes[j].object_name);
+        auto ref_it = object_references.find(old_name);
+        if (ref_it != object_references.end()) {
+          referencing.insert(ref_it->second.begin(), ref_it->second.end());
         }
+        unindex_object(old_name);
+        std::erase(object_list_filtered, old_name);
+        new_names.push_back(ndfbin.intern(changes[j].new_name));
       }
-      {
-        auto refs = property->get_import_references();
-        for (auto &ref : refs) {
-          if (!import_references.contains(ref)) {
-            import_references.emplace(ref, std::unordered_set<std::string>());
-          }
-          import_references[ref].insert(object_name);
+      for (Symbol new_name : new_names) {
+        referencing.erase(new_name);
+        unindex_object(new_name);
+        if (ndfbin.contains_object(new_name)) {
+          index_object(new_name);
         }
       }
-
-      auto prop_it = class_it->second.properties.find(property->property_name);
-      if (prop_it == class_it->second.properties.end()) {
-        class_it->second.properties.emplace(property->property_name,
-                                            Property());
-        prop_it = class_it->second.properties.find(property->property_name);
+      for (Symbol ref_name : referencing) {
+        if (indexed_objects.contains(ref_name) &&
+            ndfbin.contains_object(ref_name)) {
+          reindex_object(ref_name);
+        }
       }
-      prop_it->second.values[property->as_string()].insert(object_name);
+      filter_changed = true;
+      i = end - 1;
+      break;
+    }
+    case NdfChange::Kind::CHANGE_OBJECT: {
+      pending_reindex.insert(object_name);
+      break;
+    }
     }
   }
 
-  // auto ndfbin_files = files->get_files_of_type(FileType::NDFBIN);
-  // for (std::string vfs_path : ndfbin_files) {
-  //   NdfBin *ndfbin = (NdfBin *)files->get_file(vfs_path);
-  //   if (!ndfbin) {
-  //     spdlog::warn("got invalid ndfbin file?");
-  //     continue;
-  //   }
+  // dragging a value changes the object every frame, so it is only
+  // reindexed once the drag ends
+  if (!ImGui::IsAnyItemActive()) {
+    for (Symbol object_name : pending_reindex) {
+      if (ndfbin.contains_object(object_name)) {
+        reindex_object(object_name);
+      }
+    }
+    pending_reindex.clear();
+  }
+  publish_imports();
+}
 
-  //  for (auto &[export_path, object_names] :
-  //       ndfbin->get_import_references(export_paths)) {
-  //    export_references.insert(
-  //        {export_path, std::make_pair(vfs_path, object_names)});
-  //  }
-  //}
+void wgrd_files::NdfBin::publish_imports() {
+  auto &index = files->get_reference_index();
+  for (Symbol export_path : changed_imports) {
+    std::unordered_set<std::string> object_names;
+    auto it = import_references.find(export_path);
+    if (it != import_references.end()) {
+      for (Symbol object_name : it->second) {
+        object_names.emplace(ndfbin.get_symbols().str(object_name));
+      }
+    }
+    index.set_imports(meta.vfs_path,
+                      std::string(ndfbin.get_symbols().str(export_path)),
+                      object_names);
+  }
+  changed_imports.clear();
 }
 
-std::string wgrd_files::NdfBin::render_class_list() {
+std::optional<Symbol> wgrd_files::NdfBin::render_class_list() {
   ImGui::Text(gettext("Class List:"));
-  std::string ret = "";
+  std::optional<Symbol> ret;
   if (ImGui::BeginListBox(
           "##Class List",
           ImVec2(-FLT_MIN, 20 * ImGui::GetTextLineHeightWithSpacing()))) {
@@ -180,10 +376,9 @@ std::string wgrd_files::NdfBin::render_class_list() {
     clipper.Begin(class_list_filtered.size());
     while (clipper.Step()) {
       for (int it = clipper.DisplayStart; it < clipper.DisplayEnd; it++) {
-        const std::string &class_name = class_list_filtered[it];
-        const auto &class_ = class_list[class_name];
+        Symbol class_name = class_list_filtered[it];
 
-        if (ImGui::Selectable(class_name.c_str(),
+        if (ImGui::Selectable(ndfbin.c_str(class_name),
                               selected_class == class_name)) {
           selected_class = class_name;
           ret = class_name;
@@ -208,14 +403,15 @@ void wgrd_files::NdfBin::render_classes() {
       continue;
     }
     if (!class_list.contains(class_name)) {
-      spdlog::error("Class {} not found", class_name);
+      spdlog::error("Class {} not found", ndfbin.c_str(class_name));
       continue;
     }
 
     auto &class_ = class_list.at(class_name);
 
     ImGui::SetNextWindowSize(ImVec2(600, 800), ImGuiCond_FirstUseEver);
-    if (ImGui::Begin(class_name.c_str(), &p_open, ImGuiWindowFlags_MenuBar)) {
+    if (ImGui::Begin(ndfbin.c_str(class_name), &p_open,
+                     ImGuiWindowFlags_MenuBar)) {
       render_class_menu(class_name);
       // object list
       if (ImGui::BeginListBox(
@@ -226,10 +422,9 @@ void wgrd_files::NdfBin::render_classes() {
 
         while (clipper.Step()) {
           for (int it = clipper.DisplayStart; it < clipper.DisplayEnd; it++) {
-            const auto &object = ndfbin.get_object(class_.objects[it]);
-
-            if (ImGui::Selectable(object.name.c_str(), false)) {
-              open_window(object.name);
+            Symbol object_name = class_.objects[it];
+            if (ImGui::Selectable(ndfbin.c_str(object_name), false)) {
+              open_window(object_name);
             }
           }
         }
@@ -249,7 +444,7 @@ void wgrd_files::NdfBin::render_classes() {
 
         for (auto &[property_name, property] : class_.properties) {
           ImGui::TableNextColumn();
-          ImGui::Text("%s", property_name.c_str());
+          ImGui::Text("%s", ndfbin.c_str(property_name));
           ImGui::TableNextColumn();
           ImGuiTableFlags sub_flags = ImGuiTableFlags_Hideable |
                                       ImGuiTableFlags_RowBg |
@@ -269,7 +464,7 @@ void wgrd_files::NdfBin::render_classes() {
               ImGui::TableNextColumn();
               ImGui::Text("%lu", objects.size());
               ImGui::TableNextColumn();
-              ImGui::PushID(property_name.c_str());
+              ImGui::PushID(property_name);
               // TODO: maybe cache this?
               // auto object_items = objects | std::views::join_with(',');
               // std::string object_items_str =
@@ -289,14 +484,14 @@ void wgrd_files::NdfBin::render_classes() {
   render_bulk_renames();
 }
 
-void wgrd_files::NdfBin::render_class_menu(std::string class_name) {
+void wgrd_files::NdfBin::render_class_menu(Symbol class_name) {
   if (ImGui::BeginMenuBar()) {
     if (ImGui::BeginMenu(gettext("Tools"))) {
       if (ImGui::MenuItem(gettext("Bulk Rename"))) {
         open_class_bulk_rename_windows.insert({class_name, true});
         // FIXME: refactor bulk renames into separate class so they can handle
         // their own windows...
-        bulk_rename_prefix = class_name;
+        bulk_rename_prefix = ndfbin.c_str(class_name);
       }
 
       ImGui::EndMenu();
@@ -312,16 +507,16 @@ void wgrd_files::NdfBin::render_bulk_renames() {
       continue;
     }
     if (!class_list.contains(class_name)) {
-      spdlog::error("Class {} not found", class_name);
+      spdlog::error("Class {} not found", ndfbin.c_str(class_name));
       continue;
     }
     auto &class_ = class_list.at(class_name);
 
     ImGui::SetNextWindowSize(ImVec2(600, 800), ImGuiCond_FirstUseEver);
-    std::string wndname =
-        std::format("{} {}", gettext("Bulk Rename: "), class_name);
+    std::string wndname = std::format("{} {}", gettext("Bulk Rename: "),
+                                      ndfbin.c_str(class_name));
     if (ImGui::Begin(wndname.c_str(), &p_open, ImGuiWindowFlags_None)) {
-      ImGui::Text("Bulk Rename: %s", class_name.c_str());
+      ImGui::Text("Bulk Rename: %s", ndfbin.c_str(class_name));
       ImGui::Separator();
       if (ImGui::SliderInt(gettext("Select number of properties"),
                            &bulk_rename_property_count, 0,
@@ -342,9 +537,11 @@ void wgrd_files::NdfBin::render_bulk_renames() {
         ImGui::PushID(i);
         if (ImGui::BeginCombo(gettext("Select Property"),
                               bulk_rename_selected_properties[i].c_str())) {
-          for (auto &[property_name, _] : class_.properties) {
+          for (auto &[property_symbol, _] : class_.properties) {
+            std::string_view property_name =
+                ndfbin.get_symbols().str(property_symbol);
             std::string &selection = bulk_rename_selected_properties[i];
-            if (ImGui::Selectable(property_name.c_str(),
+            if (ImGui::Selectable(ndfbin.c_str(property_symbol),
                                   selection == property_name)) {
               bulk_rename_selected_properties[i] = property_name;
             }
@@ -382,6 +579,8 @@ void wgrd_files::NdfBin::render_bulk_renames() {
             bulk_rename_overrides.insert({object.name, {"", false}});
           }
 
+          // rendered every frame, the values come from the digest
+          auto digest = ndfbin.get_digest(object_name);
           std::string new_name = bulk_rename_prefix;
           for (int i = 0; i < bulk_rename_property_count; i++) {
             if (!object.property_map.contains(
@@ -389,9 +588,9 @@ void wgrd_files::NdfBin::render_bulk_renames() {
               new_name += "_NULL";
               continue;
             }
-            auto &property = object.properties.at(
-                object.property_map.at(bulk_rename_selected_properties[i]));
-            std::string prop_name = property->as_string();
+            auto &property = digest.properties[object.property_map.at(
+                bulk_rename_selected_properties[i])];
+            std::string prop_name(digest.value(property));
             std::replace(prop_name.begin(), prop_name.end(), ' ', '_');
             new_name += "_" + prop_name;
           }
@@ -441,7 +640,8 @@ void wgrd_files::NdfBin::render_bulk_renames() {
         auto trans = std::make_unique<NdfTransactionBulkRename>();
         trans->renames = std::move(renames);
         ndfbin.apply_transaction(std::move(trans));
-        object_count_changed = true;
+        apply_index_changes();
+        m_is_changed = true;
       }
     }
     ImGui::End();
@@ -452,9 +652,9 @@ void wgrd_files::NdfBin::render_bulk_renames() {
 }
 
 std::optional<std::unique_ptr<NdfTransaction>>
-wgrd_files::NdfBin::render_object_info(std::string object_name) {
+wgrd_files::NdfBin::render_object_info(Symbol object_name) {
   std::optional<std::unique_ptr<NdfTransaction>> ret = std::nullopt;
-  if (object_name.empty() || !ndfbin.contains_object(object_name)) {
+  if (!ndfbin.contains_object(object_name)) {
     return ret;
   }
   auto &object = ndfbin.get_object(object_name);
@@ -476,7 +676,7 @@ wgrd_files::NdfBin::render_object_info(std::string object_name) {
     ImGui::Text("Object Name: ");
     ImGui::TableNextColumn();
     ImGui::SetNextItemWidth(ImGui::GetContentRegionAvail().x);
-    std::string changed_object_name = object_name;
+    std::string changed_object_name = object.name;
     if (ImGui::InputText("##ObjectName", &changed_object_name,
                          ImGuiInputTextFlags_EnterReturnsTrue)) {
       auto change = std::make_unique<NdfTransactionChangeObjectName>();
@@ -514,12 +714,12 @@ wgrd_files::NdfBin::render_object_info(std::string object_name) {
     ImGui::TableNextColumn();
     ImGui::Text("Object References: ");
     ImGui::TableNextColumn();
-    if (object_references.contains(object.name)) {
-      ImGui::PushID(object.name.c_str());
-      for (auto ref : object_references.at(object.name)) {
-        if (ImGui::Button(ref.c_str())) {
+    if (object_references.contains(object_name)) {
+      ImGui::PushID(object_name);
+      for (Symbol ref : object_references.at(object_name)) {
+        if (ImGui::Button(ndfbin.c_str(ref))) {
           open_window(ref);
-          ImGui::SetWindowFocus(ref.c_str());
+          ImGui::SetWindowFocus(ndfbin.c_str(ref));
         }
         ImGui::SameLine();
       }
@@ -529,17 +729,24 @@ wgrd_files::NdfBin::render_object_info(std::string object_name) {
     ImGui::TableNextColumn();
     ImGui::Text("Import References: ");
     ImGui::TableNextColumn();
-    if (export_references.contains(object.export_path)) {
+    if (!object.export_path.empty()) {
       ImGui::PushID(object.export_path.c_str());
-      auto &[vfs_path, object_names] = export_references.at(object.export_path);
-      for (auto &object_name : object_names) {
-        if (ImGui::Button(object_name.c_str())) {
-          open_window(vfs_path, object_name);
-          // FIXME: this requires some way of getting *proper* window names
-          // (unique!)
-          // ImGui::SetWindowFocus(ref.c_str());
+      auto importers =
+          files->get_reference_index().get_importers(object.export_path);
+      if (importers) {
+        for (auto &[vfs_path, object_names] : *importers) {
+          ImGui::PushID(vfs_path.c_str());
+          for (auto &object_name : *object_names) {
+            if (ImGui::Button(object_name.c_str())) {
+              open_window(vfs_path, object_name);
+              // FIXME: this requires some way of getting *proper* window
+              // names (unique!)
+              // ImGui::SetWindowFocus(ref.c_str());
+            }
+            ImGui::SameLine();
+          }
+          ImGui::PopID();
         }
-        ImGui::SameLine();
       }
       ImGui::PopID();
     }
@@ -565,9 +772,9 @@ wgrd_files::NdfBin::render_object_info(std::string object_name) {
   return ret;
 }
 
-void wgrd_files::NdfBin::render_property_list(std::string object_name) {
+void wgrd_files::NdfBin::render_property_list(Symbol object_name) {
   // in case Remove Object was pressed
-  if (object_name.empty() || !ndfbin.contains_object(object_name)) {
+  if (!ndfbin.contains_object(object_name)) {
     return;
   }
   auto &object = ndfbin.get_object(object_name);
@@ -597,9 +804,10 @@ void wgrd_files::NdfBin::render_property_list(std::string object_name) {
   }
 }
 
-void wgrd_files::NdfBin::render_property(std::string object_name,
-                                         std::string property_name) {
-  spdlog::debug("rendering property {} {}", object_name, property_name);
+void wgrd_files::NdfBin::render_property(Symbol object_name,
+                                         const std::string &property_name) {
+  spdlog::debug("rendering property {} {}", ndfbin.c_str(object_name),
+                property_name);
   auto &object = ndfbin.get_object(object_name);
   auto &property_idx = object.property_map.at(property_name);
   auto &property = object.properties.at(property_idx);
@@ -1166,6 +1374,8 @@ wgrd_files::NdfBin::render_ndf_type(std::unique_ptr<NDFProperty> &property) {
 }
 
 void wgrd_files::NdfBin::render_window() {
+  // property changes are applied while rendering the previous frame
+  apply_index_changes();
   render_object_list();
   render_class_list();
 }
@@ -1180,7 +1390,7 @@ void wgrd_files::NdfBin::render_extra() {
       continue;
     }
     ImGui::SetNextWindowSize(ImVec2(800, 400), ImGuiCond_FirstUseEver);
-    if (ImGui::Begin(object_name.c_str(), &p_open)) {
+    if (ImGui::Begin(ndfbin.c_str(object_name), &p_open)) {
       auto ret = render_object_info(object_name);
       if (ret) {
         changes.push_back(std::move(ret.value()));
@@ -1193,8 +1403,6 @@ void wgrd_files::NdfBin::render_extra() {
   for (auto &change : changes) {
     std::string object_name = change->object_name;
     ndfbin.apply_transaction(std::move(change));
-    // also gets triggered when changing top object, but whatever
-    object_count_changed = true;
     // if object was removed, we need to close its window as well
     if (!ndfbin.contains_object(object_name)) {
       close_window(object_name);
@@ -1202,15 +1410,33 @@ void wgrd_files::NdfBin::render_extra() {
     m_is_changed = true;
   }
   changes.clear();
+  apply_index_changes();
+  // an edit the journal couldn't hold is only safe once it is in a snapshot
+  if (ndfbin.take_checkpoint_request()) {
+    save_snapshot();
+  }
+  // edits of the same property are merged into one undo step until the
+  // user lets go of the widget
+  if (!ImGui::IsAnyItemActive()) {
+    ndfbin.end_interaction();
+  }
 }
 
 std::unordered_set<std::string>
 wgrd_files::NdfBin::get_import_references(std::string export_path) {
-  auto exp_it = import_references.find(export_path);
+  auto symbol = ndfbin.get_symbols().find(export_path);
+  if (!symbol) {
+    return {};
+  }
+  auto exp_it = import_references.find(symbol.value());
   if (exp_it == import_references.end()) {
     return {};
   }
-  return exp_it->second;
+  std::unordered_set<std::string> ret;
+  for (Symbol object_name : exp_it->second) {
+    ret.emplace(ndfbin.get_symbols().str(object_name));
+  }
+  return ret;
 }
 
 std::unordered_map<std::string, std::unordered_set<std::string>>
@@ -1218,48 +1444,22 @@ wgrd_files::NdfBin::get_import_references(
     const std::unordered_set<std::string> &export_paths) {
   std::unordered_map<std::string, std::unordered_set<std::string>> ret;
   for (auto &export_path : export_paths) {
-    auto exp_it = import_references.find(export_path);
-    if (exp_it == import_references.end()) {
+    auto object_names = get_import_references(export_path);
+    if (object_names.empty()) {
       continue;
     }
-    ret[export_path] = exp_it->second;
+    ret[export_path] = std::move(object_names);
   }
-  return std::move(ret);
+  return ret;
 }
 
 bool wgrd_files::NdfBin::references_export_path(std::string export_path) {
-  return import_references.contains(export_path);
-}
-
-bool wgrd_files::NdfBin::is_file(const FileMeta &meta) {
-  auto stream_opt = open_file(meta.fs_path);
-  if (!stream_opt) {
-    return false;
-  }
-  auto &stream = stream_opt.value();
-  stream.seekg(meta.offset);
-
-  char magic[4];
-  stream.read(magic, sizeof(magic));
-  char magic2[4];
-  stream.read(magic2, sizeof(magic2));
-  char magic3[4];
-  stream.read(magic3, sizeof(magic3));
-
-  if (strncmp(magic, "EUG0", 4)) {
-    spdlog::debug("magic {} at {:0X}", magic, meta.offset);
-    return false;
-  }
-
-  if (strncmp(magic3, "CNDF", 4)) {
-    spdlog::debug("magic3 {} at {:0X}", magic3, meta.offset);
-    return false;
-  }
-
-  return true;
+  auto symbol = ndfbin.get_symbols().find(export_path);
+  return symbol && import_references.contains(symbol.value());
 }
 
 bool wgrd_files::NdfBin::reload_db() {
+  ScopedTrace trace("reload_db", meta.vfs_path);
   if (!db.is_initialized()) {
     db.init(db_path / "ndfbin.db");
   }
@@ -1286,6 +1486,79 @@ bool wgrd_files::NdfBin::reload_db() {
   return true;
 }
 
+void wgrd_files::NdfBin::set_history_budget() {
+  const auto &config = files->get_config();
+  // db_path is shared by all workspaces and every workspace has the same vfs
+  // paths, so the output folder of the workspace is part of the key. vfs
+  // paths also contain characters that can't be used in file names.
+  uint64_t key = fnv1a_hash(config.bin_path.generic_string());
+  key = fnv1a_hash(std::string_view("\0", 1), key);
+  key = fnv1a_hash(meta.vfs_path, key);
+  std::string name = std::format("{:016x}.undo", key);
+  ndfbin.set_history_budget(config.undo_history_entries,
+                            config.undo_history_bytes,
+                            db_path / "undo" / name);
+}
+
+void wgrd_files::NdfBin::unload() {
+  // published again by fill_class_list once loading succeeded
+  files->get_reference_index().remove_file(meta.vfs_path);
+}
+
+bool wgrd_files::NdfBin::load_snapshot() {
+  if (fs::exists(snapshot_path)) {
+    bool loaded = false;
+    try {
+      loaded = ndfbin.load_snapshot(snapshot_path, m_is_changed);
+    } catch (const std::exception &e) {
+      spdlog::error("Failed to parse snapshot {}: {}", snapshot_path.string(),
+                    e.what());
+    }
+    if (!loaded) {
+      // the file is reloaded from the dat and a new snapshot saved, the
+      // edits in the old one must not be overwritten by that. the journal
+      // is moved aside by load_bin.
+      if (!back_up_file(snapshot_path)) {
+        // not falling back to the dat, saving its snapshot would overwrite
+        // this one
+        throw std::runtime_error("invalid snapshot can't be moved aside");
+      }
+      spdlog::error("Could not load snapshot {}, moved it to .bak, the edits "
+                    "in it are not loaded",
+                    snapshot_path.string());
+      return false;
+    }
+    reload_db();
+  } else if (fs::exists(xml_path)) {
+    // workspaces from before snapshots keep their saved edits in the xml
+    if (!load_xml(xml_path) || !ndfbin.save_snapshot(snapshot_path, true)) {
+      return false;
+    }
+    m_is_changed = true;
+  } else {
+    return false;
+  }
+  set_history_budget();
+  // restores the edits done after the snapshot was last saved
+  if (ndfbin.open_journal(journal_path(), true) > 0) {
+    m_is_changed = true;
+  }
+  fill_class_list();
+  item_current_idx = -1;
+  object_count_changed = false;
+  filter_changed = true;
+  return true;
+}
+
+bool wgrd_files::NdfBin::save_snapshot() {
+  spdlog::debug("Saving ndf snapshot to {}", snapshot_path.string());
+  if (!ndfbin.save_snapshot(snapshot_path, m_is_changed)) {
+    return false;
+  }
+  ndfbin.checkpoint_journal();
+  return true;
+}
+
 bool wgrd_files::NdfBin::load_xml(fs::path path) {
   if (!fs::exists(xml_path)) {
     spdlog::info("No ndf xml file found at {}", xml_path.string());
@@ -1296,8 +1569,10 @@ bool wgrd_files::NdfBin::load_xml(fs::path path) {
     return false;
   }
   spdlog::debug("Loading ndf xml from {}", xml_path.string());
+  ScopedTrace trace("load_xml", meta.vfs_path);
   reload_db();
   ndfbin.load_from_xml_file(xml_path, &db, ndf_id);
+  set_history_budget();
   fill_class_list();
   item_current_idx = -1;
   object_count_changed = false;
@@ -1307,13 +1582,19 @@ bool wgrd_files::NdfBin::load_xml(fs::path path) {
 
 bool wgrd_files::NdfBin::save_xml(fs::path path) {
   spdlog::debug("Saving ndf xml to {}", path.string());
+  ScopedTrace trace("save_xml", meta.vfs_path);
   ndfbin.save_ndf_xml_to_file(path);
   return true;
 }
 
 bool wgrd_files::NdfBin::load_bin(fs::path path) {
   spdlog::debug("Loading ndf bin from {}", path.string());
-  ndfbin.start_parsing(path, get_data());
+  ScopedTrace trace("load_bin", meta.vfs_path);
+  ndfbin.start_parsing(path, get_data().span());
+  set_history_budget();
+  // the journal belongs to the snapshot, which is rewritten after this.
+  // edits left in it are moved aside.
+  ndfbin.open_journal(journal_path(), false);
   fill_class_list();
   reload_db();
   item_current_idx = -1;
@@ -1324,8 +1605,12 @@ bool wgrd_files::NdfBin::load_bin(fs::path path) {
 
 bool wgrd_files::NdfBin::save_bin(fs::path path) {
   spdlog::debug("Saving ndfbin to {}", path.string());
+  ScopedTrace trace("write ndfbin", meta.vfs_path);
   fs::create_directories(path.parent_path());
-  ndfbin.save_ndfbin_to_file(path);
+  if (!ndfbin.save_ndfbin_to_file(path)) {
+    spdlog::error("Could not save ndfbin to {}", path.string());
+    return false;
+  }
   return true;
 }
 
@@ -1334,11 +1619,11 @@ void wgrd_files::NdfBin::open_window(std::string object_name) {
     spdlog::warn("Trying to open empty object_name window {}", object_name);
     return;
   }
-  if (!open_object_windows.contains("object_name")) {
-    open_object_windows.insert({object_name, true});
-  } else {
-    open_object_windows[object_name] = true;
-  }
+  open_window(ndfbin.intern(object_name));
+}
+
+void wgrd_files::NdfBin::open_window(Symbol object_name) {
+  open_object_windows[object_name] = true;
 }
 
 void wgrd_files::NdfBin::open_window(std::string vfs_path,
@@ -1365,9 +1650,9 @@ void wgrd_files::NdfBin::close_window(std::string object_name) {
   if (object_name.empty()) {
     return;
   }
-  if (!open_object_windows.contains("object_name")) {
-    open_object_windows.insert({object_name, false});
-  } else {
-    open_object_windows[object_name] = false;
-  }
+  close_window(ndfbin.intern(object_name));
+}
+
+void wgrd_files::NdfBin::close_window(Symbol object_name) {
+  open_object_windows[object_name] = false;
 }
@@ -6,7 +6,9 @@
 #include "ndf.hpp"
 #include "ndftransactions.hpp"
 
+#include "imgui_helpers.hpp"
 #include "ndf_db.hpp"
+#include "object_search.hpp"
 
 namespace wgrd_files {
 
@@ -15,14 +17,22 @@ private:
   // database interface, holds its own connection
   NDF_DB db;
   int ndf_id = 0;
-  // object count is cached, since it iterates all objects in ndfbin
-  // gets set to true if the object count changed after removing / adding /
-  // cloning objects
+  // gets set to true if the indexes need to be rebuilt from scratch,
+  // transactions update them incrementally through apply_index_changes
   bool object_count_changed = true;
   // this is the option, whether the object and class list should be filtered
   // again
   bool filter_changed = true;
-  std::vector<std::string> object_list_filtered;
+  // all names in the indexes and lists are interned in ndfbin's symbol table
+  std::vector<Symbol> object_list_filtered;
+  // display labels of the object list indexed by symbol, empty if not built
+  // yet or invalidated by a change
+  std::vector<std::string> row_labels;
+  const std::string &get_row_label(Symbol object_name);
+  FrameTimer object_list_timer;
+  // answers the filter queries off the ui thread, shared with running queries
+  std::shared_ptr<ObjectSearch> object_search =
+      std::make_shared<ObjectSearch>();
   std::string object_filter = "";
   std::string object_filter_lower = "";
   std::string class_filter = "";
@@ -38,48 +48,68 @@ private:
   bool object_changed = true;
   std::vector<std::any> property_temp;
 
-  std::map<std::string, bool> open_object_windows;
+  std::map<Symbol, bool> open_object_windows;
 
   NdfBinFile ndfbin;
   void render_object_list();
 
+  typedef std::map<std::string, std::unordered_set<Symbol>, std::less<>>
+      ValueMap;
   struct Property {
-    // maps the possible value to an object name
-    std::map<std::string, std::unordered_set<std::string>> values;
+    // maps the possible value to the objects having it
+    ValueMap values;
   };
 
   struct Class {
     // used for rendering the object list
-    std::vector<std::string> objects;
-    // maps the property name to the property
-    std::map<std::string, Property> properties;
+    std::vector<Symbol> objects;
+    // maps the property name to the property, ordered by first occurrence
+    std::map<Symbol, Property> properties;
   };
   // maps the class name to the class
-  std::map<std::string, Class> class_list;
+  std::unordered_map<Symbol, Class> class_list;
   std::optional<std::promise<bool>> m_class_list_promise;
   std::optional<std::future<bool>> m_class_list_future;
 
+  // what an object added to the indexes, so it can be removed again without
+  // looking at the already changed object
+  struct IndexedObject {
+    Symbol class_name;
+    // property name -> value entry containing this object
+    std::vector<std::pair<Symbol, ValueMap::iterator>> values;
+    std::vector<Symbol> object_references;
+    std::vector<Symbol> import_references;
+  };
+  std::unordered_map<Symbol, IndexedObject> indexed_objects;
+  // objects changed while a value is still being edited, they are reindexed
+  // once the edit ends instead of every frame
+  std::unordered_set<Symbol> pending_reindex;
+
   // contains a mapping object_name -> objects referencing the object
-  std::unordered_map<std::string, std::unordered_set<std::string>>
-      object_references;
+  std::unordered_map<Symbol, std::unordered_set<Symbol>> object_references;
   // contains a mapping export_path -> objects names importing it in this ndfbin
-  std::unordered_map<std::string, std::unordered_set<std::string>>
-      import_references;
-  // contains a mapping export_path -> vfs_path/object_name from other ndfbins
-  // importing an object from this file
-  std::unordered_map<std::string,
-                     std::pair<std::string, std::unordered_set<std::string>>>
-      export_references;
-  // used for filtering the class list
-  std::vector<std::string> class_list_filtered;
+  std::unordered_map<Symbol, std::unordered_set<Symbol>> import_references;
+  // export paths whose importers in this file changed since they were last
+  // published to the reference index of the workspace
+  std::unordered_set<Symbol> changed_imports;
+  void publish_imports();
+  // used for filtering the class list, sorted by name
+  std::vector<Symbol> class_list_filtered;
   // only for being able to save the last clicked position for auto focus
-  std::string selected_class = "";
-  std::unordered_map<std::string, bool> open_class_windows;
-  std::unordered_map<std::string, bool> open_class_bulk_rename_windows;
+  std::optional<Symbol> selected_class;
+  std::unordered_map<Symbol, bool> open_class_windows;
+  std::unordered_map<Symbol, bool> open_class_bulk_rename_windows;
   void fill_class_list();
-  std::string render_class_list();
+  // adds the object to / removes it from the indexes, the class object list is
+  // only touched if update_class is set
+  void index_object(Symbol object_name, bool update_class = true);
+  void unindex_object(Symbol object_name, bool update_class = true);
+  void reindex_object(Symbol object_name);
+  // applies the changes of all transactions done since the last call
+  void apply_index_changes();
+  std::optional<Symbol> render_class_list();
   void render_classes();
-  void render_class_menu(std::string class_name);
+  void render_class_menu(Symbol class_name);
 
   int bulk_rename_property_count = 1;
   std::string bulk_rename_prefix = "";
@@ -89,9 +119,9 @@ private:
   void render_bulk_renames();
 
   std::optional<std::unique_ptr<NdfTransaction>>
-  render_object_info(std::string object_name);
-  void render_property_list(std::string object_name);
-  void render_property(std::string object_name, std::string property_name);
+  render_object_info(Symbol object_name);
+  void render_property_list(Symbol object_name);
+  void render_property(Symbol object_name, const std::string &property_name);
   std::optional<std::unique_ptr<NdfTransactionChangeProperty>>
   render_ndf_type(std::unique_ptr<NDFProperty> &property);
 
@@ -106,6 +136,13 @@ private:
   bool references_export_path(std::string export_path);
 
   bool reload_db();
+  // applies the undo history budget of the workspace, the journal lives in
+  // db_path/undo
+  void set_history_budget();
+  // edits done after the snapshot was saved, replayed on load_snapshot
+  fs::path journal_path() const {
+    return fs::path(snapshot_path) += ".journal";
+  }
 
 public:
   explicit NdfBin(const Files *files, FileMeta meta)
@@ -113,16 +150,24 @@ public:
   FileType get_type() override { return FileType::NDFBIN; }
   void render_window() override;
   void render_extra() override;
-  static bool is_file(const FileMeta &meta);
+  void unload() override;
+  bool load_snapshot() override;
+  bool save_snapshot() override;
   bool load_xml(fs::path path) override;
   bool save_xml(fs::path path) override;
   bool load_bin(fs::path path) override;
   bool save_bin(fs::path path) override;
+  // edits are counted by the ndfbin itself
+  uint64_t get_generation() const override {
+    return m_generation + ndfbin.get_generation();
+  }
   // opens window in this ndfbin file
   void open_window(std::string object_name);
+  void open_window(Symbol object_name);
   // opens window in another ndfbin file
   void open_window(std::string vfs_path, std::string object_name);
   void close_window(std::string object_name);
+  void close_window(Symbol object_name);
 };
 
 } // namespace wgrd_files
@@ -17,7 +17,6 @@ public:
       : File(files, std::move(meta)) {}
   FileType get_type() override { return FileType::PPK; }
   void render_window() override;
-  static bool is_file(const FileMeta &meta);
 };
 
 } // namespace wgrd_files
@@ -0,0 +1,170 @@
+#include "save_job.hpp"
+
+#include "files/file.hpp"
+#include "spdlog/spdlog.h"
+#include "threadpool.hpp"
+#include "trace.hpp"
+
+#include <algorithm>
+#include <format>
+
+#include <imgui.h>
+#include <libintl.h>
+#include <magic_enum.hpp>
+
+using namespace wgrd_files;
+
+namespace {
+
+int64_t elapsed_ms(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration_cast<std::chrono::milliseconds>(
+             std::chrono::steady_clock::now() - start)
+      .count();
+}
+
+} // namespace
+
+SaveJob::SaveJob(DatPool &dat_pool,
+                 const std::vector<std::pair<fs::path, fs::path>> &dat_paths,
+                 const std::vector<std::pair<File *, size_t>> &files)
+    : m_dat_pool(dat_pool), m_entries(files.size()), m_dats(dat_paths.size()) {
+  for (size_t i = 0; i < dat_paths.size(); i++) {
+    m_dats[i].fs_path = dat_paths[i].first;
+    m_dats[i].out_path = dat_paths[i].second;
+  }
+  for (size_t i = 0; i < files.size(); i++) {
+    auto &[file, dat_idx] = files[i];
+    m_entries[i].file = file;
+    m_entries[i].vfs_path = file->get_meta().vfs_path;
+    m_entries[i].dat_idx = dat_idx;
+    m_dats[dat_idx].files_left++;
+  }
+  m_future = m_promise.get_future().share();
+}
+
+std::shared_future<bool> SaveJob::start() {
+  m_start = std::chrono::steady_clock::now();
+  if (m_dats.empty()) {
+    m_elapsed_ms = 0;
+    m_promise.set_value(true);
+    return m_future;
+  }
+  spdlog::info("Saving {} files into {} dat files", m_entries.size(),
+               m_dats.size());
+  auto &pool = ThreadPoolSingleton::get_instance();
+  // the tasks keep the job alive, even if its owner drops it
+  for (size_t idx = 0; idx < m_dats.size(); idx++) {
+    if (m_dats[idx].files_left == 0) {
+      pool.submit(TaskPriority::VISIBLE,
+                  [self = shared_from_this(), idx]() { self->pack_dat(idx); });
+    }
+  }
+  for (size_t idx = 0; idx < m_entries.size(); idx++) {
+    pool.submit(TaskPriority::VISIBLE,
+                [self = shared_from_this(), idx]() { self->save_file(idx); });
+  }
+  return m_future;
+}
+
+void SaveJob::save_file(size_t idx) {
+  auto &entry = m_entries[idx];
+  ScopedTrace trace("save file", entry.vfs_path);
+  auto &dat = m_dats[entry.dat_idx];
+  entry.state = State::SAVING;
+  dat.state = State::SAVING;
+  auto start = std::chrono::steady_clock::now();
+  spdlog::info("Saving binary for {} to {}", entry.vfs_path,
+               entry.file->get_bin_path().string());
+  bool ret = entry.file->save_bin_cached();
+  entry.duration_ms = elapsed_ms(start);
+  entry.state = ret ? State::DONE : State::FAILED;
+  if (!ret) {
+    dat.failed = true;
+  }
+  m_saved_files++;
+  // the last file of the dat file rebuilds it
+  if (--dat.files_left == 0) {
+    pack_dat(entry.dat_idx);
+  }
+}
+
+void SaveJob::pack_dat(size_t dat_idx) {
+  auto &dat = m_dats[dat_idx];
+  ScopedTrace trace("pack dat", dat.fs_path.string());
+  auto start = std::chrono::steady_clock::now();
+  bool ret = !dat.failed;
+  if (ret) {
+    dat.state = State::PACKING;
+    EDatWriter writer;
+    for (auto &entry : m_entries) {
+      if (entry.dat_idx == dat_idx) {
+        writer.replace(entry.vfs_path, entry.file->get_bin_path());
+      }
+    }
+    // the dat file may get overwritten, so it must not be mapped anymore
+    m_dat_pool.release(dat.fs_path);
+    ret = writer.write(dat.fs_path, dat.out_path / dat.fs_path.filename());
+  } else {
+    spdlog::error("Not saving {}, not all changed files could be saved",
+                  dat.fs_path.string());
+  }
+  dat.duration_ms = elapsed_ms(start);
+  dat.state = ret ? State::DONE : State::FAILED;
+  spdlog::info("Saved {} in {}ms", dat.fs_path.string(),
+               dat.duration_ms.load());
+  if (!ret) {
+    m_failed_dats++;
+  }
+  // the last dat file fulfills the promise
+  if (++m_finished_dats == m_dats.size()) {
+    m_elapsed_ms = elapsed_ms(m_start);
+    spdlog::info("Saved {} dat files in {}ms, {} failed", m_dats.size(),
+                 m_elapsed_ms.load(), m_failed_dats.load());
+    m_promise.set_value(m_failed_dats == 0);
+  }
+}
+
+void SaveJob::render() {
+  size_t saved = m_saved_files;
+  size_t finished = m_finished_dats;
+  // saving the files and rebuilding the dat files count the same
+  size_t total = m_entries.size() + m_dats.size();
+  int64_t elapsed = m_elapsed_ms;
+  if (elapsed < 0) {
+    elapsed = elapsed_ms(m_start);
+  }
+
+  std::string overlay = std::format("{}/{} files, {}/{} dat files", saved,
+                                    m_entries.size(), finished, m_dats.size());
+  ImGui::ProgressBar(total ? (float)(saved + finished) / total : 1.0f,
+                     ImVec2(-FLT_MIN, 0), overlay.c_str());
+  ImGui::Text(gettext("%zu failed, %.1fs"), m_failed_dats.load(),
+              elapsed / 1000.0);
+
+  if (!ImGui::TreeNode(gettext("Saved dat files"))) {
+    return;
+  }
+  if (ImGui::BeginTable("save_job", 3,
+                        ImGuiTableFlags_ScrollY | ImGuiTableFlags_RowBg,
+                        ImVec2(0, ImGui::GetTextLineHeight() * 12))) {
+    ImGui::TableSetupScrollFreeze(0, 1);
+    ImGui::TableSetupColumn(gettext("File"));
+    ImGui::TableSetupColumn(gettext("State"));
+    ImGui::TableSetupColumn(gettext("Time"));
+    ImGui::TableHeadersRow();
+    for (auto &dat : m_dats) {
+      State state = dat.state;
+      ImGui::TableNextRow();
+      ImGui::TableNextColumn();
+      ImGui::TextUnformatted(dat.fs_path.string().c_str());
+      ImGui::TableNextColumn();
+      ImGui::TextUnformatted(magic_enum::enum_name(state).data());
+      ImGui::TableNextColumn();
+      if (state == State::DONE || state == State::FAILED) {
+        ImGui::Text("%lldms", (long long)dat.duration_ms.load());
+      }
+    }
+    ImGui::EndTable();
+  }
+  ImGui::TreePop();
+}
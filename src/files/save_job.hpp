@@ -0,0 +1,78 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "dat_pool.hpp"
+#include "edat_writer.hpp"
+
+namespace wgrd_files {
+
+class File;
+
+/*
+ * Saves the changed files of a workspace into new dat files in the
+ * background.
+ *
+ * Every file is saved to its bin_path by its own task on the thread pool,
+ * files that didn't change since their last save are reused from there. The
+ * last saved file of a dat file starts the task rebuilding that dat file.
+ * No task waits for another one, so the pool never blocks on itself. The
+ * future returned by start is ready once every dat file is written and is
+ * true if all of them succeeded.
+ * */
+class SaveJob : public std::enable_shared_from_this<SaveJob> {
+public:
+  enum class State { QUEUED, SAVING, PACKING, DONE, FAILED };
+
+  struct Entry {
+    File *file = nullptr;
+    std::string vfs_path;
+    size_t dat_idx = 0;
+    std::atomic<State> state = State::QUEUED;
+    std::atomic<int64_t> duration_ms = 0;
+  };
+
+  struct Dat {
+    fs::path fs_path;
+    fs::path out_path;
+    std::atomic<State> state = State::QUEUED;
+    std::atomic_size_t files_left = 0;
+    std::atomic_bool failed = false;
+    std::atomic<int64_t> duration_ms = 0;
+  };
+
+private:
+  DatPool &m_dat_pool;
+  std::vector<Entry> m_entries;
+  std::vector<Dat> m_dats;
+  std::atomic_size_t m_saved_files = 0;
+  std::atomic_size_t m_finished_dats = 0;
+  std::atomic_size_t m_failed_dats = 0;
+
+  std::chrono::steady_clock::time_point m_start;
+  std::atomic<int64_t> m_elapsed_ms = -1;
+
+  std::promise<bool> m_promise;
+  std::shared_future<bool> m_future;
+
+  void save_file(size_t idx);
+  void pack_dat(size_t dat_idx);
+
+public:
+  // dat_paths: fs_path and out_path of every dat file, files: the changed
+  // files with the index of their dat file
+  SaveJob(DatPool &dat_pool,
+          const std::vector<std::pair<fs::path, fs::path>> &dat_paths,
+          const std::vector<std::pair<File *, size_t>> &files);
+  std::shared_future<bool> start();
+  std::shared_future<bool> get_future() const { return m_future; }
+  bool is_done() const { return m_finished_dats == m_dats.size(); }
+  void render();
+};
+
+} // namespace wgrd_files
@@ -11,7 +11,6 @@ public:
       : File(files, std::move(meta)) {}
   FileType get_type() override { return FileType::SCENARIO; }
   void render_window() override;
-  static bool is_file(const FileMeta &meta);
 };
 
 } // namespace wgrd_files
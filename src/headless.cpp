@@ -0,0 +1,78 @@
+#include "headless.hpp"
+
+#include "workspace.hpp"
+
+#include "spdlog/spdlog.h"
+
+#include <chrono>
+
+namespace {
+
+class PhaseTimer {
+private:
+  std::chrono::steady_clock::time_point m_start =
+      std::chrono::steady_clock::now();
+
+public:
+  // returns the milliseconds since the last call
+  int64_t lap() {
+    auto now = std::chrono::steady_clock::now();
+    auto ret =
+        std::chrono::duration_cast<std::chrono::milliseconds>(now - m_start);
+    m_start = now;
+    return ret.count();
+  }
+};
+
+} // namespace
+
+int run_headless(Workspaces &workspaces, const HeadlessOptions &options) {
+  auto start = std::chrono::steady_clock::now();
+  PhaseTimer timer;
+
+  if (!fs::exists(options.project_path)) {
+    spdlog::error("Project file {} does not exist",
+                  options.project_path.string());
+    return 1;
+  }
+  workspaces.load_project_file(options.project_path);
+  if (workspaces.get_workspaces().empty()) {
+    spdlog::error("No workspaces in {}", options.project_path.string());
+    return 1;
+  }
+  for (auto &[name, workspace] : workspaces.get_workspaces()) {
+    if (!workspace->wait_until_parsed()) {
+      spdlog::error("Could not parse workspace {}", name);
+      return 1;
+    }
+  }
+  spdlog::info("Parsed {} workspaces in {}ms",
+               workspaces.get_workspaces().size(), timer.lap());
+
+  for (auto &[name, workspace] : workspaces.get_workspaces()) {
+    // a dat file built from partially loaded edits would be silently wrong
+    if (!workspace->load_all_files(FileType::NDFBIN, options.jobs).get()) {
+      spdlog::error("Could not load all files of workspace {}", name);
+      return 1;
+    }
+  }
+  spdlog::info("Loaded ndf files in {}ms", timer.lap());
+
+  if (options.import_xml) {
+    size_t imported = 0;
+    for (auto &[_, workspace] : workspaces.get_workspaces()) {
+      imported += workspace->import_xml_edits();
+    }
+    spdlog::info("Imported {} xml files in {}ms", imported, timer.lap());
+  }
+
+  workspaces.save_workspaces(options.save_to_fs_path);
+  bool ret = workspaces.wait_for_saves();
+  spdlog::info("Saved dat files in {}ms", timer.lap());
+
+  auto total = std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::steady_clock::now() - start);
+  spdlog::info("Headless run {} after {}ms", ret ? "finished" : "failed",
+               total.count());
+  return ret ? 0 : 1;
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <thread>
+namespace fs = std::filesystem;
+
+class Workspaces;
+
+struct HeadlessOptions {
+  fs::path project_path = "project.toml";
+  // loads the saved xml edits before saving, otherwise only the snapshots
+  // and their journals are used
+  bool import_xml = false;
+  bool save_to_fs_path = false;
+  // how many ndfbins of a workspace are parsed at the same time
+  size_t jobs = std::thread::hardware_concurrency();
+};
+
+/*
+ * Builds the dat files of a project without the gui.
+ *
+ * Loads all workspaces of the project file and all their ndfbins, which
+ * replays the edits recorded in the snapshots and journals, optionally
+ * imports the xml edits and then saves all changed dat files. Prints how
+ * long every step took. Returns the exit code of the program.
+ * */
+int run_headless(Workspaces &workspaces, const HeadlessOptions &options);
@@ -14,13 +14,9 @@ namespace py = pybind11;
 #include <fstream>
 #include <iostream>
 
-#include "ThreadPool.h"
-
 #include <filesystem>
 namespace fs = std::filesystem;
 
-extern ThreadPool thread_pool;
-
 // Based on:
 // https://stackoverflow.com/questions/58758429/pybind11-redirect-python-sys-stdout-to-c-from-print
 class __attribute__((visibility("default"))) PyStdErrOutStreamRedirect {
@@ -95,6 +91,21 @@ inline fs::path append_ext(fs::path path, std::string ext) {
   return path.replace_extension(new_ext);
 }
 
+// moves a file that can't be used anymore aside to path.bak instead of
+// deleting it, so the data in it can still be recovered. an older .bak is
+// replaced.
+inline std::optional<fs::path> back_up_file(const fs::path &path) {
+  fs::path bak_path = append_ext(path, ".bak");
+  std::error_code ec;
+  fs::rename(path, bak_path, ec);
+  if (ec) {
+    spdlog::error("Could not move {} to {}: {}", path.string(),
+                  bak_path.string(), ec.message());
+    return std::nullopt;
+  }
+  return bak_path;
+}
+
 inline std::optional<std::fstream>
 open_file(const fs::path &fs_path,
           std::ios_base::openmode mode = std::ios::in | std::ios::binary,
@@ -108,5 +119,5 @@ open_file(const fs::path &fs_path,
     spdlog::warn("Failed to open file {}", fs_path.string());
     return std::nullopt;
   }
-  return std::move(stream);
+  return stream;
 }
@@ -4,6 +4,8 @@
 
 #include "math.h"
 
+#include <algorithm>
+
 #include <ImGuiFileDialog.h>
 
 std::optional<std::string> show_file_dialog_input(std::string title,
@@ -27,6 +29,34 @@ std::optional<std::string> show_file_dialog_input(std::string title,
   return ret;
 }
 
+void FrameTimer::end() {
+  std::chrono::duration<float, std::milli> duration =
+      std::chrono::steady_clock::now() - m_start;
+  m_samples[m_next] = duration.count();
+  m_next = (m_next + 1) % m_samples.size();
+}
+
+float FrameTimer::average_ms() const {
+  float sum = 0;
+  for (float sample : m_samples) {
+    sum += sample;
+  }
+  return sum / m_samples.size();
+}
+
+float FrameTimer::max_ms() const {
+  float ret = 0;
+  for (float sample : m_samples) {
+    ret = std::max(ret, sample);
+  }
+  return ret;
+}
+
+void FrameTimer::render(const char *label) const {
+  ImGui::TextDisabled(gettext("%s: %.3f ms (max %.3f ms)"), label,
+                      average_ms(), max_ms());
+}
+
 // Forward declare ShowFontAtlas() which isn't worth putting in public API yet
 namespace ImGui {
 IMGUI_API void ShowFontAtlas(ImFontAtlas *atlas);
@@ -2,6 +2,8 @@
 
 #include "imgui.h"
 
+#include <array>
+#include <chrono>
 #include <optional>
 #include <string>
 
@@ -9,6 +11,23 @@ std::optional<std::string> show_file_dialog_input(std::string title,
                                                   std::string previous_path,
                                                   std::string dialogkey);
 
+// measures how long a part of the ui takes per frame over the last frames,
+// so render regressions are visible
+class FrameTimer {
+private:
+  std::chrono::steady_clock::time_point m_start;
+  std::array<float, 120> m_samples = {};
+  size_t m_next = 0;
+
+public:
+  void begin() { m_start = std::chrono::steady_clock::now(); }
+  void end();
+  float average_ms() const;
+  float max_ms() const;
+  // renders the label with the average and max time
+  void render(const char *label) const;
+};
+
 namespace ImGui {
 void ShowFontSelector(const char *label);
 bool ShowStyleSelector(const char *label);
@@ -8,6 +8,8 @@
 #include <GLFW/glfw3.h>
 
 #include "maingui.hpp"
+#include "python_executor.hpp"
+#include "trace.hpp"
 #include "threadpool.hpp"
 
 #include <libintl.h>
@@ -35,13 +37,21 @@ int main(int argc, char *argv[]) {
   bindtextdomain("wgrd_mod_manager", ".");
   textdomain("wgrd_mod_manager");
 
+  wgrd_files::Tracer::set_thread_name("main");
   py::scoped_interpreter guard{};
   {
     py::gil_scoped_release release;
     // create the main gui inside this, so deinit is called before the python
     // interpreter is deinitialized
     maingui main_gui;
-    main_gui.init(argc, argv);
+    bool initialized = main_gui.init(argc, argv);
+
+    if (main_gui.is_headless()) {
+      int ret = initialized ? main_gui.run_headless() : 1;
+      ThreadPoolSingleton::get_instance().shutdown();
+      wgrd_files::PythonExecutor::get_instance().shutdown();
+      return ret;
+    }
 
     glfwSetErrorCallback(glfw_error_callback);
     if (!glfwInit())
@@ -176,7 +186,7 @@ int main(int argc, char *argv[]) {
     bool show_another_window = false;
     ImVec4 clear_color = ImVec4(0.45f, 0.55f, 0.60f, 1.00f);
 
-    while (!exit_now && !glfwWindowShouldClose(window)) {
+    while (!exit_now) {
       /*
       if(!exit_now && glfwWindowShouldClose(window)) {
         glfwDestroyWindow(window);
@@ -197,6 +207,11 @@ int main(int argc, char *argv[]) {
       // keyboard data. Generally you may always pass all inputs to dear imgui,
       // and hide them from your application based on those two flags.
       glfwPollEvents();
+      // closing the window exits like the exit menu, after running saves
+      if (glfwWindowShouldClose(window)) {
+        glfwSetWindowShouldClose(window, GLFW_FALSE);
+        main_gui.request_exit();
+      }
 
       // Start the Dear ImGui frame
       ImGui_ImplOpenGL3_NewFrame();
@@ -220,6 +235,8 @@ int main(int argc, char *argv[]) {
     }
 
     ThreadPoolSingleton::get_instance().shutdown();
+    // after the scheduler, its tasks may still wait for python calls
+    wgrd_files::PythonExecutor::get_instance().shutdown();
 
     py::gil_scoped_acquire acquire;
 
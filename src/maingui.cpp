@@ -1,5 +1,6 @@
 #include "maingui.hpp"
 
+#include "headless.hpp"
 #include "helpers.hpp"
 #include "imgui.h"
 #include "imgui_helpers.hpp"
@@ -9,7 +10,9 @@
 
 #include "ImGuiFileDialog.h"
 
+#include <algorithm>
 #include <libintl.h>
+#include <utility>
 
 maingui::maingui() : program(gettext("WG: RD Modding Suite")), workspaces() {
   program.add_argument("-p")
@@ -19,9 +22,37 @@ maingui::maingui() : program(gettext("WG: RD Modding Suite")), workspaces() {
       .help(gettext("Shows debug logs"))
       .default_value(false)
       .implicit_value(true);
+  program.add_argument("--headless")
+      .help(gettext("Saves the changes of the project without opening a "
+                    "window and exits"))
+      .default_value(false)
+      .implicit_value(true);
+  program.add_argument("--import-xml")
+      .help(gettext("Headless only: import the xml edits before saving"))
+      .default_value(false)
+      .implicit_value(true);
+  program.add_argument("--save-to-fs-path")
+      .help(gettext("Headless only: overwrite the input dat files"))
+      .default_value(false)
+      .implicit_value(true);
+  program.add_argument("-j", "--jobs")
+      .help(gettext("Headless only: number of files parsed in parallel"))
+      .default_value(static_cast<int>(std::thread::hardware_concurrency()))
+      .scan<'i', int>();
+  program.add_argument("--trace")
+      .help(gettext("Records a trace from the start and writes it in the "
+                    "chrome trace format to the given path on exit"));
 }
 
-maingui::~maingui() { imgui_sink->deinit(); }
+maingui::~maingui() {
+  if (!trace_path.empty()) {
+    wgrd_files::Tracer::export_chrome_trace(trace_path);
+  }
+  // init may have failed before the sink got created
+  if (imgui_sink) {
+    imgui_sink->deinit();
+  }
+}
 
 bool maingui::init(int argc, char *argv[]) {
   program.parse_args(argc, argv);
@@ -105,11 +136,30 @@ bool maingui::init(int argc, char *argv[]) {
     spdlog::set_level(spdlog::level::info);
   }
 
-  workspaces.load_project_file(program.get("-p"));
+  if (auto path = program.present("--trace")) {
+    trace_path = path.value();
+    wgrd_files::Tracer::set_enabled(true);
+  }
+
+  // the headless run loads the project itself, to time it
+  if (!is_headless()) {
+    workspaces.load_project_file(program.get("-p"));
+  }
 
   return true;
 }
 
+bool maingui::is_headless() { return program.get<bool>("--headless"); }
+
+int maingui::run_headless() {
+  HeadlessOptions options;
+  options.project_path = program.get("-p");
+  options.import_xml = program.get<bool>("--import-xml");
+  options.save_to_fs_path = program.get<bool>("--save-to-fs-path");
+  options.jobs = std::max(program.get<int>("--jobs"), 1);
+  return ::run_headless(workspaces, options);
+}
+
 bool maingui::render_menu_bar() {
   bool ret = false;
   if (ImGui::Shortcut(ImGuiMod_Ctrl | ImGuiKey_O)) {
@@ -127,7 +177,8 @@ bool maingui::render_menu_bar() {
       if (ImGui::MenuItem(gettext("Open new workspace"), "Ctrl+O")) {
         workspaces.show_add_workspace = true;
       }
-      if (ImGui::MenuItem(gettext("Save all workspaces"), "Ctrl+Shift+S")) {
+      if (ImGui::MenuItem(gettext("Save all workspaces"), "Ctrl+Shift+S",
+                          false, !workspaces.is_saving())) {
         workspaces.save_workspaces(save_to_fs_path);
       }
       ImGui::Checkbox(gettext("Save dat files to input path"),
@@ -161,6 +212,9 @@ bool maingui::render_menu_bar() {
       if (ImGui::MenuItem(gettext("Log"), "Ctrl+L")) {
         imgui_sink->open_log = true;
       }
+      if (ImGui::MenuItem(gettext("Trace"))) {
+        trace_window.open = true;
+      }
       ImGui::EndMenu();
     }
     ImGui::EndMenuBar();
@@ -222,6 +276,7 @@ bool maingui::render() {
   ImGuiID dockspace_id = ImGui::GetID("ModdingSuiteDockSpace");
   ImGui::DockSpace(dockspace_id, ImVec2(0.0f, 0.0f), ImGuiDockNodeFlags_None);
   bool exit_now = render_menu_bar();
+  exit_now |= std::exchange(m_exit_requested, false);
 
   ImGui::End();
 
@@ -235,6 +290,26 @@ bool maingui::render() {
     imgui_sink->open_log = true;
   }
   imgui_sink->render_log();
+  trace_window.render();
 
+  // the scheduler drops queued tasks on shutdown, so exiting during a save
+  // would leave some dat files written and others not
+  if (exit_now && workspaces.is_saving()) {
+    m_exit_after_saves = true;
+    exit_now = false;
+  }
+  if (m_exit_after_saves) {
+    if (workspaces.is_saving()) {
+      workspaces.render_saves_popup();
+    } else {
+      m_exit_after_saves = false;
+      if (workspaces.save_failed()) {
+        spdlog::error(gettext("Saving failed, not exiting"));
+        imgui_sink->open_log = true;
+      } else {
+        exit_now = true;
+      }
+    }
+  }
   return exit_now;
 }
@@ -3,8 +3,7 @@
 #include "logger.h"
 #include <argparse/argparse.hpp>
 
-#include "ThreadPool.h"
-
+#include "trace.hpp"
 #include "workspace.hpp"
 
 class maingui {
@@ -17,15 +16,27 @@ private:
 
   Workspaces workspaces;
   bool show_style_editor = false;
+  wgrd_files::TraceWindow trace_window;
+  // written on exit if tracing was enabled with --trace
+  fs::path trace_path;
   bool save_to_fs_path = false;
+  bool m_exit_requested = false;
+  // set when exiting while saving, the exit happens once the saves are done
+  bool m_exit_after_saves = false;
   bool render_menu_bar();
 
 public:
   maingui();
   ~maingui();
   bool init(int argc, char *argv[]);
+  // set with --headless, no window is created then
+  bool is_headless();
+  // loads and saves the project given by the arguments, returns the exit code
+  int run_headless();
   /*
    * renders the main gui, returns true if the user wants to exit the program
    * */
   bool render();
+  // exits like the exit menu on the next render, e.g. on closing the window
+  void request_exit() { m_exit_requested = true; }
 };
@@ -0,0 +1,134 @@
+#include "mapped_file.hpp"
+
+#include "spdlog/spdlog.h"
+
+#include <utility>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace wgrd_files;
+
+MappedFile::~MappedFile() { close(); }
+
+MappedFile::MappedFile(MappedFile &&other) noexcept {
+  *this = std::move(other);
+}
+
+MappedFile &MappedFile::operator=(MappedFile &&other) noexcept {
+  if (this == &other) {
+    return *this;
+  }
+  close();
+  m_data = std::exchange(other.m_data, nullptr);
+  m_size = std::exchange(other.m_size, 0);
+#ifdef _WIN32
+  m_file_handle = std::exchange(other.m_file_handle, nullptr);
+  m_mapping_handle = std::exchange(other.m_mapping_handle, nullptr);
+#endif
+  return *this;
+}
+
+#ifdef _WIN32
+
+bool MappedFile::open(const fs::path &path) {
+  close();
+  HANDLE file = CreateFileW(path.wstring().c_str(), GENERIC_READ,
+                            FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                            FILE_ATTRIBUTE_NORMAL, nullptr);
+  if (file == INVALID_HANDLE_VALUE) {
+    spdlog::warn("Failed to open file {}", path.string());
+    return false;
+  }
+  LARGE_INTEGER size;
+  if (!GetFileSizeEx(file, &size) || size.QuadPart == 0) {
+    spdlog::warn("Failed to map empty file {}", path.string());
+    CloseHandle(file);
+    return false;
+  }
+  HANDLE mapping =
+      CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (mapping == nullptr) {
+    spdlog::warn("Failed to map file {}", path.string());
+    CloseHandle(file);
+    return false;
+  }
+  void *data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+  if (data == nullptr) {
+    spdlog::warn("Failed to map file {}", path.string());
+    CloseHandle(mapping);
+    CloseHandle(file);
+    return false;
+  }
+  m_file_handle = file;
+  m_mapping_handle = mapping;
+  m_data = static_cast<const char *>(data);
+  m_size = size.QuadPart;
+  return true;
+}
+
+void MappedFile::close() {
+  if (m_data) {
+    UnmapViewOfFile(m_data);
+  }
+  if (m_mapping_handle) {
+    CloseHandle(m_mapping_handle);
+  }
+  if (m_file_handle) {
+    CloseHandle(m_file_handle);
+  }
+  m_data = nullptr;
+  m_size = 0;
+  m_file_handle = nullptr;
+  m_mapping_handle = nullptr;
+}
+
+#else
+
+bool MappedFile::open(const fs::path &path) {
+  close();
+  int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    spdlog::warn("Failed to open file {}", path.string());
+    return false;
+  }
+  struct stat st;
+  if (fstat(fd, &st) != 0 || st.st_size == 0) {
+    spdlog::warn("Failed to map empty file {}", path.string());
+    ::close(fd);
+    return false;
+  }
+  void *data = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  // the mapping stays valid after closing the descriptor
+  ::close(fd);
+  if (data == MAP_FAILED) {
+    spdlog::warn("Failed to map file {}", path.string());
+    return false;
+  }
+  m_data = static_cast<const char *>(data);
+  m_size = st.st_size;
+  return true;
+}
+
+void MappedFile::close() {
+  if (m_data) {
+    munmap(const_cast<char *>(m_data), m_size);
+  }
+  m_data = nullptr;
+  m_size = 0;
+}
+
+#endif
+
+std::span<const char> MappedFile::subspan(size_t offset, size_t size) const {
+  if (!m_data || offset > m_size || size > m_size - offset) {
+    return {};
+  }
+  return {m_data + offset, size};
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include <span>
+
+#include <filesystem>
+namespace fs = std::filesystem;
+
+namespace wgrd_files {
+
+/*
+ * Read-only memory mapping of a whole file.
+ *
+ * Used for the dat files, so their dictionaries and entries can be read
+ * without going through a fstream for every access.
+ * */
+class MappedFile {
+private:
+  const char *m_data = nullptr;
+  size_t m_size = 0;
+#ifdef _WIN32
+  void *m_file_handle = nullptr;
+  void *m_mapping_handle = nullptr;
+#endif
+
+public:
+  MappedFile() = default;
+  ~MappedFile();
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+  MappedFile(MappedFile &&other) noexcept;
+  MappedFile &operator=(MappedFile &&other) noexcept;
+
+  bool open(const fs::path &path);
+  void close();
+  bool is_open() const { return m_data != nullptr; }
+  const char *data() const { return m_data; }
+  size_t size() const { return m_size; }
+  // returns an empty span if the range is not inside the mapping
+  std::span<const char> subspan(size_t offset, size_t size) const;
+};
+
+} // namespace wgrd_files
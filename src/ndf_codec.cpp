@@ -0,0 +1,115 @@
+#include "ndf_codec.hpp"
+
+#include "spdlog/spdlog.h"
+
+#include <cstring>
+#include <zlib.h>
+
+using namespace wgrd_files;
+
+namespace {
+
+template <typename T> T read_le(const char *data) {
+  T ret;
+  std::memcpy(&ret, data, sizeof(T));
+  return ret;
+}
+
+template <typename T> void write_le(char *data, T value) {
+  std::memcpy(data, &value, sizeof(T));
+}
+
+bool is_ndfbin(std::span<const char> data) {
+  if (data.size() < ndfbin_header::size) {
+    return false;
+  }
+  return !std::memcmp(data.data() + ndfbin_header::magic, "EUG0", 4) &&
+         !std::memcmp(data.data() + ndfbin_header::cndf_magic, "CNDF", 4);
+}
+
+} // namespace
+
+std::optional<std::vector<char>>
+wgrd_files::decompress_ndfbin(std::span<const char> data) {
+  if (!is_ndfbin(data)) {
+    spdlog::error("decompress_ndfbin: invalid ndfbin magic");
+    return std::nullopt;
+  }
+  uint32_t compressed =
+      read_le<uint32_t>(data.data() + ndfbin_header::compressed);
+  if (compressed != ndfbin_header::compressed_flag) {
+    return std::vector<char>(data.begin(), data.end());
+  }
+  if (data.size() < ndfbin_header::size + 4) {
+    spdlog::error("decompress_ndfbin: truncated header");
+    return std::nullopt;
+  }
+  uint32_t body_size = read_le<uint32_t>(data.data() + ndfbin_header::size);
+
+  std::vector<char> ret(ndfbin_header::size + body_size);
+  std::memcpy(ret.data(), data.data(), ndfbin_header::size);
+  write_le<uint32_t>(ret.data() + ndfbin_header::compressed, 0);
+
+  // decompress directly behind the header
+  uLongf dest_len = body_size;
+  auto src = data.subspan(ndfbin_header::size + 4);
+  int err = uncompress(reinterpret_cast<Bytef *>(ret.data()) +
+                           ndfbin_header::size,
+                       &dest_len, reinterpret_cast<const Bytef *>(src.data()),
+                       src.size());
+  if (err != Z_OK) {
+    spdlog::error("decompress_ndfbin: zlib error {}", err);
+    return std::nullopt;
+  }
+  if (dest_len != body_size) {
+    spdlog::error("decompress_ndfbin: expected {} bytes, got {}", body_size,
+                  dest_len);
+    return std::nullopt;
+  }
+  return ret;
+}
+
+bool wgrd_files::compress_ndfbin(std::span<const char> data,
+                                 std::ostream &stream) {
+  if (!is_ndfbin(data)) {
+    spdlog::error("compress_ndfbin: invalid ndfbin magic");
+    return false;
+  }
+  auto body = data.subspan(ndfbin_header::size);
+
+  // nothing is written to the stream if zlib can't be initialized
+  z_stream zs = {};
+  if (deflateInit(&zs, Z_BEST_COMPRESSION) != Z_OK) {
+    spdlog::error("compress_ndfbin: deflateInit failed");
+    return false;
+  }
+
+  char header[ndfbin_header::size + 4];
+  std::memcpy(header, data.data(), ndfbin_header::size);
+  write_le<uint32_t>(header + ndfbin_header::compressed,
+                     ndfbin_header::compressed_flag);
+  write_le<uint32_t>(header + ndfbin_header::size, body.size());
+  stream.write(header, sizeof(header));
+  zs.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(body.data()));
+  zs.avail_in = body.size();
+
+  // stream the compressed data directly into the output
+  char buffer[1 << 16];
+  int err;
+  do {
+    zs.next_out = reinterpret_cast<Bytef *>(buffer);
+    zs.avail_out = sizeof(buffer);
+    err = deflate(&zs, Z_FINISH);
+    if (err == Z_STREAM_ERROR) {
+      break;
+    }
+    stream.write(buffer, sizeof(buffer) - zs.avail_out);
+  } while (err != Z_STREAM_END);
+  deflateEnd(&zs);
+
+  if (err != Z_STREAM_END) {
+    spdlog::error("compress_ndfbin: zlib error {}", err);
+    return false;
+  }
+  return stream.good();
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <ostream>
+#include <span>
+#include <vector>
+
+namespace wgrd_files {
+
+// raw offsets into the header of ndfbin files
+namespace ndfbin_header {
+constexpr size_t magic = 0x00;
+constexpr size_t cndf_magic = 0x08;
+constexpr size_t compressed = 0x0C;
+constexpr size_t footer_offset = 0x10;
+constexpr size_t header_size = 0x18;
+constexpr size_t uncompressed_size = 0x20;
+constexpr size_t size = 0x28;
+// value of the compressed field for zlib compressed bodies
+constexpr uint32_t compressed_flag = 0x80;
+} // namespace ndfbin_header
+
+/*
+ * Native replacement for wgrd_cons_parsers.(de)compress_ndfbin.
+ *
+ * Compressed ndfbins consist of the uncompressed header, the size of the
+ * uncompressed body and the zlib compressed body.
+ * */
+// returns the uncompressed ndfbin, uncompressed files are returned as is.
+// returns nullopt if the data is no valid ndfbin.
+std::optional<std::vector<char>> decompress_ndfbin(std::span<const char> data);
+// compresses the uncompressed ndfbin into the stream
+bool compress_ndfbin(std::span<const char> data, std::ostream &stream);
+
+} // namespace wgrd_files
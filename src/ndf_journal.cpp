@@ -0,0 +1,194 @@
+#include "ndf_journal.hpp"
+#include "helpers.hpp"
+
+#include "spdlog/spdlog.h"
+
+#include <cstring>
+#include <fstream>
+#include <zlib.h>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+using namespace wgrd_files;
+
+namespace {
+
+constexpr char magic[4] = {'N', 'D', 'F', 'J'};
+constexpr uint32_t version = 1;
+constexpr size_t header_size = sizeof(magic) + sizeof(version);
+// payload size, crc32 of op and payload, op
+constexpr size_t record_header_size = 4 + 4 + 1;
+
+uint32_t record_crc(NdfJournal::Op op, std::string_view payload) {
+  auto op_byte = static_cast<uint8_t>(op);
+  uLong crc = crc32(0L, &op_byte, 1);
+  // crc32 returns 0 for a null buffer instead of the running crc, which
+  // empty views may have
+  if (!payload.empty()) {
+    crc = crc32(crc, reinterpret_cast<const Bytef *>(payload.data()),
+                payload.size());
+  }
+  return crc;
+}
+
+bool sync_file(std::FILE *file) {
+  if (std::fflush(file) != 0) {
+    return false;
+  }
+#ifdef _WIN32
+  return _commit(_fileno(file)) == 0;
+#else
+  return fsync(fileno(file)) == 0;
+#endif
+}
+
+} // namespace
+
+std::optional<std::vector<NdfJournal::Record>>
+NdfJournal::open(fs::path path) {
+  close();
+  m_path = std::move(path);
+  std::error_code ec;
+  fs::create_directories(m_path.parent_path(), ec);
+
+  std::string data;
+  if (fs::exists(m_path)) {
+    std::ifstream in(m_path, std::ios::binary | std::ios::in);
+    data.resize(fs::file_size(m_path));
+    in.read(data.data(), data.size());
+    if (!in) {
+      spdlog::error("Could not read journal {}", m_path.string());
+      return std::nullopt;
+    }
+  }
+
+  std::vector<Record> records;
+  size_t good_end = header_size;
+  uint32_t file_version = 0;
+  if (data.size() >= header_size) {
+    std::memcpy(&file_version, data.data() + sizeof(magic), sizeof(version));
+  }
+  if (data.size() < header_size || std::memcmp(data.data(), magic, 4) ||
+      file_version != version) {
+    // kept for recovery, e.g. when it was written by another version
+    if (!data.empty() && back_up_file(m_path)) {
+      spdlog::error("Moved invalid journal {} to .bak", m_path.string());
+    }
+    std::ofstream out(m_path,
+                      std::ios::binary | std::ios::out | std::ios::trunc);
+    out.write(magic, sizeof(magic));
+    out.write(reinterpret_cast<const char *>(&version), sizeof(version));
+    if (!out) {
+      spdlog::error("Could not create journal {}", m_path.string());
+      return std::nullopt;
+    }
+    data.clear();
+  }
+
+  size_t pos = header_size;
+  while (pos < data.size()) {
+    if (data.size() - pos < record_header_size) {
+      break;
+    }
+    uint32_t size, crc;
+    std::memcpy(&size, data.data() + pos, 4);
+    std::memcpy(&crc, data.data() + pos + 4, 4);
+    auto op = static_cast<Op>(data[pos + 8]);
+    if (data.size() - pos - record_header_size < size) {
+      break;
+    }
+    std::string_view payload(data.data() + pos + record_header_size, size);
+    if (record_crc(op, payload) != crc) {
+      break;
+    }
+    records.push_back({op, std::string(payload)});
+    pos += record_header_size + size;
+    good_end = pos;
+  }
+  if (!data.empty() && good_end != data.size()) {
+    spdlog::warn("Journal {} ends in a torn record, dropping {} bytes",
+                 m_path.string(), data.size() - good_end);
+    fs::resize_file(m_path, good_end, ec);
+    if (ec) {
+      spdlog::error("Could not truncate journal {}: {}", m_path.string(),
+                    ec.message());
+      return std::nullopt;
+    }
+  }
+
+  m_file = std::fopen(m_path.string().c_str(), "ab");
+  if (!m_file) {
+    spdlog::error("Could not open journal {}", m_path.string());
+    return std::nullopt;
+  }
+  m_unsynced = false;
+  m_last_sync = std::chrono::steady_clock::now();
+  return records;
+}
+
+void NdfJournal::close() {
+  if (!m_file) {
+    return;
+  }
+  sync(true);
+  std::fclose(m_file);
+  m_file = nullptr;
+}
+
+bool NdfJournal::append(Op op, std::string_view payload) {
+  if (!m_file) {
+    return false;
+  }
+  char header[record_header_size];
+  uint32_t size = payload.size();
+  uint32_t crc = record_crc(op, payload);
+  std::memcpy(header, &size, 4);
+  std::memcpy(header + 4, &crc, 4);
+  header[8] = static_cast<char>(op);
+  if (std::fwrite(header, 1, sizeof(header), m_file) != sizeof(header) ||
+      std::fwrite(payload.data(), 1, payload.size(), m_file) !=
+          payload.size() ||
+      std::fflush(m_file) != 0) {
+    spdlog::error("Could not append to journal {}", m_path.string());
+    return false;
+  }
+  m_unsynced = true;
+  return true;
+}
+
+void NdfJournal::sync(bool force) {
+  if (!m_file || !m_unsynced) {
+    return;
+  }
+  auto now = std::chrono::steady_clock::now();
+  if (!force && now - m_last_sync < sync_interval) {
+    return;
+  }
+  if (!sync_file(m_file)) {
+    spdlog::warn("Could not sync journal {}", m_path.string());
+  }
+  m_unsynced = false;
+  m_last_sync = now;
+}
+
+bool NdfJournal::reset() {
+  if (!m_file) {
+    return false;
+  }
+  std::fclose(m_file);
+  m_file = nullptr;
+  std::error_code ec;
+  fs::resize_file(m_path, header_size, ec);
+  if (ec) {
+    spdlog::error("Could not reset journal {}: {}", m_path.string(),
+                  ec.message());
+    return false;
+  }
+  m_file = std::fopen(m_path.string().c_str(), "ab");
+  m_unsynced = false;
+  return m_file != nullptr;
+}
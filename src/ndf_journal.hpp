@@ -0,0 +1,68 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <filesystem>
+namespace fs = std::filesystem;
+
+namespace wgrd_files {
+
+/*
+ * Append-only log of the edits done to a ndfbin since its snapshot was saved.
+ *
+ * Every record carries its size and crc32, so a record torn by a crash is
+ * detected on open and cut off, all records before it are kept. Appends are
+ * written to the os immediately, but only synced to disk every
+ * sync_interval to keep dragging values cheap.
+ * */
+class NdfJournal {
+public:
+  enum class Op : uint8_t {
+    // payload is a serialized transaction
+    APPLY = 0,
+    UNDO = 1,
+    REDO = 2,
+    // the following transactions don't coalesce with the ones before
+    END_INTERACTION = 3,
+  };
+  struct Record {
+    Op op;
+    std::string payload;
+  };
+
+private:
+  static constexpr std::chrono::milliseconds sync_interval{500};
+
+  fs::path m_path;
+  std::FILE *m_file = nullptr;
+  bool m_unsynced = false;
+  std::chrono::steady_clock::time_point m_last_sync;
+
+public:
+  NdfJournal() = default;
+  NdfJournal(const NdfJournal &) = delete;
+  NdfJournal &operator=(const NdfJournal &) = delete;
+  ~NdfJournal() { close(); }
+
+  // opens or creates the journal, returns the intact records already in it.
+  // nullopt if the file can't be opened or isn't a journal.
+  std::optional<std::vector<Record>> open(fs::path path);
+  void close();
+  bool is_open() const { return m_file != nullptr; }
+  const fs::path &get_path() const { return m_path; }
+
+  bool append(Op op, std::string_view payload = {});
+  // syncs the appended records to disk, unless the last sync was less than
+  // sync_interval ago and force isn't set
+  void sync(bool force = false);
+  // drops all records, e.g. after the edits got saved
+  bool reset();
+};
+
+} // namespace wgrd_files
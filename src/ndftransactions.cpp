@@ -1,5 +1,15 @@
 #include "ndftransactions.hpp"
 #include "helpers.hpp"
+#include "mapped_file.hpp"
+#include "ndf_codec.hpp"
+#include "trace.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <span>
+#include <spanstream>
+#include <sstream>
+#include <zlib.h>
 
 void wgrd_files::NdfBinFile::start_parsing(fs::path vfs_path,
                                            fs::path file_path) {
@@ -7,36 +17,964 @@ void wgrd_files::NdfBinFile::start_parsing(fs::path vfs_path,
   std::vector<char> data;
   data.resize(fs::file_size(file_path));
   file.read(data.data(), data.size());
-  start_parsing(vfs_path, data);
+  start_parsing(vfs_path, std::span<const char>(data));
 }
 
 void wgrd_files::NdfBinFile::start_parsing(fs::path vfs_path,
-                                           std::vector<char> vec_data) {
+                                           std::span<const char> span_data) {
   spdlog::info("loading ndfbin from bin {}", vfs_path.string());
   ndf.clear();
+  m_generation++;
+  m_digests.clear();
+  m_object_positions_valid = false;
+  // the indexes get rebuilt after loading
+  m_changes.clear();
+  clear_history();
 
+  // no python involved, so multiple ndfbins can be parsed in parallel
+  std::optional<std::vector<char>> decompressed;
   {
-    py::gil_scoped_acquire acquire;
-    try {
-      py::object decompress_ndfbin =
-          py::module_::import("wgrd_cons_parsers.decompress_ndfbin")
-              .attr("decompress_ndfbin");
-
-      py::bytes data(vec_data.data(), vec_data.size());
-
-      py::bytes decompressed_data = decompress_ndfbin(data);
-
-      std::stringstream decompressed_stream(decompressed_data);
-      ndf.load_from_ndfbin_stream(decompressed_stream);
-    } catch (py::error_already_set &e) {
-      spdlog::error("Error parsing NDF: {}", e.what());
-    }
+    ScopedTrace trace("decompress", vfs_path.string());
+    decompressed = decompress_ndfbin(span_data);
+  }
+  if (!decompressed) {
+    spdlog::error("Error parsing NDF: could not decompress {}",
+                  vfs_path.string());
+    return;
   }
+  ScopedTrace trace("parse ndf", vfs_path.string());
+  std::ispanstream decompressed_stream(
+      std::span<char>(decompressed->data(), decompressed->size()));
+  ndf.load_from_ndfbin_stream(decompressed_stream);
 }
 
 void wgrd_files::NdfBinFile::load_from_xml_file(fs::path path, NDF_DB *db,
                                                 int ndf_id) {
   spdlog::info("Loading ndfbin from xml {}", path.string());
   ndf.clear();
+  m_generation++;
+  m_digests.clear();
+  m_object_positions_valid = false;
+  m_changes.clear();
+  clear_history();
+  // the imported xml isn't the base of the journal, it is reopened by the
+  // next checkpoint or load
+  m_journal.close();
   ndf.load_from_ndf_xml(path, db, ndf_id);
 }
+
+namespace {
+
+constexpr char snapshot_magic[4] = {'N', 'D', 'F', 'S'};
+// bump when the layout or the ndfbin writer of wgrd-tools changes
+constexpr uint32_t snapshot_version = 1;
+// magic, version, body size, crc32 of the body, flags
+constexpr size_t snapshot_header_size = 4 + 4 + 8 + 4 + 4;
+// the snapshot contains edits that are not in the dat file yet
+constexpr uint32_t snapshot_flag_modified = 1;
+
+} // namespace
+
+bool wgrd_files::NdfBinFile::load_snapshot(fs::path path, bool &modified) {
+  MappedFile file;
+  if (!file.open(path)) {
+    return false;
+  }
+  if (file.size() < snapshot_header_size ||
+      std::memcmp(file.data(), snapshot_magic, 4)) {
+    spdlog::warn("{} is not a ndf snapshot", path.string());
+    return false;
+  }
+  uint32_t version, crc, flags;
+  uint64_t body_size;
+  std::memcpy(&version, file.data() + 4, 4);
+  std::memcpy(&body_size, file.data() + 8, 8);
+  std::memcpy(&crc, file.data() + 16, 4);
+  std::memcpy(&flags, file.data() + 20, 4);
+  if (version != snapshot_version) {
+    spdlog::warn("Snapshot {} has unsupported version {}", path.string(),
+                 version);
+    return false;
+  }
+  auto body = file.subspan(snapshot_header_size, body_size);
+  if (body.size() != body_size || body_size == 0) {
+    spdlog::warn("Snapshot {} is truncated", path.string());
+    return false;
+  }
+  if (crc32(crc32(0L, nullptr, 0),
+            reinterpret_cast<const Bytef *>(body.data()),
+            body.size()) != crc) {
+    spdlog::warn("Snapshot {} is corrupt", path.string());
+    return false;
+  }
+
+  spdlog::info("loading ndfbin from snapshot {}", path.string());
+  ScopedTrace trace("parse ndf snapshot", path.string());
+  ndf.clear();
+  m_generation++;
+  m_digests.clear();
+  m_object_positions_valid = false;
+  m_changes.clear();
+  clear_history();
+  // the stream only reads, the mapping stays read only
+  std::ispanstream stream(
+      std::span<char>(const_cast<char *>(body.data()), body.size()));
+  ndf.load_from_ndfbin_stream(stream);
+  modified = flags & snapshot_flag_modified;
+  return true;
+}
+
+bool wgrd_files::NdfBinFile::save_snapshot(fs::path path, bool modified) {
+  ScopedTrace trace("write ndf snapshot", path.string());
+  std::stringstream body_stream;
+  ndf.save_as_ndfbin_stream(body_stream);
+  std::string_view body = body_stream.view();
+
+  char header[snapshot_header_size];
+  uint64_t body_size = body.size();
+  uint32_t crc = crc32(crc32(0L, nullptr, 0),
+                       reinterpret_cast<const Bytef *>(body.data()),
+                       body.size());
+  std::memcpy(header, snapshot_magic, 4);
+  std::memcpy(header + 4, &snapshot_version, 4);
+  std::memcpy(header + 8, &body_size, 8);
+  std::memcpy(header + 16, &crc, 4);
+  uint32_t flags = modified ? snapshot_flag_modified : 0;
+  std::memcpy(header + 20, &flags, 4);
+
+  // written next to the old one and swapped in, so a crash while saving
+  // never leaves a broken snapshot behind
+  fs::path tmp_path = fs::path(path) += ".tmp";
+  std::error_code ec;
+  fs::create_directories(path.parent_path(), ec);
+  {
+    std::ofstream out(tmp_path,
+                      std::ios::binary | std::ios::out | std::ios::trunc);
+    out.write(header, sizeof(header));
+    out.write(body.data(), body.size());
+    if (!out) {
+      spdlog::error("Could not write snapshot {}", tmp_path.string());
+      return false;
+    }
+  }
+  fs::rename(tmp_path, path, ec);
+  if (ec) {
+    spdlog::error("Could not replace snapshot {}: {}", path.string(),
+                  ec.message());
+    return false;
+  }
+  return true;
+}
+
+namespace {
+
+// rough size of a transaction object without its fields
+constexpr size_t transaction_overhead = 64;
+// guards against corrupt records nesting changes until the stack overflows
+constexpr size_t max_nesting_depth = 16;
+
+// object holding a single ndf property value, so it can be written as a
+// ndfbin
+constexpr const char *value_holder_class = "TTransactionValue";
+constexpr const char *value_holder_name = "TransactionValue";
+constexpr const char *value_holder_property = "Value";
+
+// NDFObject isn't copyable, the archives must not modify the visited values
+NDFObject copy_ndf_object(NDFObject &object) {
+  NDFObject ret;
+  ret.name = object.name;
+  ret.class_name = object.class_name;
+  ret.export_path = object.export_path;
+  ret.is_top_object = object.is_top_object;
+  ret.property_map = object.property_map;
+  for (auto &property : object.properties) {
+    ret.properties.push_back(property->get_copy());
+  }
+  return ret;
+}
+
+// writes the objects as a ndfbin behind the names of all objects in it. the
+// ndfbin writer resolves object references by name, so every referenced
+// object that isn't written gets an empty stand-in. loading doesn't keep the
+// names of objects that aren't exported, read_ndf_objects restores them.
+bool write_ndf_objects(wgrd_files::TransactionArchive &ar,
+                       std::vector<NDFObject> objects) {
+  NDF ndf;
+  std::vector<std::string> references;
+  for (auto &object : objects) {
+    for (auto &property : object.properties) {
+      for (auto &ref : property->get_object_references()) {
+        references.emplace_back(ref);
+      }
+    }
+    std::string name = object.name;
+    ndf.object_map.insert({std::move(name), std::move(object)});
+  }
+  for (auto &ref : references) {
+    if (!ndf.object_map.contains(ref)) {
+      NDFObject stand_in;
+      stand_in.name = ref;
+      stand_in.class_name = value_holder_class;
+      stand_in.is_top_object = false;
+      ndf.object_map.insert({ref, std::move(stand_in)});
+    }
+  }
+  std::stringstream stream;
+  try {
+    ndf.save_as_ndfbin_stream(stream);
+  } catch (const std::exception &e) {
+    spdlog::warn("Could not write ndf values of a transaction: {}", e.what());
+    return false;
+  }
+  uint32_t count = ndf.object_map.size();
+  ar.field(count);
+  for (auto &name : ndf.object_map | std::views::keys) {
+    ar.field(const_cast<std::string &>(name));
+  }
+  std::string data = std::move(stream).str();
+  ar.field(data);
+  return true;
+}
+
+// reads the first count objects written by write_ndf_objects
+std::optional<std::vector<NDFObject>>
+read_ndf_objects(wgrd_files::TransactionArchive &ar, size_t count) {
+  uint32_t name_count = 0;
+  ar.field(name_count);
+  std::vector<std::string> names;
+  for (uint32_t i = 0; i < name_count && !ar.failed(); i++) {
+    ar.field(names.emplace_back());
+  }
+  std::string data;
+  ar.field(data);
+  if (ar.failed() || names.size() < count) {
+    return std::nullopt;
+  }
+  NDF ndf;
+  try {
+    std::ispanstream stream(std::span<char>(data.data(), data.size()));
+    ndf.load_from_ndfbin_stream(stream);
+  } catch (const std::exception &e) {
+    spdlog::warn("Could not read ndf values of a transaction: {}", e.what());
+    return std::nullopt;
+  }
+  if (ndf.object_map.size() != names.size()) {
+    return std::nullopt;
+  }
+  // objects are loaded in the order they were written
+  std::unordered_map<std::string, std::string> renames;
+  size_t idx = 0;
+  for (auto &name : ndf.object_map | std::views::keys) {
+    if (name != names[idx]) {
+      renames.emplace(name, names[idx]);
+    }
+    idx++;
+  }
+  if (!renames.empty()) {
+    ndf.bulk_rename_objects(renames);
+  }
+  std::vector<NDFObject> ret;
+  for (size_t i = 0; i < count; i++) {
+    auto it = ndf.object_map.find(names[i]);
+    if (it == ndf.object_map.end()) {
+      return std::nullopt;
+    }
+    ret.push_back(std::move(it.value()));
+  }
+  return ret;
+}
+
+// a property is written as the only list item of a holder object
+bool write_ndf_property(wgrd_files::TransactionArchive &ar,
+                        std::unique_ptr<NDFProperty> &property) {
+  uint8_t present = property != nullptr;
+  ar.field(present);
+  if (!present) {
+    return true;
+  }
+  ar.field(property->property_name);
+  auto list = std::make_unique<NDFPropertyList>();
+  list->property_name = value_holder_property;
+  list->property_type = NDFPropertyType::List;
+  list->values.push_back(property->get_copy());
+  NDFObject holder;
+  holder.name = value_holder_name;
+  // the holder must not stand in for an object the value references
+  for (auto &ref : list->get_object_references()) {
+    while (ref == holder.name) {
+      holder.name += "_";
+    }
+  }
+  holder.class_name = value_holder_class;
+  holder.is_top_object = false;
+  holder.property_map[list->property_name] = 0;
+  holder.properties.push_back(std::move(list));
+  std::vector<NDFObject> objects;
+  objects.push_back(std::move(holder));
+  return write_ndf_objects(ar, std::move(objects));
+}
+
+bool read_ndf_property(wgrd_files::TransactionArchive &ar,
+                       std::unique_ptr<NDFProperty> &property) {
+  uint8_t present = 0;
+  ar.field(present);
+  if (!present) {
+    property.reset();
+    return !ar.failed();
+  }
+  std::string property_name;
+  ar.field(property_name);
+  auto objects = read_ndf_objects(ar, 1);
+  if (!objects) {
+    return false;
+  }
+  auto &holder = objects->front();
+  auto it = holder.property_map.find(value_holder_property);
+  if (it == holder.property_map.end()) {
+    return false;
+  }
+  auto &list_property = holder.properties.at(it->second);
+  if (list_property->property_type != NDFPropertyType::List) {
+    return false;
+  }
+  auto &list =
+      reinterpret_cast<std::unique_ptr<NDFPropertyList> &>(list_property);
+  if (list->values.size() != 1) {
+    return false;
+  }
+  property = std::move(list->values.front());
+  property->property_name = std::move(property_name);
+  return true;
+}
+
+// sums up the bytes of the visited fields
+class SizeArchive : public wgrd_files::TransactionArchive {
+private:
+  size_t m_size = 0;
+
+protected:
+  void write_nested(wgrd_files::NdfTransaction &transaction) override {
+    m_size += transaction.memory_usage();
+  }
+  std::unique_ptr<wgrd_files::NdfTransaction> read_nested() override {
+    fail();
+    return nullptr;
+  }
+
+public:
+  bool is_loading() const override { return false; }
+  void bytes(void *, size_t size) override { m_size += size; }
+  void string(std::string &str) override { m_size += sizeof(str) + str.size(); }
+  void ndf_object(NDFObject &object) override {
+    m_size += sizeof(object) + object.name.size() +
+              object.properties.size() * wgrd_files::ndf_property_size_estimate;
+  }
+  void ndf_property(std::unique_ptr<NDFProperty> &property) override {
+    if (property) {
+      m_size += wgrd_files::ndf_property_size_estimate;
+    }
+  }
+  size_t size() const { return m_size; }
+};
+
+// writes in native byte order, the journal is never moved between machines
+class TransactionWriter : public wgrd_files::TransactionArchive {
+private:
+  std::string &m_out;
+
+protected:
+  void write_nested(wgrd_files::NdfTransaction &transaction) override {
+    write(transaction);
+  }
+  std::unique_ptr<wgrd_files::NdfTransaction> read_nested() override {
+    fail();
+    return nullptr;
+  }
+
+public:
+  explicit TransactionWriter(std::string &out) : m_out(out) {}
+  bool is_loading() const override { return false; }
+  void bytes(void *data, size_t size) override {
+    m_out.append(static_cast<const char *>(data), size);
+  }
+  void string(std::string &str) override {
+    uint32_t size = str.size();
+    bytes(&size, sizeof(size));
+    m_out.append(str);
+  }
+  void ndf_object(NDFObject &object) override {
+    std::vector<NDFObject> objects;
+    objects.push_back(copy_ndf_object(object));
+    if (!write_ndf_objects(*this, std::move(objects))) {
+      fail();
+    }
+  }
+  void ndf_property(std::unique_ptr<NDFProperty> &property) override {
+    if (!write_ndf_property(*this, property)) {
+      fail();
+    }
+  }
+  void write(wgrd_files::NdfTransaction &transaction) {
+    auto type = static_cast<uint16_t>(transaction.get_type());
+    bytes(&type, sizeof(type));
+    transaction.fields(*this);
+  }
+};
+
+class TransactionReader : public wgrd_files::TransactionArchive {
+private:
+  std::span<const char> m_data;
+  size_t m_pos = 0;
+  size_t m_depth = 0;
+
+protected:
+  void write_nested(wgrd_files::NdfTransaction &) override { fail(); }
+  std::unique_ptr<wgrd_files::NdfTransaction> read_nested() override {
+    return read();
+  }
+
+public:
+  explicit TransactionReader(std::span<const char> data) : m_data(data) {}
+  bool is_loading() const override { return true; }
+  void bytes(void *data, size_t size) override {
+    if (failed() || m_data.size() - m_pos < size) {
+      fail();
+      std::memset(data, 0, size);
+      return;
+    }
+    std::memcpy(data, m_data.data() + m_pos, size);
+    m_pos += size;
+  }
+  void string(std::string &str) override {
+    uint32_t size = 0;
+    bytes(&size, sizeof(size));
+    if (failed() || m_data.size() - m_pos < size) {
+      fail();
+      str.clear();
+      return;
+    }
+    str.assign(m_data.data() + m_pos, size);
+    m_pos += size;
+  }
+  void ndf_object(NDFObject &object) override {
+    auto objects = read_ndf_objects(*this, 1);
+    if (!objects) {
+      fail();
+      return;
+    }
+    object = std::move(objects->front());
+  }
+  void ndf_property(std::unique_ptr<NDFProperty> &property) override {
+    if (!read_ndf_property(*this, property)) {
+      fail();
+    }
+  }
+  std::unique_ptr<wgrd_files::NdfTransaction> read() {
+    uint16_t type = 0;
+    bytes(&type, sizeof(type));
+    if (failed() || m_depth >= max_nesting_depth) {
+      fail();
+      return nullptr;
+    }
+    auto transaction = wgrd_files::create_transaction(
+        static_cast<wgrd_files::NdfTransactionType>(type));
+    if (!transaction) {
+      fail();
+      return nullptr;
+    }
+    m_depth++;
+    transaction->fields(*this);
+    m_depth--;
+    if (failed()) {
+      return nullptr;
+    }
+    return transaction;
+  }
+  bool at_end() const { return m_pos == m_data.size(); }
+};
+
+} // namespace
+
+size_t wgrd_files::NdfTransaction::memory_usage() const {
+  SizeArchive ar;
+  // measuring only reads the fields
+  const_cast<NdfTransaction *>(this)->fields(ar);
+  return transaction_overhead + ar.size();
+}
+
+std::unique_ptr<wgrd_files::NdfTransaction>
+wgrd_files::create_transaction(NdfTransactionType type) {
+  switch (type) {
+  case NdfTransactionType::AddObject:
+    return std::make_unique<NdfTransactionAddObject>();
+  case NdfTransactionType::RemoveObject:
+    return std::make_unique<NdfTransactionRemoveObject>();
+  case NdfTransactionType::CopyObject:
+    return std::make_unique<NdfTransactionCopyObject>();
+  case NdfTransactionType::ChangeObjectName:
+    return std::make_unique<NdfTransactionChangeObjectName>();
+  case NdfTransactionType::ChangeObjectExportPath:
+    return std::make_unique<NdfTransactionChangeObjectExportPath>();
+  case NdfTransactionType::ChangeObjectTopObject:
+    return std::make_unique<NdfTransactionChangeObjectTopObject>();
+  case NdfTransactionType::BulkRename:
+    return std::make_unique<NdfTransactionBulkRename>();
+  case NdfTransactionType::CoalescedSet:
+    return std::make_unique<NdfTransactionCoalescedSet>();
+  case NdfTransactionType::ChangeProperty_Bool:
+    return std::make_unique<NdfTransactionChangeProperty_Bool>();
+  case NdfTransactionType::ChangeProperty_UInt8:
+    return std::make_unique<NdfTransactionChangeProperty_UInt8>();
+  case NdfTransactionType::ChangeProperty_UInt16:
+    return std::make_unique<NdfTransactionChangeProperty_UInt16>();
+  case NdfTransactionType::ChangeProperty_Int16:
+    return std::make_unique<NdfTransactionChangeProperty_Int16>();
+  case NdfTransactionType::ChangeProperty_Int32:
+    return std::make_unique<NdfTransactionChangeProperty_Int32>();
+  case NdfTransactionType::ChangeProperty_UInt32:
+    return std::make_unique<NdfTransactionChangeProperty_UInt32>();
+  case NdfTransactionType::ChangeProperty_Float32:
+    return std::make_unique<NdfTransactionChangeProperty_Float32>();
+  case NdfTransactionType::ChangeProperty_Float64:
+    return std::make_unique<NdfTransactionChangeProperty_Float64>();
+  case NdfTransactionType::ChangeProperty_String:
+    return std::make_unique<NdfTransactionChangeProperty_String>();
+  case NdfTransactionType::ChangeProperty_WideString:
+    return std::make_unique<NdfTransactionChangeProperty_WideString>();
+  case NdfTransactionType::ChangeProperty_GUID:
+    return std::make_unique<NdfTransactionChangeProperty_GUID>();
+  case NdfTransactionType::ChangeProperty_LocalisationHash:
+    return std::make_unique<NdfTransactionChangeProperty_LocalisationHash>();
+  case NdfTransactionType::ChangeProperty_Hash:
+    return std::make_unique<NdfTransactionChangeProperty_Hash>();
+  case NdfTransactionType::ChangeProperty_PathReference:
+    return std::make_unique<NdfTransactionChangeProperty_PathReference>();
+  case NdfTransactionType::ChangeProperty_ObjectReference:
+    return std::make_unique<NdfTransactionChangeProperty_ObjectReference>();
+  case NdfTransactionType::ChangeProperty_ImportReference:
+    return std::make_unique<NdfTransactionChangeProperty_ImportReference>();
+  case NdfTransactionType::ChangeProperty_F32_vec2:
+    return std::make_unique<NdfTransactionChangeProperty_F32_vec2>();
+  case NdfTransactionType::ChangeProperty_F32_vec3:
+    return std::make_unique<NdfTransactionChangeProperty_F32_vec3>();
+  case NdfTransactionType::ChangeProperty_F32_vec4:
+    return std::make_unique<NdfTransactionChangeProperty_F32_vec4>();
+  case NdfTransactionType::ChangeProperty_Color:
+    return std::make_unique<NdfTransactionChangeProperty_Color>();
+  case NdfTransactionType::ChangeProperty_S32_vec2:
+    return std::make_unique<NdfTransactionChangeProperty_S32_vec2>();
+  case NdfTransactionType::ChangeProperty_S32_vec3:
+    return std::make_unique<NdfTransactionChangeProperty_S32_vec3>();
+  case NdfTransactionType::ChangeProperty_AddListItem:
+    return std::make_unique<NdfTransactionChangeProperty_AddListItem>();
+  case NdfTransactionType::ChangeProperty_RemoveListItem:
+    return std::make_unique<NdfTransactionChangeProperty_RemoveListItem>();
+  case NdfTransactionType::ChangeProperty_ChangeListItem:
+    return std::make_unique<NdfTransactionChangeProperty_ChangeListItem>();
+  case NdfTransactionType::ChangeProperty_AddMapItem:
+    return std::make_unique<NdfTransactionChangeProperty_AddMapItem>();
+  case NdfTransactionType::ChangeProperty_RemoveMapItem:
+    return std::make_unique<NdfTransactionChangeProperty_RemoveMapItem>();
+  case NdfTransactionType::ChangeProperty_ChangeMapItem:
+    return std::make_unique<NdfTransactionChangeProperty_ChangeMapItem>();
+  case NdfTransactionType::ChangeProperty_ChangePairItem:
+    return std::make_unique<NdfTransactionChangeProperty_ChangePairItem>();
+  }
+  return nullptr;
+}
+
+std::optional<std::string>
+wgrd_files::serialize_transaction(NdfTransaction &transaction) {
+  if (!transaction.is_serializable()) {
+    return std::nullopt;
+  }
+  std::string ret;
+  TransactionWriter writer(ret);
+  writer.write(transaction);
+  if (writer.failed()) {
+    return std::nullopt;
+  }
+  return ret;
+}
+
+std::unique_ptr<wgrd_files::NdfTransaction>
+wgrd_files::deserialize_transaction(std::span<const char> data) {
+  TransactionReader reader(data);
+  auto ret = reader.read();
+  if (!ret || !reader.at_end()) {
+    return nullptr;
+  }
+  return ret;
+}
+
+wgrd_files::NdfBinFile::~NdfBinFile() { clear_spilled(); }
+
+void wgrd_files::NdfBinFile::rebuild_object_positions() {
+  m_object_positions.assign(m_symbols.size(), no_object_position);
+  uint32_t position = 0;
+  for (auto &object_name : ndf.object_map | std::views::keys) {
+    Symbol symbol = m_symbols.intern(object_name);
+    if (symbol >= m_object_positions.size()) {
+      m_object_positions.resize(symbol + 1, no_object_position);
+    }
+    m_object_positions[symbol] = position++;
+  }
+  m_object_positions_valid = true;
+}
+
+std::optional<size_t>
+wgrd_files::NdfBinFile::find_object_position(Symbol name) {
+  // the second try only happens if an object moved without reporting a
+  // change, e.g. because a transaction threw halfway through
+  for (int tries = 0; tries < 2; tries++) {
+    if (!m_object_positions_valid) {
+      rebuild_object_positions();
+    }
+    if (name >= m_object_positions.size() ||
+        m_object_positions[name] == no_object_position) {
+      return std::nullopt;
+    }
+    size_t position = m_object_positions[name];
+    if (position < ndf.object_map.size() &&
+        ndf.object_map.nth(position).key() == m_symbols.str(name)) {
+      return position;
+    }
+    m_object_positions_valid = false;
+  }
+  return std::nullopt;
+}
+
+void wgrd_files::NdfBinFile::check_object_positions(size_t first_change) {
+  for (size_t i = first_change; i < m_changes.size(); i++) {
+    if (m_changes[i].kind != NdfChange::Kind::CHANGE_OBJECT) {
+      m_object_positions_valid = false;
+      return;
+    }
+  }
+}
+
+void wgrd_files::NdfBinFile::invalidate_digests(size_t first_change) {
+  for (size_t i = first_change; i < m_changes.size(); i++) {
+    auto &change = m_changes[i];
+    if (change.kind == NdfChange::Kind::RENAME_OBJECT) {
+      m_digests.clear();
+      return;
+    }
+    if (auto symbol = m_symbols.find(change.object_name)) {
+      m_digests.invalidate(symbol.value());
+    }
+  }
+}
+
+void wgrd_files::NdfBinFile::set_history_budget(size_t max_entries,
+                                                size_t max_bytes,
+                                                fs::path spill_path) {
+  m_history_max_entries = max_entries;
+  m_history_max_bytes = max_bytes;
+  if (spill_path != m_spill_path) {
+    clear_spilled();
+    m_spill_path = std::move(spill_path);
+    std::error_code ec;
+    fs::create_directories(m_spill_path.parent_path(), ec);
+    // a journal left behind by an earlier session doesn't belong to this
+    // history
+    fs::remove(m_spill_path, ec);
+  }
+  enforce_history_budget();
+}
+
+void wgrd_files::NdfBinFile::enforce_history_budget() {
+  auto over_budget = [this]() {
+    return applied_transactions.size() + undone_transactions.size() >
+               m_history_max_entries ||
+           m_history_bytes > m_history_max_bytes;
+  };
+  std::vector<std::unique_ptr<NdfTransaction>> evicted;
+  while (over_budget() && !applied_transactions.empty()) {
+    m_history_bytes -= applied_transactions.front()->history_bytes;
+    evicted.push_back(std::move(applied_transactions.front()));
+    applied_transactions.pop_front();
+  }
+  if (!evicted.empty()) {
+    spill(std::move(evicted));
+  }
+  // only happens after undoing far into the journal or if undo steps
+  // couldn't be spilled, the redo steps furthest away are dropped
+  size_t dropped = 0;
+  while (over_budget() && !undone_transactions.empty()) {
+    m_history_bytes -= undone_transactions.front()->history_bytes;
+    undone_transactions.pop_front();
+    dropped++;
+  }
+  if (dropped > 0) {
+    spdlog::debug("Undo history budget exceeded, dropped {} redo steps",
+                  dropped);
+  }
+  // the journaled steps are the newest, dropped steps are the oldest
+  m_journaled_applied = std::min(
+      m_journaled_applied, applied_transactions.size() + m_spilled.size());
+  m_journaled_undone =
+      std::min(m_journaled_undone, undone_transactions.size());
+}
+
+void wgrd_files::NdfBinFile::spill(
+    std::vector<std::unique_ptr<NdfTransaction>> transactions) {
+  if (m_spill_path.empty()) {
+    // without a journal the budget is a hard limit
+    return;
+  }
+  uint64_t offset = 0;
+  if (!m_spilled.empty()) {
+    offset = m_spilled.back().offset + m_spilled.back().size;
+  }
+  std::string data;
+  std::vector<SpillRecord> records;
+  size_t written = 0;
+  for (; written < transactions.size(); written++) {
+    auto record = serialize_transaction(*transactions[written]);
+    if (!record) {
+      spdlog::warn("Undo step for {} can't be written to {}, keeping {} undo "
+                   "steps in memory",
+                   transactions[written]->object_name, m_spill_path.string(),
+                   transactions.size() - written);
+      break;
+    }
+    records.push_back({offset, static_cast<uint32_t>(record->size())});
+    offset += record->size();
+    data += record.value();
+  }
+
+  // writes at the end of the known records instead of appending, a failed
+  // truncation in page_in leaves stale bytes behind
+  if (!records.empty()) {
+    std::fstream out;
+    if (fs::exists(m_spill_path)) {
+      out.open(m_spill_path, std::ios::binary | std::ios::in | std::ios::out);
+    } else {
+      out.open(m_spill_path, std::ios::binary | std::ios::out);
+    }
+    out.seekp(records.front().offset);
+    out.write(data.data(), data.size());
+    if (out) {
+      m_spilled.insert(m_spilled.end(), records.begin(), records.end());
+    } else {
+      spdlog::error("Could not write undo journal {}, keeping the undo steps "
+                    "in memory",
+                    m_spill_path.string());
+      written = 0;
+    }
+  }
+
+  // the older steps are only undone after these, so these stay in memory
+  // even if that exceeds the budget. they are tried again on the next
+  // eviction.
+  for (size_t i = transactions.size(); i > written; i--) {
+    m_history_bytes += transactions[i - 1]->history_bytes;
+    applied_transactions.push_front(std::move(transactions[i - 1]));
+  }
+}
+
+std::unique_ptr<wgrd_files::NdfTransaction>
+wgrd_files::NdfBinFile::page_in() {
+  if (m_spilled.empty()) {
+    return nullptr;
+  }
+  SpillRecord record = m_spilled.back();
+  std::vector<char> data(record.size);
+  std::unique_ptr<NdfTransaction> ret;
+  {
+    std::ifstream in(m_spill_path, std::ios::binary | std::ios::in);
+    in.seekg(record.offset);
+    in.read(data.data(), data.size());
+    if (in) {
+      ret = deserialize_transaction(data);
+    }
+  }
+  if (!ret) {
+    spdlog::error("Could not read undo journal {}, dropping older undo steps",
+                  m_spill_path.string());
+    clear_spilled();
+    return nullptr;
+  }
+  m_spilled.pop_back();
+  std::error_code ec;
+  fs::resize_file(m_spill_path, record.offset, ec);
+  if (ec) {
+    spdlog::debug("Could not truncate undo journal {}: {}",
+                  m_spill_path.string(), ec.message());
+  }
+  return ret;
+}
+
+void wgrd_files::NdfBinFile::clear_spilled() {
+  m_spilled.clear();
+  m_journaled_applied =
+      std::min(m_journaled_applied, applied_transactions.size());
+  if (!m_spill_path.empty()) {
+    std::error_code ec;
+    fs::remove(m_spill_path, ec);
+  }
+}
+
+void wgrd_files::NdfBinFile::clear_history() {
+  applied_transactions.clear();
+  undone_transactions.clear();
+  m_history_bytes = 0;
+  m_coalesce_back = false;
+  m_journaled_applied = 0;
+  m_journaled_undone = 0;
+  clear_spilled();
+}
+
+std::optional<std::string>
+wgrd_files::NdfBinFile::journal_payload(NdfJournal::Op op,
+                                        NdfTransaction &transaction) {
+  // undo and redo records restore the transaction with its undo state
+  bool restorable = op == NdfJournal::Op::APPLY
+                        ? transaction.is_replayable()
+                        : transaction.is_serializable();
+  std::optional<std::string> ret;
+  if (restorable) {
+    ret = serialize_transaction(transaction);
+  }
+  if (!ret) {
+    // the journal can't hold edits after this one, they are only kept by a
+    // snapshot
+    spdlog::warn("Can't journal a change of {} to {}, requesting a snapshot",
+                 transaction.object_name, m_journal.get_path().string());
+    m_journal_suspended = true;
+    m_checkpoint_requested = true;
+  }
+  return ret;
+}
+
+void wgrd_files::NdfBinFile::journal(NdfJournal::Op op,
+                                     std::string_view payload) {
+  if (!is_journaling()) {
+    return;
+  }
+  if (!m_journal.append(op, payload)) {
+    m_journal_suspended = true;
+  }
+}
+
+size_t wgrd_files::NdfBinFile::open_journal(fs::path path, bool replay) {
+  m_journal_suspended = false;
+  m_journaled_applied = 0;
+  m_journaled_undone = 0;
+  auto records = m_journal.open(std::move(path));
+  if (!records) {
+    return 0;
+  }
+  if (!replay && !records->empty()) {
+    // the edits were done to a snapshot that couldn't be loaded, they are
+    // kept for recovery instead of being dropped
+    m_journal.close();
+    spdlog::error("Journal {} holds {} edits that don't apply to the loaded "
+                  "file",
+                  m_journal.get_path().string(), records->size());
+    auto bak_path = back_up_file(m_journal.get_path());
+    if (!bak_path || !m_journal.open(m_journal.get_path())) {
+      // keeps the records on disk, edits aren't journaled until the next
+      // checkpoint
+      m_journal_suspended = true;
+      return 0;
+    }
+  }
+  if (!replay || records->empty()) {
+    m_journal.reset();
+    return 0;
+  }
+
+  auto start = std::chrono::steady_clock::now();
+  m_replaying = true;
+  size_t replayed = 0;
+  try {
+    for (auto &record : records.value()) {
+      switch (record.op) {
+      case NdfJournal::Op::APPLY: {
+        auto transaction = deserialize_transaction(record.payload);
+        if (!transaction) {
+          throw std::runtime_error("corrupt transaction");
+        }
+        apply_transaction(std::move(transaction));
+        break;
+      }
+      case NdfJournal::Op::UNDO:
+        if (!record.payload.empty()) {
+          // done before the checkpoint, the snapshot holds it applied
+          auto transaction = deserialize_transaction(record.payload);
+          if (!transaction) {
+            throw std::runtime_error("corrupt transaction");
+          }
+          account_history(*transaction);
+          applied_transactions.push_back(std::move(transaction));
+        } else if (m_journaled_applied == 0) {
+          throw std::runtime_error("nothing to undo");
+        }
+        undo_transaction();
+        break;
+      case NdfJournal::Op::REDO:
+        if (!record.payload.empty()) {
+          auto transaction = deserialize_transaction(record.payload);
+          if (!transaction) {
+            throw std::runtime_error("corrupt transaction");
+          }
+          account_history(*transaction);
+          undone_transactions.push_back(std::move(transaction));
+        } else if (m_journaled_undone == 0) {
+          throw std::runtime_error("nothing to redo");
+        }
+        redo_transaction();
+        break;
+      case NdfJournal::Op::END_INTERACTION:
+        end_interaction();
+        break;
+      default:
+        throw std::runtime_error(
+            std::format("unknown op {}", static_cast<int>(record.op)));
+      }
+      replayed++;
+    }
+  } catch (const std::exception &e) {
+    spdlog::error("Replaying journal {} stopped after {} of {} records: {}",
+                  m_journal.get_path().string(), replayed, records->size(),
+                  e.what());
+    // the loaded ndf doesn't match the journal anymore, appending to it
+    // would make it unreplayable
+    m_journal_suspended = true;
+    // the next checkpoint drops the records that weren't replayed
+    std::error_code ec;
+    fs::path bak_path = append_ext(m_journal.get_path(), ".bak");
+    fs::copy_file(m_journal.get_path(), bak_path,
+                  fs::copy_options::overwrite_existing, ec);
+    if (ec) {
+      spdlog::error("Could not copy journal to {}: {}", bak_path.string(),
+                    ec.message());
+    } else {
+      spdlog::error("Kept a copy of the journal in {}", bak_path.string());
+    }
+  }
+  m_replaying = false;
+  // the indexes get rebuilt after loading
+  m_changes.clear();
+  spdlog::info("Replayed {} journal records in {}ms", replayed,
+               std::chrono::duration_cast<std::chrono::milliseconds>(
+                   std::chrono::steady_clock::now() - start)
+                   .count());
+  return replayed;
+}
+
+void wgrd_files::NdfBinFile::checkpoint_journal() {
+  m_journal_suspended = false;
+  m_checkpoint_requested = false;
+  // the history is kept, but none of it is in the journal anymore
+  m_journaled_applied = 0;
+  m_journaled_undone = 0;
+  // a replay starts without the transaction before, it can't be merged into
+  m_coalesce_back = false;
+  if (!m_journal.is_open() && !m_journal.get_path().empty()) {
+    m_journal.open(m_journal.get_path());
+  }
+  m_journal.reset();
+}
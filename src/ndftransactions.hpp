@@ -1,11 +1,17 @@
 #pragma once
 
+#include <atomic>
 #include <cctype>
 #include <iterator>
 #include <memory>
 
+#include <deque>
 #include <optional>
 #include <pugixml.hpp>
+#include <span>
+#include <type_traits>
+#include <typeinfo>
+#include <utility>
 
 #include <iterator>
 
@@ -19,19 +25,157 @@ namespace py = pybind11;
 
 #include "helpers.hpp"
 #include "ndf.hpp"
+#include "ndf_codec.hpp"
+#include "ndf_journal.hpp"
+#include "object_digests.hpp"
+#include "symbol_table.hpp"
 
 #include "ndf_db.hpp"
 
 #include <chrono>
+#include <limits>
 #include <numeric>
 
 namespace wgrd_files {
 
+// describes what a transaction changed, so indexes over the ndf can be updated
+// without rebuilding them
+struct NdfChange {
+  enum class Kind {
+    ADD_OBJECT,
+    REMOVE_OBJECT,
+    // object_name is the old name, new_name the new one
+    RENAME_OBJECT,
+    // properties, export path or top object state of an object changed
+    CHANGE_OBJECT,
+  };
+  Kind kind;
+  std::string object_name;
+  std::string new_name = "";
+  bool operator==(const NdfChange &other) const = default;
+};
+
+// stored in the undo journal, so existing values must never change
+enum class NdfTransactionType : uint16_t {
+  AddObject = 0,
+  RemoveObject = 1,
+  CopyObject = 2,
+  ChangeObjectName = 3,
+  ChangeObjectExportPath = 4,
+  ChangeObjectTopObject = 5,
+  BulkRename = 6,
+  CoalescedSet = 7,
+  ChangeProperty_Bool = 8,
+  ChangeProperty_UInt8 = 9,
+  ChangeProperty_UInt16 = 10,
+  ChangeProperty_Int16 = 11,
+  ChangeProperty_Int32 = 12,
+  ChangeProperty_UInt32 = 13,
+  ChangeProperty_Float32 = 14,
+  ChangeProperty_Float64 = 15,
+  ChangeProperty_String = 16,
+  ChangeProperty_WideString = 17,
+  ChangeProperty_GUID = 18,
+  ChangeProperty_LocalisationHash = 19,
+  ChangeProperty_Hash = 20,
+  ChangeProperty_PathReference = 21,
+  ChangeProperty_ObjectReference = 22,
+  ChangeProperty_ImportReference = 23,
+  ChangeProperty_F32_vec2 = 24,
+  ChangeProperty_F32_vec3 = 25,
+  ChangeProperty_F32_vec4 = 26,
+  ChangeProperty_Color = 27,
+  ChangeProperty_S32_vec2 = 28,
+  ChangeProperty_S32_vec3 = 29,
+  ChangeProperty_AddListItem = 30,
+  ChangeProperty_RemoveListItem = 31,
+  ChangeProperty_ChangeListItem = 32,
+  ChangeProperty_AddMapItem = 33,
+  ChangeProperty_RemoveMapItem = 34,
+  ChangeProperty_ChangeMapItem = 35,
+  ChangeProperty_ChangePairItem = 36,
+};
+
+struct NdfTransaction;
+
+// visits the state of a transaction, used to measure it and to write it to or
+// read it from the undo journal
+class TransactionArchive {
+private:
+  bool m_failed = false;
+
+protected:
+  virtual void write_nested(NdfTransaction &transaction) = 0;
+  virtual std::unique_ptr<NdfTransaction> read_nested() = 0;
+
+public:
+  virtual ~TransactionArchive() = default;
+  virtual bool is_loading() const = 0;
+  virtual void bytes(void *data, size_t size) = 0;
+  virtual void string(std::string &str) = 0;
+  // ndf objects and properties are stored with the ndfbin writer of the
+  // snapshots, properties may be null
+  virtual void ndf_object(NDFObject &object) = 0;
+  virtual void ndf_property(std::unique_ptr<NDFProperty> &property) = 0;
+  void fail() { m_failed = true; }
+  bool failed() const { return m_failed; }
+
+  template <typename T>
+    requires std::is_arithmetic_v<T>
+  void field(T &value) {
+    bytes(&value, sizeof(T));
+  }
+  void field(std::string &value) { string(value); }
+  void field(NDFObject &value) { ndf_object(value); }
+  void field(std::unique_ptr<NDFProperty> &value) { ndf_property(value); }
+  // a transaction owned by another one, stored with its type
+  template <typename T> void nested(std::unique_ptr<T> &value) {
+    if (!is_loading()) {
+      if (!value) {
+        fail();
+        return;
+      }
+      write_nested(*value);
+      return;
+    }
+    auto loaded = read_nested();
+    auto *ptr = dynamic_cast<T *>(loaded.get());
+    if (!ptr) {
+      fail();
+      return;
+    }
+    loaded.release();
+    value.reset(ptr);
+  }
+};
+
+// ndf properties can't be measured, this is a rough average including the
+// nested values of lists and maps
+constexpr size_t ndf_property_size_estimate = 256;
+
 struct NdfTransaction {
   std::string object_name;
+  // what the transaction was accounted with in the undo history budget,
+  // memory_usage changes while it moves between undone and applied
+  size_t history_bytes = 0;
   virtual ~NdfTransaction() = default;
   virtual void apply(NDF &ndf) = 0;
   virtual void undo(NDF &ndf) = 0;
+  // appends the changes done by apply (or undo if undo is set)
+  virtual void get_changes(std::vector<NdfChange> &changes, bool undo) const {
+    changes.push_back({NdfChange::Kind::CHANGE_OBJECT, object_name});
+  }
+  virtual NdfTransactionType get_type() const = 0;
+  // visits all members needed to apply and undo the transaction, overrides
+  // visit the members of their base first
+  virtual void fields(TransactionArchive &ar) { ar.field(object_name); }
+  // false if fields() can't capture the transaction
+  virtual bool is_serializable() const { return true; }
+  // true if apply works on a transaction restored from fields(), even if
+  // undo doesn't. these can be replayed from the journal.
+  virtual bool is_replayable() const { return is_serializable(); }
+  // approximate heap and object size, for the undo history budget
+  virtual size_t memory_usage() const;
 };
 
 struct NdfTransactionAddObject : public NdfTransaction {
@@ -43,6 +187,9 @@ struct NdfTransactionAddObject : public NdfTransaction {
   void undo(NDF &ndf) override {
     //
   }
+  NdfTransactionType get_type() const override {
+    return NdfTransactionType::AddObject;
+  }
 };
 
 struct NdfTransactionRemoveObject : public NdfTransaction {
@@ -62,6 +209,18 @@ struct NdfTransactionRemoveObject : public NdfTransaction {
     // we need to move the object back into the object_map
     ndf.object_map.insert({removed_object.name, std::move(removed_object)});
   }
+  void get_changes(std::vector<NdfChange> &changes, bool undo) const override {
+    changes.push_back({undo ? NdfChange::Kind::ADD_OBJECT
+                            : NdfChange::Kind::REMOVE_OBJECT,
+                       object_name});
+  }
+  NdfTransactionType get_type() const override {
+    return NdfTransactionType::RemoveObject;
+  }
+  void fields(TransactionArchive &ar) override {
+    NdfTransaction::fields(ar);
+    ar.field(removed_object);
+  }
 };
 
 struct NdfTransactionCopyObject : public NdfTransaction {
@@ -80,6 +239,18 @@ struct NdfTransactionCopyObject : public NdfTransaction {
                       new_object_name, object_name));
     }
   }
+  void get_changes(std::vector<NdfChange> &changes, bool undo) const override {
+    changes.push_back({undo ? NdfChange::Kind::REMOVE_OBJECT
+                            : NdfChange::Kind::ADD_OBJECT,
+                       new_object_name});
+  }
+  NdfTransactionType get_type() const override {
+    return NdfTransactionType::CopyObject;
+  }
+  void fields(TransactionArchive &ar) override {
+    NdfTransaction::fields(ar);
+    ar.field(new_object_name);
+  }
 };
 
 struct NdfTransactionChangeObjectName : public NdfTransaction {
@@ -102,6 +273,20 @@ struct NdfTransactionChangeObjectName : public NdfTransaction {
                       name, object_name));
     }
   }
+  void get_changes(std::vector<NdfChange> &changes, bool undo) const override {
+    if (undo) {
+      changes.push_back({NdfChange::Kind::RENAME_OBJECT, name, object_name});
+    } else {
+      changes.push_back({NdfChange::Kind::RENAME_OBJECT, object_name, name});
+    }
+  }
+  NdfTransactionType get_type() const override {
+    return NdfTransactionType::ChangeObjectName;
+  }
+  void fields(TransactionArchive &ar) override {
+    NdfTransaction::fields(ar);
+    ar.field(name);
+  }
 };
 
 struct NdfTransactionChangeObjectExportPath : public NdfTransaction {
@@ -114,6 +299,14 @@ struct NdfTransactionChangeObjectExportPath : public NdfTransaction {
   void undo(NDF &ndf) override {
     ndf.get_object(object_name).export_path = previous_export_path;
   }
+  NdfTransactionType get_type() const override {
+    return NdfTransactionType::ChangeObjectExportPath;
+  }
+  void fields(TransactionArchive &ar) override {
+    NdfTransaction::fields(ar);
+    ar.field(export_path);
+    ar.field(previous_export_path);
+  }
 };
 
 struct NdfTransactionChangeObjectTopObject : public NdfTransaction {
@@ -126,6 +319,14 @@ struct NdfTransactionChangeObjectTopObject : public NdfTransaction {
   void undo(NDF &ndf) override {
     ndf.get_object(object_name).is_top_object = previous_top_object;
   }
+  NdfTransactionType get_type() const override {
+    return NdfTransactionType::ChangeObjectTopObject;
+  }
+  void fields(TransactionArchive &ar) override {
+    NdfTransaction::fields(ar);
+    ar.field(top_object);
+    ar.field(previous_top_object);
+  }
 };
 
 // since bulk renaming can be very resource intensive
@@ -143,6 +344,38 @@ struct NdfTransactionBulkRename : public NdfTransaction {
     }
     ndf.bulk_rename_objects(undos);
   }
+  void get_changes(std::vector<NdfChange> &changes, bool undo) const override {
+    for (auto &[old_name, new_name] : renames) {
+      if (undo) {
+        changes.push_back({NdfChange::Kind::RENAME_OBJECT, new_name, old_name});
+      } else {
+        changes.push_back({NdfChange::Kind::RENAME_OBJECT, old_name, new_name});
+      }
+    }
+  }
+  NdfTransactionType get_type() const override {
+    return NdfTransactionType::BulkRename;
+  }
+  void fields(TransactionArchive &ar) override {
+    NdfTransaction::fields(ar);
+    uint32_t count = renames.size();
+    ar.field(count);
+    if (!ar.is_loading()) {
+      for (auto &[old_name, new_name] : renames) {
+        // writing archives don't modify the value
+        ar.field(const_cast<std::string &>(old_name));
+        ar.field(new_name);
+      }
+      return;
+    }
+    renames.clear();
+    for (uint32_t i = 0; i < count && !ar.failed(); i++) {
+      std::string old_name, new_name;
+      ar.field(old_name);
+      ar.field(new_name);
+      renames.emplace(std::move(old_name), std::move(new_name));
+    }
+  }
 };
 
 struct NdfTransactionChangeProperty : public NdfTransaction {
@@ -159,9 +392,50 @@ struct NdfTransactionChangeProperty : public NdfTransaction {
   }
   virtual void apply_property(std::unique_ptr<NDFProperty> &prop) = 0;
   virtual void undo_property(std::unique_ptr<NDFProperty> &prop) = 0;
+  // true if both set the same value to an absolute value, consecutive sets of
+  // the same target can be coalesced into a single undo step
+  virtual bool same_target(const NdfTransactionChangeProperty &other) const {
+    return false;
+  }
+  void fields(TransactionArchive &ar) override {
+    NdfTransaction::fields(ar);
+    ar.field(property_name);
+  }
+};
+
+// changes setting a property to an absolute value. Undoing the first of
+// several consecutive sets restores the original value, so they can be
+// coalesced into a single undo step.
+struct NdfTransactionSetProperty : public NdfTransactionChangeProperty {
+  bool same_target(const NdfTransactionChangeProperty &other) const override {
+    return typeid(*this) == typeid(other) && object_name == other.object_name &&
+           property_name == other.property_name;
+  }
 };
 
-struct NdfTransactionChangeProperty_Bool : public NdfTransactionChangeProperty {
+// consecutive sets of the same property during one ui interaction, e.g.
+// dragging a value, also when the value is an item of a list, map or pair.
+// undo restores the value before the first set, apply sets the value of the
+// last one.
+struct NdfTransactionCoalescedSet : public NdfTransaction {
+  std::unique_ptr<NdfTransactionChangeProperty> first;
+  std::unique_ptr<NdfTransactionChangeProperty> last;
+  void apply(NDF &ndf) override { last->apply(ndf); }
+  void undo(NDF &ndf) override { first->undo(ndf); }
+  NdfTransactionType get_type() const override {
+    return NdfTransactionType::CoalescedSet;
+  }
+  bool is_serializable() const override {
+    return first->is_serializable() && last->is_serializable();
+  }
+  void fields(TransactionArchive &ar) override {
+    NdfTransaction::fields(ar);
+    ar.nested(first);
+    ar.nested(last);
+  }
+};
+
+struct NdfTransactionChangeProperty_Bool : public NdfTransactionSetProperty {
   bool value;
   bool previous_value;
   void apply_property(std::unique_ptr<NDFProperty> &prop) override {
@@ -175,10 +449,18 @@ struct NdfTransactionChangeProperty_Bool : public NdfTransactionChangeProperty {
     auto &property = reinterpret_cast<std::unique_ptr<NDFPropertyBool> &>(prop);
     property->value = previous_value;
   }
+  NdfTransactionType get_type() const override {
+    return NdfTransactionType::ChangeProperty_Bool;
+  }
+  void fields(TransactionArchive &ar) override {
+    NdfTransactionChangeProperty::fields(ar);
+    ar.field(value);
+    ar.field(previous_value);
+  }
 };
 
 struct NdfTransactionChangeProperty_UInt8
-    : public NdfTransactionChangeProperty {
+    : public NdfTransactionSetProperty {
   int8_t value;
   int8_t previous_value;
   void apply_property(std::unique_ptr<NDFProperty> &prop) override {
@@ -194,10 +476,18 @@ struct NdfTransactionChangeProperty_UInt8
         reinterpret_cast<std::unique_ptr<NDFPropertyUInt8> &>(prop);
     property->value = previous_value;
   }
+  NdfTransactionType get_type() const override {
+    return NdfTransactionType::ChangeProperty_UInt8;
+  }
+  void fields(TransactionArchive &ar) override {
+    NdfTransactionChangeProperty::fields(ar);
+    ar.field(value);
+    ar.field(previous_value);
+  }
 };
 
 struct NdfTransactionChangeProperty_UInt16
-    : public NdfTransactionChangeProperty {
+    : public NdfTransactionSetProperty {
   uint16_t value;
   uint16_t previous_value;
   void apply_property(std::unique_ptr<NDFProperty> &prop) override {
@@ -213,10 +503,18 @@ struct NdfTransactionChangeProperty_UInt16
         reinterpret_cast<std::unique_ptr<NDFPropertyUInt16> &>(prop);
     property->value = previous_value;
   }
+  NdfTransactionType get_type() const override {
+    return NdfTransactionType::ChangeProperty_UInt16;
+  }
+  void fields(TransactionArchive &ar) override {
+    NdfTransactionChangeProperty::fields(ar);
+    ar.field(value);
+    ar.field(previous_value);
+  }
 };
 
 struct NdfTransactionChangeProperty_Int16
-    : public NdfTransactionChangeProperty {
+    : public NdfTransactionSetProperty {
   uint16_t value;
   uint16_t previous_value;
   void apply_property(std::unique_ptr<NDFProperty> &prop) override {
@@ -232,10 +530,18 @@ struct NdfTransactionChangeProperty_Int16
         reinterpret_cast<std::unique_ptr<NDFPropertyInt16> &>(prop);
     property->value = previous_value;
   }
+  NdfTransactionType get_type() const override {
+    return NdfTransactionType::ChangeProperty_Int16;
+  }
+  void fields(TransactionArchive &ar) override {
+    NdfTransactionChangeProperty::fields(ar);
+    ar.field(value);
+    ar.field(previous_value);
+  }
 };
 
 struct NdfTransactionChangeProperty_Int32
-    : public NdfTransactionChangeProperty {
+    : public NdfTransactionSetProperty {
   int32_t value;
   int32_t previous_value;
   void apply_property(std::unique_ptr<NDFProperty> &prop) override {
@@ -251,10 +557,18 @@ struct NdfTransactionChangeProperty_Int32
         reinterpret_cast<std::unique_ptr<NDFPropertyInt32> &>(prop);
     property->value = previous_value;
   }
+  NdfTransactionType get_type() const override {
+    return NdfTransactionType::ChangeProperty_Int32;
+  }
+  void fields(TransactionArchive &ar) override {
+    NdfTransactionChangeProperty::fields(ar);
+    ar.field(value);
+    ar.field(previous_value);
+  }
 };
 
 struct NdfTransactionChangeProperty_UInt32
-    : public NdfTransactionChangeProperty {
+    : public NdfTransactionSetProperty {
   uint32_t value;
   uint32_t previous_value;
   void apply_property(std::unique_ptr<NDFProperty> &prop) override {
@@ -270,10 +584,18 @@ struct NdfTransactionChangeProperty_UInt32
         reinterpret_cast<std::unique_ptr<NDFPropertyUInt32> &>(prop);
     property->value = previous_value;
   }
+  NdfTransactionType get_type() const override {
+    return NdfTransactionType::ChangeProperty_UInt32;
+  }
+  void fields(TransactionArchive &ar) override {
+    NdfTransactionChangeProperty::fields(ar);
+    ar.field(value);
+    ar.field(previous_value);
+  }
 };
 
 struct NdfTransactionChangeProperty_Float32
-    : public NdfTransactionChangeProperty {
+    : public NdfTransactionSetProperty {
   float value;
   float previous_value;
   void apply_property(std::unique_ptr<NDFProperty> &prop) override {
@@ -289,10 +611,18 @@ struct NdfTransactionChangeProperty_Float32
         reinterpret_cast<std::unique_ptr<NDFPropertyFloat32> &>(prop);
     property->value = previous_value;
   }
+  NdfTransactionType get_type() const override {
+    return NdfTransactionType::ChangeProperty_Float32;
+  }
+  void fields(TransactionArchive &ar) override {
+    NdfTransactionChangeProperty::fields(ar);
+    ar.field(value);
+    ar.field(previous_value);
+  }
 };
 
 struct NdfTransactionChangeProperty_Float64
-    : public NdfTransactionChangeProperty {
+    : public NdfTransactionSetProperty {
   double value;
   double previous_value;
   void apply_property(std::unique_ptr<NDFProperty> &prop) override {
@@ -308,10 +638,18 @@ struct NdfTransactionChangeProperty_Float64
         reinterpret_cast<std::unique_ptr<NDFPropertyFloat64> &>(prop);
     property->value = previous_value;
   }
+  NdfTransactionType get_type() const override {
+    return NdfTransactionType::ChangeProperty_Float64;
+  }
+  void fields(TransactionArchive &ar) override {
+    NdfTransactionChangeProperty::fields(ar);
+    ar.field(value);
+    ar.field(previous_value);
+  }
 };
 
 struct NdfTransactionChangeProperty_String
-    : public NdfTransactionChangeProperty {
+    : public NdfTransactionSetProperty {
   std::string value;
   std::string previous_value;
   void apply_property(std::unique_ptr<NDFProperty> &prop) override {
@@ -327,10 +665,18 @@ struct NdfTransactionChangeProperty_String
         reinterpret_cast<std::unique_ptr<NDFPropertyString> &>(prop);
     property->value = previous_value;
   }
+  NdfTransactionType get_type() const override {
+    return NdfTransactionType::ChangeProperty_String;
+  }
+  void fields(TransactionArchive &ar) override {
+    NdfTransactionChangeProperty::fields(ar);
+    ar.field(value);
+    ar.field(previous_value);
+  }
 };
 
 struct NdfTransactionChangeProperty_WideString
-    : public NdfTransactionChangeProperty {
+    : public NdfTransactionSetProperty {
   std::string value;
   std::string previous_value;
   void apply_property(std::unique_ptr<NDFProperty> &prop) override {
@@ -346,9 +692,17 @@ struct NdfTransactionChangeProperty_WideString
         reinterpret_cast<std::unique_ptr<NDFPropertyWideString> &>(prop);
     property->value = previous_value;
   }
+  NdfTransactionType get_type() const override {
+    return NdfTransactionType::ChangeProperty_WideString;
+  }
+  void fields(TransactionArchive &ar) override {
+    NdfTransactionChangeProperty::fields(ar);
+    ar.field(value);
+    ar.field(previous_value);
+  }
 };
 
-struct NdfTransactionChangeProperty_GUID : public NdfTransactionChangeProperty {
+struct NdfTransactionChangeProperty_GUID : public NdfTransactionSetProperty {
   std::string guid;
   std::string previous_guid;
   void apply_property(std::unique_ptr<NDFProperty> &prop) override {
@@ -362,10 +716,18 @@ struct NdfTransactionChangeProperty_GUID : public NdfTransactionChangeProperty {
     auto &property = reinterpret_cast<std::unique_ptr<NDFPropertyGUID> &>(prop);
     property->guid = previous_guid;
   }
+  NdfTransactionType get_type() const override {
+    return NdfTransactionType::ChangeProperty_GUID;
+  }
+  void fields(TransactionArchive &ar) override {
+    NdfTransactionChangeProperty::fields(ar);
+    ar.field(guid);
+    ar.field(previous_guid);
+  }
 };
 
 struct NdfTransactionChangeProperty_LocalisationHash
-    : public NdfTransactionChangeProperty {
+    : public NdfTransactionSetProperty {
   std::string hash;
   std::string previous_hash;
   void apply_property(std::unique_ptr<NDFProperty> &prop) override {
@@ -381,9 +743,17 @@ struct NdfTransactionChangeProperty_LocalisationHash
         reinterpret_cast<std::unique_ptr<NDFPropertyLocalisationHash> &>(prop);
     property->hash = previous_hash;
   }
+  NdfTransactionType get_type() const override {
+    return NdfTransactionType::ChangeProperty_LocalisationHash;
+  }
+  void fields(TransactionArchive &ar) override {
+    NdfTransactionChangeProperty::fields(ar);
+    ar.field(hash);
+    ar.field(previous_hash);
+  }
 };
 
-struct NdfTransactionChangeProperty_Hash : public NdfTransactionChangeProperty {
+struct NdfTransactionChangeProperty_Hash : public NdfTransactionSetProperty {
   std::string hash;
   std::string previous_hash;
   void apply_property(std::unique_ptr<NDFProperty> &prop) override {
@@ -397,10 +767,18 @@ struct NdfTransactionChangeProperty_Hash : public NdfTransactionChangeProperty {
     auto &property = reinterpret_cast<std::unique_ptr<NDFPropertyHash> &>(prop);
     property->hash = previous_hash;
   }
+  NdfTransactionType get_type() const override {
+    return NdfTransactionType::ChangeProperty_Hash;
+  }
+  void fields(TransactionArchive &ar) override {
+    NdfTransactionChangeProperty::fields(ar);
+    ar.field(hash);
+    ar.field(previous_hash);
+  }
 };
 
 struct NdfTransactionChangeProperty_PathReference
-    : public NdfTransactionChangeProperty {
+    : public NdfTransactionSetProperty {
   std::string path;
   std::string previous_path;
   void apply_property(std::unique_ptr<NDFProperty> &prop) override {
@@ -411,15 +789,23 @@ struct NdfTransactionChangeProperty_PathReference
     property->path = path;
   }
   void undo_property(std::unique_ptr<NDFProperty> &prop) override {
-    assert(prop->property_type == NDFPropertyType::String);
+    assert(prop->property_type == NDFPropertyType::PathReference);
     auto &property =
         reinterpret_cast<std::unique_ptr<NDFPropertyPathReference> &>(prop);
     property->path = previous_path;
   }
+  NdfTransactionType get_type() const override {
+    return NdfTransactionType::ChangeProperty_PathReference;
+  }
+  void fields(TransactionArchive &ar) override {
+    NdfTransactionChangeProperty::fields(ar);
+    ar.field(path);
+    ar.field(previous_path);
+  }
 };
 
 struct NdfTransactionChangeProperty_ObjectReference
-    : public NdfTransactionChangeProperty {
+    : public NdfTransactionSetProperty {
   std::string value;
   std::string previous_value;
   void apply_property(std::unique_ptr<NDFProperty> &prop) override {
@@ -435,10 +821,18 @@ struct NdfTransactionChangeProperty_ObjectReference
         reinterpret_cast<std::unique_ptr<NDFPropertyObjectReference> &>(prop);
     property->object_name = previous_value;
   }
+  NdfTransactionType get_type() const override {
+    return NdfTransactionType::ChangeProperty_ObjectReference;
+  }
+  void fields(TransactionArchive &ar) override {
+    NdfTransactionChangeProperty::fields(ar);
+    ar.field(value);
+    ar.field(previous_value);
+  }
 };
 
 struct NdfTransactionChangeProperty_ImportReference
-    : public NdfTransactionChangeProperty {
+    : public NdfTransactionSetProperty {
   std::string value;
   std::string previous_value;
   void apply_property(std::unique_ptr<NDFProperty> &prop) override {
@@ -454,10 +848,18 @@ struct NdfTransactionChangeProperty_ImportReference
         reinterpret_cast<std::unique_ptr<NDFPropertyImportReference> &>(prop);
     property->import_name = previous_value;
   }
+  NdfTransactionType get_type() const override {
+    return NdfTransactionType::ChangeProperty_ImportReference;
+  }
+  void fields(TransactionArchive &ar) override {
+    NdfTransactionChangeProperty::fields(ar);
+    ar.field(value);
+    ar.field(previous_value);
+  }
 };
 
 struct NdfTransactionChangeProperty_F32_vec2
-    : public NdfTransactionChangeProperty {
+    : public NdfTransactionSetProperty {
   float x, y;
   float previous_x, previous_y;
   void apply_property(std::unique_ptr<NDFProperty> &prop) override {
@@ -476,10 +878,20 @@ struct NdfTransactionChangeProperty_F32_vec2
     property->x = previous_x;
     property->y = previous_y;
   }
+  NdfTransactionType get_type() const override {
+    return NdfTransactionType::ChangeProperty_F32_vec2;
+  }
+  void fields(TransactionArchive &ar) override {
+    NdfTransactionChangeProperty::fields(ar);
+    ar.field(x);
+    ar.field(y);
+    ar.field(previous_x);
+    ar.field(previous_y);
+  }
 };
 
 struct NdfTransactionChangeProperty_F32_vec3
-    : public NdfTransactionChangeProperty {
+    : public NdfTransactionSetProperty {
   float x, y, z;
   float previous_x, previous_y, previous_z;
   void apply_property(std::unique_ptr<NDFProperty> &prop) override {
@@ -501,10 +913,22 @@ struct NdfTransactionChangeProperty_F32_vec3
     property->y = previous_y;
     property->z = previous_z;
   }
+  NdfTransactionType get_type() const override {
+    return NdfTransactionType::ChangeProperty_F32_vec3;
+  }
+  void fields(TransactionArchive &ar) override {
+    NdfTransactionChangeProperty::fields(ar);
+    ar.field(x);
+    ar.field(y);
+    ar.field(z);
+    ar.field(previous_x);
+    ar.field(previous_y);
+    ar.field(previous_z);
+  }
 };
 
 struct NdfTransactionChangeProperty_F32_vec4
-    : public NdfTransactionChangeProperty {
+    : public NdfTransactionSetProperty {
   float x, y, z, w;
   float previous_x, previous_y, previous_z, previous_w;
   void apply_property(std::unique_ptr<NDFProperty> &prop) override {
@@ -529,10 +953,24 @@ struct NdfTransactionChangeProperty_F32_vec4
     property->z = previous_z;
     property->w = previous_w;
   }
+  NdfTransactionType get_type() const override {
+    return NdfTransactionType::ChangeProperty_F32_vec4;
+  }
+  void fields(TransactionArchive &ar) override {
+    NdfTransactionChangeProperty::fields(ar);
+    ar.field(x);
+    ar.field(y);
+    ar.field(z);
+    ar.field(w);
+    ar.field(previous_x);
+    ar.field(previous_y);
+    ar.field(previous_z);
+    ar.field(previous_w);
+  }
 };
 
 struct NdfTransactionChangeProperty_Color
-    : public NdfTransactionChangeProperty {
+    : public NdfTransactionSetProperty {
   float r, g, b, a;
   float previous_r, previous_g, previous_b, previous_a;
   void apply_property(std::unique_ptr<NDFProperty> &prop) override {
@@ -557,10 +995,24 @@ struct NdfTransactionChangeProperty_Color
     property->b = previous_b;
     property->a = previous_a;
   }
+  NdfTransactionType get_type() const override {
+    return NdfTransactionType::ChangeProperty_Color;
+  }
+  void fields(TransactionArchive &ar) override {
+    NdfTransactionChangeProperty::fields(ar);
+    ar.field(r);
+    ar.field(g);
+    ar.field(b);
+    ar.field(a);
+    ar.field(previous_r);
+    ar.field(previous_g);
+    ar.field(previous_b);
+    ar.field(previous_a);
+  }
 };
 
 struct NdfTransactionChangeProperty_S32_vec2
-    : public NdfTransactionChangeProperty {
+    : public NdfTransactionSetProperty {
   int32_t x, y;
   int32_t previous_x, previous_y;
   void apply_property(std::unique_ptr<NDFProperty> &prop) override {
@@ -579,10 +1031,20 @@ struct NdfTransactionChangeProperty_S32_vec2
     property->x = previous_x;
     property->y = previous_y;
   }
+  NdfTransactionType get_type() const override {
+    return NdfTransactionType::ChangeProperty_S32_vec2;
+  }
+  void fields(TransactionArchive &ar) override {
+    NdfTransactionChangeProperty::fields(ar);
+    ar.field(x);
+    ar.field(y);
+    ar.field(previous_x);
+    ar.field(previous_y);
+  }
 };
 
 struct NdfTransactionChangeProperty_S32_vec3
-    : public NdfTransactionChangeProperty {
+    : public NdfTransactionSetProperty {
   int32_t x, y, z;
   int32_t previous_x, previous_y, previous_z;
   void apply_property(std::unique_ptr<NDFProperty> &prop) override {
@@ -604,14 +1066,27 @@ struct NdfTransactionChangeProperty_S32_vec3
     property->y = previous_y;
     property->z = previous_z;
   }
+  NdfTransactionType get_type() const override {
+    return NdfTransactionType::ChangeProperty_S32_vec3;
+  }
+  void fields(TransactionArchive &ar) override {
+    NdfTransactionChangeProperty::fields(ar);
+    ar.field(x);
+    ar.field(y);
+    ar.field(z);
+    ar.field(previous_x);
+    ar.field(previous_y);
+    ar.field(previous_z);
+  }
 };
 
 struct NdfTransactionChangeProperty_AddListItem
     : public NdfTransactionChangeProperty {
   uint32_t index;
   // when initializing, this needs to be created
-  // when applying, this gets moved into the object
-  // when undoing, this gets moved back into the transaction
+  // when applying, a copy gets inserted into the object, so the transaction
+  // can be journaled and replayed afterwards
+  // when undoing, the inserted value gets moved back into the transaction
   std::unique_ptr<NDFProperty> value;
 
   void apply_property(std::unique_ptr<NDFProperty> &prop) override {
@@ -619,7 +1094,7 @@ struct NdfTransactionChangeProperty_AddListItem
     auto &property = reinterpret_cast<std::unique_ptr<NDFPropertyList> &>(prop);
     auto it = property->values.begin();
     std::advance(it, index);
-    property->values.insert(it, std::move(value));
+    property->values.insert(it, value->get_copy());
   }
 
   void undo_property(std::unique_ptr<NDFProperty> &prop) override {
@@ -631,6 +1106,14 @@ struct NdfTransactionChangeProperty_AddListItem
     std::advance(it, index);
     property->values.erase(it);
   }
+  NdfTransactionType get_type() const override {
+    return NdfTransactionType::ChangeProperty_AddListItem;
+  }
+  void fields(TransactionArchive &ar) override {
+    NdfTransactionChangeProperty::fields(ar);
+    ar.field(index);
+    ar.field(value);
+  }
 };
 
 struct NdfTransactionChangeProperty_RemoveListItem
@@ -657,6 +1140,14 @@ struct NdfTransactionChangeProperty_RemoveListItem
     std::advance(it, index);
     property->values.insert(it, std::move(previous_value));
   }
+  NdfTransactionType get_type() const override {
+    return NdfTransactionType::ChangeProperty_RemoveListItem;
+  }
+  void fields(TransactionArchive &ar) override {
+    NdfTransactionChangeProperty::fields(ar);
+    ar.field(index);
+    ar.field(previous_value);
+  }
 };
 
 struct NdfTransactionChangeProperty_ChangeListItem
@@ -674,14 +1165,33 @@ struct NdfTransactionChangeProperty_ChangeListItem
     auto &property = reinterpret_cast<std::unique_ptr<NDFPropertyList> &>(prop);
     change->undo_property(property->values.at(index));
   }
+  NdfTransactionType get_type() const override {
+    return NdfTransactionType::ChangeProperty_ChangeListItem;
+  }
+  bool same_target(const NdfTransactionChangeProperty &other) const override {
+    auto *item =
+        dynamic_cast<const NdfTransactionChangeProperty_ChangeListItem *>(
+            &other);
+    return item && object_name == item->object_name &&
+           property_name == item->property_name && index == item->index &&
+           change->same_target(*item->change);
+  }
+  bool is_serializable() const override { return change->is_serializable(); }
+  bool is_replayable() const override { return change->is_replayable(); }
+  void fields(TransactionArchive &ar) override {
+    NdfTransactionChangeProperty::fields(ar);
+    ar.field(index);
+    ar.nested(change);
+  }
 };
 
 struct NdfTransactionChangeProperty_AddMapItem
     : public NdfTransactionChangeProperty {
   uint32_t index;
   // when initializing, this needs to be created
-  // when applying, this gets moved into the object
-  // when undoing, this gets moved back into the transaction
+  // when applying, a copy gets inserted into the object, so the transaction
+  // can be journaled and replayed afterwards
+  // when undoing, the inserted value gets moved back into the transaction
   std::pair<std::unique_ptr<NDFProperty>, std::unique_ptr<NDFProperty>> value;
 
   void apply_property(std::unique_ptr<NDFProperty> &prop) override {
@@ -689,7 +1199,8 @@ struct NdfTransactionChangeProperty_AddMapItem
     auto &property = reinterpret_cast<std::unique_ptr<NDFPropertyMap> &>(prop);
     auto it = property->values.begin();
     std::advance(it, index);
-    property->values.insert(it, std::move(value));
+    property->values.insert(
+        it, std::make_pair(value.first->get_copy(), value.second->get_copy()));
   }
 
   void undo_property(std::unique_ptr<NDFProperty> &prop) override {
@@ -701,6 +1212,15 @@ struct NdfTransactionChangeProperty_AddMapItem
     std::advance(it, index);
     property->values.erase(it);
   }
+  NdfTransactionType get_type() const override {
+    return NdfTransactionType::ChangeProperty_AddMapItem;
+  }
+  void fields(TransactionArchive &ar) override {
+    NdfTransactionChangeProperty::fields(ar);
+    ar.field(index);
+    ar.field(value.first);
+    ar.field(value.second);
+  }
 };
 
 struct NdfTransactionChangeProperty_RemoveMapItem
@@ -728,6 +1248,15 @@ struct NdfTransactionChangeProperty_RemoveMapItem
     std::advance(it, index);
     property->values.insert(it, std::move(previous_value));
   }
+  NdfTransactionType get_type() const override {
+    return NdfTransactionType::ChangeProperty_RemoveMapItem;
+  }
+  void fields(TransactionArchive &ar) override {
+    NdfTransactionChangeProperty::fields(ar);
+    ar.field(index);
+    ar.field(previous_value.first);
+    ar.field(previous_value.second);
+  }
 };
 
 struct NdfTransactionChangeProperty_ChangeMapItem
@@ -754,6 +1283,25 @@ struct NdfTransactionChangeProperty_ChangeMapItem
       change->undo_property(property->values.at(index).second);
     }
   }
+  NdfTransactionType get_type() const override {
+    return NdfTransactionType::ChangeProperty_ChangeMapItem;
+  }
+  bool same_target(const NdfTransactionChangeProperty &other) const override {
+    auto *item =
+        dynamic_cast<const NdfTransactionChangeProperty_ChangeMapItem *>(
+            &other);
+    return item && object_name == item->object_name &&
+           property_name == item->property_name && index == item->index &&
+           key == item->key && change->same_target(*item->change);
+  }
+  bool is_serializable() const override { return change->is_serializable(); }
+  bool is_replayable() const override { return change->is_replayable(); }
+  void fields(TransactionArchive &ar) override {
+    NdfTransactionChangeProperty::fields(ar);
+    ar.field(index);
+    ar.field(key);
+    ar.nested(change);
+  }
 };
 
 struct NdfTransactionChangeProperty_ChangePairItem
@@ -779,20 +1327,86 @@ struct NdfTransactionChangeProperty_ChangePairItem
       change->undo_property(property->second);
     }
   }
+  NdfTransactionType get_type() const override {
+    return NdfTransactionType::ChangeProperty_ChangePairItem;
+  }
+  bool same_target(const NdfTransactionChangeProperty &other) const override {
+    auto *item =
+        dynamic_cast<const NdfTransactionChangeProperty_ChangePairItem *>(
+            &other);
+    return item && object_name == item->object_name &&
+           property_name == item->property_name && first == item->first &&
+           change->same_target(*item->change);
+  }
+  bool is_serializable() const override { return change->is_serializable(); }
+  bool is_replayable() const override { return change->is_replayable(); }
+  void fields(TransactionArchive &ar) override {
+    NdfTransactionChangeProperty::fields(ar);
+    ar.field(first);
+    ar.nested(change);
+  }
 };
 
+// returns a default constructed transaction of the type, nullptr if the type
+// is unknown
+std::unique_ptr<NdfTransaction> create_transaction(NdfTransactionType type);
+// returns nullopt if the transaction isn't serializable or its ndf values
+// can't be written
+std::optional<std::string> serialize_transaction(NdfTransaction &transaction);
+// returns nullptr if the data is truncated or corrupt
+std::unique_ptr<NdfTransaction>
+deserialize_transaction(std::span<const char> data);
+
 class NdfBinFile {
 private:
   NDF ndf;
+  // names of objects, classes, properties and export paths, kept over
+  // reloads so ids held by the ui stay valid
+  SymbolTable m_symbols;
+  // bumped whenever the content of ndf changes, read by saves on the pool
+  std::atomic_uint64_t m_generation = 0;
+  // position in ndf.object_map of every object by the symbol of its name, so
+  // symbol lookups don't need to build a string. Rebuilt on the next lookup
+  // after objects were added, removed or renamed.
+  static constexpr uint32_t no_object_position =
+      std::numeric_limits<uint32_t>::max();
+  std::vector<uint32_t> m_object_positions;
+  bool m_object_positions_valid = false;
+  void rebuild_object_positions();
+  std::optional<size_t> find_object_position(Symbol name);
+  // invalidates the object positions if any of the changes from first_change
+  // on added, removed or renamed an object
+  void check_object_positions(size_t first_change);
+  // what the indexes read from the objects, see ObjectDigests
+  ObjectDigests m_digests;
+  // drops the digests of the objects the changes from first_change on
+  // touched, renames drop all since they fix references in other objects
+  void invalidate_digests(size_t first_change);
 
 public:
+  NdfBinFile() = default;
+  ~NdfBinFile();
   void start_parsing(fs::path vfs_path, fs::path file_path);
-  void start_parsing(fs::path vfs_path, std::vector<char> vec_data);
+  void start_parsing(fs::path vfs_path, std::span<const char> data);
   void load_from_xml_file(fs::path path, NDF_DB *db, int ndf_id);
+  // the snapshot is the uncompressed ndfbin behind a checksummed header, it
+  // is mapped and parsed in place. modified tells whether it holds edits
+  // that are not in the dat file yet.
+  bool load_snapshot(fs::path path, bool &modified);
+  bool save_snapshot(fs::path path, bool modified);
 
   bool contains_object(const std::string &name) {
     return ndf.object_map.contains(name);
   }
+  bool contains_object(Symbol name) {
+    return find_object_position(name).has_value();
+  }
+
+  uint64_t get_generation() const { return m_generation; }
+
+  SymbolTable &get_symbols() { return m_symbols; }
+  Symbol intern(std::string_view str) { return m_symbols.intern(str); }
+  const char *c_str(Symbol symbol) const { return m_symbols.c_str(symbol); }
 
   /*
   bool insert_objects(NDF_DB *db, int ndf_id) const {
@@ -830,6 +1444,14 @@ public:
     }
     return it.value();
   }
+  NDFObject &get_object(Symbol name) {
+    auto position = find_object_position(name);
+    if (!position) {
+      throw std::runtime_error(
+          std::format("object not found: {}", m_symbols.str(name)));
+    }
+    return get_object_at_index(position.value());
+  }
   NDFObject &get_object_at_index(size_t index) {
     auto it = ndf.object_map.nth(index);
     if (it == ndf.object_map.end()) {
@@ -839,75 +1461,277 @@ public:
     return it.value();
   }
   size_t get_object_count() { return ndf.object_map.size(); }
+  // values and references of the object, the views are valid until the next
+  // call
+  ObjectDigests::Digest get_digest(Symbol name) {
+    return m_digests.get(name, get_object(name), m_symbols);
+  }
+
+  // returns all object names in the order of the file, filtering is done by
+  // the ObjectSearch of the ndfbin
+  std::vector<Symbol> get_object_names() {
+    std::vector<Symbol> result;
+    result.reserve(ndf.object_map.size());
+    for (auto &object_name : ndf.object_map | std::views::keys) {
+      result.push_back(m_symbols.intern(object_name));
+    }
+    return result;
+  }
 
-  std::vector<std::string> filter_objects(const std::string &object_filter,
-                                          const std::string &class_filter) {
-    if (object_filter.empty() && class_filter.empty()) {
-      auto it = ndf.object_map | std::views::keys;
-      std::vector<std::string> result(std::begin(it), std::end(it));
-      return result;
-    }
-    std::vector<std::string> result;
-    for (auto &object : ndf.object_map | std::views::values) {
-      if (class_filter.empty() ||
-          str_tolower(object.class_name).contains(class_filter)) {
-        if (object_filter.empty() ||
-            str_tolower(object.name).contains(object_filter)) {
-          result.push_back(object.name);
-        }
+private:
+  // changes done since the last take_changes call
+  std::vector<NdfChange> m_changes;
+  // whether the last applied transaction may absorb the next one, only true
+  // within one ui interaction
+  bool m_coalesce_back = false;
+
+  // merges the transaction into the last applied one if both set the same
+  // property or item of a property, returns false if they can't be merged
+  bool coalesce(std::unique_ptr<NdfTransaction> &transaction) {
+    if (!m_coalesce_back || applied_transactions.empty()) {
+      return false;
+    }
+    auto *next =
+        dynamic_cast<NdfTransactionChangeProperty *>(transaction.get());
+    if (!next) {
+      return false;
+    }
+    auto &back = applied_transactions.back();
+    if (auto *merged = dynamic_cast<NdfTransactionCoalescedSet *>(back.get())) {
+      if (!merged->last->same_target(*next)) {
+        return false;
       }
+      transaction.release();
+      merged->last.reset(next);
+      return true;
     }
-    return result;
+    auto *previous =
+        dynamic_cast<NdfTransactionChangeProperty *>(back.get());
+    if (!previous || !previous->same_target(*next)) {
+      return false;
+    }
+    auto merged = std::make_unique<NdfTransactionCoalescedSet>();
+    merged->object_name = previous->object_name;
+    back.release();
+    merged->first.reset(previous);
+    transaction.release();
+    merged->last.reset(next);
+    back = std::move(merged);
+    return true;
   }
 
+  // the undo history kept in memory, older transactions are spilled to the
+  // journal at m_spill_path
+  size_t m_history_max_entries = std::numeric_limits<size_t>::max();
+  size_t m_history_max_bytes = std::numeric_limits<size_t>::max();
+  // history_bytes of applied_transactions and undone_transactions
+  size_t m_history_bytes = 0;
+  // measures a transaction entering the history, it is taken out of the
+  // budget with the same bytes again
+  void account_history(NdfTransaction &transaction) {
+    transaction.history_bytes = transaction.memory_usage();
+    m_history_bytes += transaction.history_bytes;
+  }
+  fs::path m_spill_path;
+  struct SpillRecord {
+    uint64_t offset;
+    uint32_t size;
+  };
+  // records in the journal, the last one is the newest transaction
+  std::vector<SpillRecord> m_spilled;
+
+  // moves the oldest transactions to the journal until the history fits into
+  // the budget
+  void enforce_history_budget();
+  void spill(std::vector<std::unique_ptr<NdfTransaction>> transactions);
+  // reads the newest spilled transaction back, nullptr if there is none
+  std::unique_ptr<NdfTransaction> page_in();
+  void clear_spilled();
+  // drops the undo and redo history, e.g. on reloads
+  void clear_history();
+
+  // edits done since the snapshot was last saved
+  NdfJournal m_journal;
+  bool m_replaying = false;
+  // set once an edit couldn't be journaled, the journal then only holds
+  // the edits before it until the next checkpoint
+  bool m_journal_suspended = false;
+  // set when an edit couldn't be journaled, the owner saves a snapshot so
+  // the edit isn't only kept in memory
+  bool m_checkpoint_requested = false;
+  // the newest applied and undone transactions that a replay of the journal
+  // also has in its history, the ones below were done before the checkpoint
+  // and are written into their undo and redo records
+  size_t m_journaled_applied = 0;
+  size_t m_journaled_undone = 0;
+  bool is_journaling() const {
+    return !m_replaying && !m_journal_suspended && m_journal.is_open();
+  }
+  // serializes the transaction for a record of op, nullopt if that isn't
+  // possible. the journal is then suspended and a checkpoint requested.
+  std::optional<std::string> journal_payload(NdfJournal::Op op,
+                                             NdfTransaction &transaction);
+  void journal(NdfJournal::Op op, std::string_view payload = {});
+
 public:
-  std::vector<std::unique_ptr<NdfTransaction>> applied_transactions;
-  std::vector<std::unique_ptr<NdfTransaction>> undone_transactions;
+  // returns and clears the changes of all transactions applied or undone
+  // since the last call
+  std::vector<NdfChange> take_changes() {
+    return std::exchange(m_changes, {});
+  }
+
+  // limits the undo history held in memory, older transactions are written
+  // to the journal at spill_path and read back on undo
+  void set_history_budget(size_t max_entries, size_t max_bytes,
+                          fs::path spill_path);
+  size_t get_history_bytes() const { return m_history_bytes; }
+
+  // opens the journal at path. if replay is set, the edits in it are applied
+  // to the loaded ndf, otherwise it is cleared. returns the number of
+  // replayed records.
+  size_t open_journal(fs::path path, bool replay);
+  // called once the edits are saved to the snapshot, clears the journal
+  void checkpoint_journal();
+  // true once if an edit since the last checkpoint couldn't be journaled
+  bool take_checkpoint_request() {
+    return std::exchange(m_checkpoint_requested, false);
+  }
+  size_t get_spilled_count() const { return m_spilled.size(); }
+
+  std::deque<std::unique_ptr<NdfTransaction>> applied_transactions;
+  std::deque<std::unique_ptr<NdfTransaction>> undone_transactions;
   void apply_transaction(std::unique_ptr<NdfTransaction> transaction) {
     transaction->apply(ndf);
+    m_generation++;
+    size_t change_count = m_changes.size();
+    transaction->get_changes(m_changes, false);
+    check_object_positions(change_count);
+    invalidate_digests(change_count);
+    if (is_journaling()) {
+      if (auto payload = journal_payload(NdfJournal::Op::APPLY, *transaction)) {
+        journal(NdfJournal::Op::APPLY, payload.value());
+      }
+    }
 
-    applied_transactions.push_back(std::move(transaction));
+    size_t back_bytes = 0;
+    if (m_coalesce_back && !applied_transactions.empty()) {
+      back_bytes = applied_transactions.back()->history_bytes;
+    }
+    if (coalesce(transaction)) {
+      m_history_bytes -= back_bytes;
+      account_history(*applied_transactions.back());
+      // the change of the merged transaction is usually still pending
+      if (change_count > 0 && m_changes.size() == change_count + 1 &&
+          m_changes.back() == m_changes[change_count - 1]) {
+        m_changes.pop_back();
+      }
+    } else {
+      account_history(*transaction);
+      applied_transactions.push_back(std::move(transaction));
+      m_journaled_applied++;
+    }
+    m_coalesce_back = true;
     // since we now changed state, we need to clear the undone_transactions
+    clear_redo_history();
+    enforce_history_budget();
+  }
+  // drops the undone transactions, applying a new one does the same
+  void clear_redo_history() {
+    for (auto &undone : undone_transactions) {
+      m_history_bytes -= undone->history_bytes;
+    }
     undone_transactions.clear();
+    m_journaled_undone = 0;
+  }
+  // ends the current ui interaction, later transactions are not merged into
+  // the ones applied before
+  void end_interaction() {
+    if (m_coalesce_back) {
+      journal(NdfJournal::Op::END_INTERACTION);
+    }
+    m_coalesce_back = false;
+    m_journal.sync();
   }
   void undo_transaction() {
+    m_coalesce_back = false;
     if (applied_transactions.empty()) {
-      return;
+      auto transaction = page_in();
+      if (!transaction) {
+        return;
+      }
+      account_history(*transaction);
+      applied_transactions.push_back(std::move(transaction));
     }
     auto &transaction = applied_transactions.back();
+    // a step from before the checkpoint is written into the record, before
+    // undo moves state out of it
+    bool journaled = m_journaled_applied > 0;
+    std::optional<std::string> payload;
+    if (!journaled && is_journaling()) {
+      payload = journal_payload(NdfJournal::Op::UNDO, *transaction);
+    }
     transaction->undo(ndf);
+    m_generation++;
+    size_t change_count = m_changes.size();
+    transaction->get_changes(m_changes, true);
+    check_object_positions(change_count);
+    invalidate_digests(change_count);
+    if (journaled) {
+      m_journaled_applied--;
+      journal(NdfJournal::Op::UNDO);
+    } else if (payload) {
+      journal(NdfJournal::Op::UNDO, payload.value());
+    }
+    m_journaled_undone++;
     undone_transactions.push_back(std::move(transaction));
     applied_transactions.pop_back();
+    enforce_history_budget();
   }
   void redo_transaction() {
+    m_coalesce_back = false;
     if (undone_transactions.empty()) {
       return;
     }
     auto &transaction = undone_transactions.back();
+    bool journaled = m_journaled_undone > 0;
+    std::optional<std::string> payload;
+    if (!journaled && is_journaling()) {
+      payload = journal_payload(NdfJournal::Op::REDO, *transaction);
+    }
     transaction->apply(ndf);
+    m_generation++;
+    size_t change_count = m_changes.size();
+    transaction->get_changes(m_changes, false);
+    check_object_positions(change_count);
+    invalidate_digests(change_count);
+    if (journaled) {
+      m_journaled_undone--;
+      journal(NdfJournal::Op::REDO);
+    } else if (payload) {
+      journal(NdfJournal::Op::REDO, payload.value());
+    }
+    m_journaled_applied++;
     applied_transactions.push_back(std::move(transaction));
     undone_transactions.pop_back();
+    enforce_history_budget();
   }
   void save_ndf_xml_to_file(fs::path path) { ndf.save_as_ndf_xml(path); }
-  void save_ndfbin_to_stream(std::ostream &stream) {
+  bool save_ndfbin_to_stream(std::ostream &stream) {
     std::stringstream tmp;
     ndf.save_as_ndfbin_stream(tmp);
-    try {
-      py::gil_scoped_acquire acquire;
-      py::object compress_ndfbin =
-          py::module_::import("wgrd_cons_parsers.compress_ndfbin")
-              .attr("compress_ndfbin");
-      py::bytes bytes(tmp.str());
-      py::bytes compressed = compress_ndfbin(bytes);
-      stream.write(compressed.cast<std::string>().data(),
-                   compressed.cast<std::string>().size());
-    } catch (py::error_already_set &e) {
-      spdlog::error("Error saving NDF: {}", e.what());
-    }
-  }
-  void save_ndfbin_to_file(fs::path path) {
+    std::string_view data = tmp.view();
+    if (!compress_ndfbin(std::span<const char>(data.data(), data.size()),
+                         stream)) {
+      spdlog::error("Error saving NDF: compression failed");
+      return false;
+    }
+    return true;
+  }
+  bool save_ndfbin_to_file(fs::path path) {
     std::ofstream ofs(path, std::ios::binary | std::ios::out | std::ios::trunc);
-    save_ndfbin_to_stream(ofs);
+    bool ret = save_ndfbin_to_stream(ofs);
+    ofs.close();
+    return ret && !ofs.fail();
   }
 };
 
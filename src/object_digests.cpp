@@ -0,0 +1,129 @@
+#include "object_digests.hpp"
+
+using namespace wgrd_files;
+
+namespace {
+
+// small files never compact, the dropped digests cost less than the copy
+constexpr size_t min_compact_bytes = 64 * 1024;
+
+size_t entry_bytes(const ObjectDigests::Digest &digest) {
+  size_t ret = digest.properties.size_bytes() +
+               digest.object_references.size_bytes() +
+               digest.import_references.size_bytes();
+  for (auto &property : digest.properties) {
+    ret += property.value_size;
+  }
+  return ret;
+}
+
+} // namespace
+
+ObjectDigests::Digest ObjectDigests::view(const Entry &entry) const {
+  Digest ret;
+  ret.properties = std::span<const Property>(
+      m_properties.data() + entry.property_begin, entry.property_count);
+  ret.object_references = std::span<const Symbol>(
+      m_references.data() + entry.reference_begin,
+      entry.object_reference_count);
+  ret.import_references = std::span<const Symbol>(
+      m_references.data() + entry.reference_begin +
+          entry.object_reference_count,
+      entry.import_reference_count);
+  ret.values = m_values.data();
+  return ret;
+}
+
+void ObjectDigests::build(Entry &entry, NDFObject &object,
+                          SymbolTable &symbols) {
+  entry.property_begin = m_properties.size();
+  entry.property_count = object.properties.size();
+  entry.reference_begin = m_references.size();
+  m_import_scratch.clear();
+  for (auto &property : object.properties) {
+    for (auto &ref : property->get_object_references()) {
+      m_references.push_back(symbols.intern(ref));
+    }
+    for (auto &ref : property->get_import_references()) {
+      m_import_scratch.push_back(symbols.intern(ref));
+    }
+    std::string value = property->as_string();
+    m_properties.push_back({symbols.intern(property->property_name),
+                            static_cast<uint32_t>(m_values.size()),
+                            static_cast<uint32_t>(value.size())});
+    m_values.insert(m_values.end(), value.begin(), value.end());
+  }
+  entry.object_reference_count = m_references.size() - entry.reference_begin;
+  entry.import_reference_count = m_import_scratch.size();
+  m_references.insert(m_references.end(), m_import_scratch.begin(),
+                      m_import_scratch.end());
+  entry.valid = true;
+}
+
+void ObjectDigests::compact() {
+  std::vector<Property> properties;
+  std::vector<Symbol> references;
+  std::vector<char> values;
+  properties.reserve(m_properties.size());
+  references.reserve(m_references.size());
+  values.reserve(m_values.size());
+  for (auto &entry : m_entries) {
+    if (!entry.valid) {
+      continue;
+    }
+    Digest digest = view(entry);
+    entry.property_begin = properties.size();
+    for (auto &property : digest.properties) {
+      auto value = digest.value(property);
+      properties.push_back({property.property_name,
+                            static_cast<uint32_t>(values.size()),
+                            property.value_size});
+      values.insert(values.end(), value.begin(), value.end());
+    }
+    entry.reference_begin = references.size();
+    references.insert(references.end(), digest.object_references.begin(),
+                      digest.object_references.end());
+    references.insert(references.end(), digest.import_references.begin(),
+                      digest.import_references.end());
+  }
+  m_properties = std::move(properties);
+  m_references = std::move(references);
+  m_values = std::move(values);
+  m_garbage = 0;
+}
+
+ObjectDigests::Digest ObjectDigests::get(Symbol object_name, NDFObject &object,
+                                         SymbolTable &symbols) {
+  if (object_name >= m_entries.size()) {
+    m_entries.resize(object_name + 1);
+  }
+  if (!m_entries[object_name].valid) {
+    if (m_garbage > min_compact_bytes && m_garbage * 2 > memory_usage()) {
+      compact();
+    }
+    build(m_entries[object_name], object, symbols);
+  }
+  return view(m_entries[object_name]);
+}
+
+void ObjectDigests::invalidate(Symbol object_name) {
+  if (object_name >= m_entries.size() || !m_entries[object_name].valid) {
+    return;
+  }
+  m_garbage += entry_bytes(view(m_entries[object_name]));
+  m_entries[object_name].valid = false;
+}
+
+void ObjectDigests::clear() {
+  m_entries.clear();
+  m_properties.clear();
+  m_references.clear();
+  m_values.clear();
+  m_garbage = 0;
+}
+
+size_t ObjectDigests::memory_usage() const {
+  return m_entries.size() * sizeof(Entry) +
+         m_properties.size() * sizeof(Property) +
+         m_references.size() * sizeof(Symbol) + m_values.size();
+}
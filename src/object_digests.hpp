@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "ndf.hpp"
+#include "symbol_table.hpp"
+
+namespace wgrd_files {
+
+/*
+ * Flat copies of what the indexes of a ndfbin read from its objects.
+ *
+ * The properties of the ndf library are separate heap nodes behind virtual
+ * calls, and as_string/get_object_references/get_import_references allocate
+ * a string or vector on every call. A digest holds the value string of every
+ * property and the interned object and import references of one object, all
+ * digests of a file are stored back to back in a few arrays owned by this
+ * arena. Rebuilding the indexes then only walks the ndf objects that changed
+ * since their digest was taken.
+ *
+ * Digests are built on first use and dropped per object when it changes.
+ * Dropped digests stay in the arrays until they make up half of them, then
+ * the arrays are compacted. Not thread safe.
+ * */
+class ObjectDigests {
+public:
+  struct Property {
+    Symbol property_name;
+    uint32_t value_offset;
+    uint32_t value_size;
+  };
+  // views into the arena, valid until the next call to get
+  struct Digest {
+    // in the order of NDFObject::properties
+    std::span<const Property> properties;
+    std::span<const Symbol> object_references;
+    std::span<const Symbol> import_references;
+    const char *values = nullptr;
+    std::string_view value(const Property &property) const {
+      return std::string_view(values + property.value_offset,
+                              property.value_size);
+    }
+  };
+
+private:
+  struct Entry {
+    uint32_t property_begin = 0;
+    uint32_t property_count = 0;
+    uint32_t reference_begin = 0;
+    uint32_t object_reference_count = 0;
+    uint32_t import_reference_count = 0;
+    bool valid = false;
+  };
+  // by the symbol of the object name
+  std::vector<Entry> m_entries;
+  std::vector<Property> m_properties;
+  // the object references of a digest followed by its import references
+  std::vector<Symbol> m_references;
+  std::vector<char> m_values;
+  // properties, references and value bytes of dropped digests
+  size_t m_garbage = 0;
+  std::vector<Symbol> m_import_scratch;
+
+  Digest view(const Entry &entry) const;
+  void build(Entry &entry, NDFObject &object, SymbolTable &symbols);
+  void compact();
+
+public:
+  // returns the digest of the object, builds it if there is none
+  Digest get(Symbol object_name, NDFObject &object, SymbolTable &symbols);
+  // drops the digest, the next get builds it from the changed object
+  void invalidate(Symbol object_name);
+  void clear();
+  // bytes held by the arrays
+  size_t memory_usage() const;
+};
+
+} // namespace wgrd_files
@@ -0,0 +1,262 @@
+#include "object_search.hpp"
+
+#include "threadpool.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <iterator>
+#include <mutex>
+
+using namespace wgrd_files;
+
+namespace {
+
+std::string to_lower(std::string_view str) {
+  std::string ret(str);
+  for (char &c : ret) {
+    c = std::tolower(static_cast<unsigned char>(c));
+  }
+  return ret;
+}
+
+uint32_t trigram_at(std::string_view str, size_t pos) {
+  return (uint32_t)(unsigned char)str[pos] << 16 |
+         (uint32_t)(unsigned char)str[pos + 1] << 8 |
+         (uint32_t)(unsigned char)str[pos + 2];
+}
+
+// how many texts are checked between two cancellation checks
+constexpr size_t cancel_check_interval = 1024;
+
+} // namespace
+
+void TrigramIndex::add(Symbol id, std::string_view text) {
+  remove(id);
+  std::string lower = to_lower(text);
+  for (size_t i = 0; i + 3 <= lower.size(); i++) {
+    auto &ids = m_postings[trigram_at(lower, i)];
+    // ids are mostly added in increasing order, so this is usually an append
+    auto it = std::lower_bound(ids.begin(), ids.end(), id);
+    if (it == ids.end() || *it != id) {
+      ids.insert(it, id);
+    }
+  }
+  m_texts.emplace(id, std::move(lower));
+}
+
+void TrigramIndex::remove(Symbol id) {
+  auto text_it = m_texts.find(id);
+  if (text_it == m_texts.end()) {
+    return;
+  }
+  const std::string &lower = text_it->second;
+  for (size_t i = 0; i + 3 <= lower.size(); i++) {
+    auto postings_it = m_postings.find(trigram_at(lower, i));
+    if (postings_it == m_postings.end()) {
+      continue;
+    }
+    auto &ids = postings_it->second;
+    auto it = std::lower_bound(ids.begin(), ids.end(), id);
+    if (it != ids.end() && *it == id) {
+      ids.erase(it);
+    }
+    if (ids.empty()) {
+      m_postings.erase(postings_it);
+    }
+  }
+  m_texts.erase(text_it);
+}
+
+void TrigramIndex::clear() {
+  m_texts.clear();
+  m_postings.clear();
+}
+
+std::optional<std::vector<Symbol>>
+TrigramIndex::find(std::string_view needle,
+                   const std::function<bool()> &cancelled) const {
+  std::vector<Symbol> ret;
+  size_t checked = 0;
+  auto check = [&](Symbol id, const std::string &text) -> bool {
+    if (++checked % cancel_check_interval == 0 && cancelled()) {
+      return false;
+    }
+    if (text.find(needle) != std::string::npos) {
+      ret.push_back(id);
+    }
+    return true;
+  };
+
+  if (needle.size() < 3) {
+    // too short for trigrams, but the texts are already lowercase
+    for (auto &[id, text] : m_texts) {
+      if (!check(id, text)) {
+        return std::nullopt;
+      }
+    }
+    std::sort(ret.begin(), ret.end());
+    return ret;
+  }
+
+  std::vector<const std::vector<Symbol> *> postings;
+  for (size_t i = 0; i + 3 <= needle.size(); i++) {
+    auto it = m_postings.find(trigram_at(needle, i));
+    if (it == m_postings.end()) {
+      return ret;
+    }
+    postings.push_back(&it->second);
+  }
+  // intersecting the shortest lists first keeps the candidates small
+  std::sort(postings.begin(), postings.end(),
+            [](auto *a, auto *b) { return a->size() < b->size(); });
+  std::vector<Symbol> candidates = *postings.front();
+  for (size_t i = 1; i < postings.size() && !candidates.empty(); i++) {
+    if (cancelled()) {
+      return std::nullopt;
+    }
+    std::vector<Symbol> intersection;
+    std::set_intersection(candidates.begin(), candidates.end(),
+                          postings[i]->begin(), postings[i]->end(),
+                          std::back_inserter(intersection));
+    candidates = std::move(intersection);
+  }
+  // the trigrams don't need to be adjacent, so the candidates are verified
+  for (Symbol id : candidates) {
+    if (!check(id, m_texts.at(id))) {
+      return std::nullopt;
+    }
+  }
+  return ret;
+}
+
+void ObjectSearch::add_object(Symbol object_name, std::string_view name,
+                              Symbol class_name, std::string_view class_str) {
+  // stops running queries, so the lock is not held up by them. their results
+  // are outdated anyway.
+  m_generation++;
+  std::unique_lock lock(m_mutex);
+  auto it = m_object_class.find(object_name);
+  if (it != m_object_class.end()) {
+    m_class_objects[it->second].erase(object_name);
+  }
+  m_names.add(object_name, name);
+  m_object_class[object_name] = class_name;
+  auto &class_objects = m_class_objects[class_name];
+  if (class_objects.empty()) {
+    m_classes.add(class_name, class_str);
+  }
+  class_objects.insert(object_name);
+}
+
+void ObjectSearch::remove_object(Symbol object_name) {
+  m_generation++;
+  std::unique_lock lock(m_mutex);
+  auto it = m_object_class.find(object_name);
+  if (it == m_object_class.end()) {
+    return;
+  }
+  auto class_it = m_class_objects.find(it->second);
+  if (class_it != m_class_objects.end()) {
+    class_it->second.erase(object_name);
+    if (class_it->second.empty()) {
+      m_classes.remove(class_it->first);
+      m_class_objects.erase(class_it);
+    }
+  }
+  m_names.remove(object_name);
+  m_object_class.erase(it);
+}
+
+void ObjectSearch::clear() {
+  cancel();
+  std::unique_lock lock(m_mutex);
+  m_names.clear();
+  m_classes.clear();
+  m_object_class.clear();
+  m_class_objects.clear();
+}
+
+std::optional<std::vector<Symbol>>
+ObjectSearch::query(std::string object_filter, std::string class_filter,
+                    uint64_t generation) const {
+  std::shared_lock lock(m_mutex);
+  auto cancelled = [this, generation]() {
+    return m_generation != generation;
+  };
+
+  if (object_filter.empty() && class_filter.empty()) {
+    std::vector<Symbol> ret;
+    ret.reserve(m_object_class.size());
+    for (auto &[object_name, _] : m_object_class) {
+      ret.push_back(object_name);
+    }
+    std::sort(ret.begin(), ret.end());
+    return ret;
+  }
+
+  std::optional<std::vector<Symbol>> objects;
+  if (!object_filter.empty()) {
+    objects = m_names.find(object_filter, cancelled);
+    if (!objects) {
+      return std::nullopt;
+    }
+  }
+  if (class_filter.empty()) {
+    return objects;
+  }
+
+  auto classes = m_classes.find(class_filter, cancelled);
+  if (!classes) {
+    return std::nullopt;
+  }
+  std::vector<Symbol> ret;
+  if (objects) {
+    std::unordered_set<Symbol> class_set(classes->begin(), classes->end());
+    for (Symbol object_name : objects.value()) {
+      if (class_set.contains(m_object_class.at(object_name))) {
+        ret.push_back(object_name);
+      }
+    }
+    return ret;
+  }
+  for (Symbol class_name : classes.value()) {
+    if (cancelled()) {
+      return std::nullopt;
+    }
+    auto &class_objects = m_class_objects.at(class_name);
+    ret.insert(ret.end(), class_objects.begin(), class_objects.end());
+  }
+  std::sort(ret.begin(), ret.end());
+  return ret;
+}
+
+void ObjectSearch::start_query(std::string object_filter,
+                               std::string class_filter) {
+  uint64_t generation = ++m_generation;
+  m_pending_token.cancel();
+  m_pending_token = CancellationToken();
+  m_pending = ThreadPoolSingleton::get_instance().submit(
+      TaskPriority::VISIBLE,
+      [self = shared_from_this(), object_filter = std::move(object_filter),
+       class_filter = std::move(class_filter), generation]() {
+        return self->query(object_filter, class_filter, generation);
+      },
+      m_pending_token);
+}
+
+void ObjectSearch::cancel() {
+  m_generation++;
+  m_pending_token.cancel();
+  m_pending.reset();
+}
+
+std::optional<std::vector<Symbol>> ObjectSearch::take_result() {
+  if (!m_pending ||
+      m_pending->wait_for(std::chrono::seconds(0)) !=
+          std::future_status::ready) {
+    return std::nullopt;
+  }
+  auto ret = m_pending->get();
+  m_pending.reset();
+  return ret;
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <memory>
+#include <optional>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "symbol_table.hpp"
+#include "task_scheduler.hpp"
+
+namespace wgrd_files {
+
+/*
+ * Lowercase trigram index answering substring queries.
+ *
+ * Every indexed text is split into all its three byte windows, a query only
+ * has to check the texts containing all trigrams of the needle. Not thread
+ * safe.
+ * */
+class TrigramIndex {
+private:
+  // id -> lowercase text
+  std::unordered_map<Symbol, std::string> m_texts;
+  // trigram -> sorted ids of the texts containing it
+  std::unordered_map<uint32_t, std::vector<Symbol>> m_postings;
+
+public:
+  void add(Symbol id, std::string_view text);
+  void remove(Symbol id);
+  void clear();
+  size_t size() const { return m_texts.size(); }
+  // returns the sorted ids of all texts containing the lowercase needle, or
+  // nullopt if cancelled returned true while searching
+  std::optional<std::vector<Symbol>>
+  find(std::string_view needle, const std::function<bool()> &cancelled) const;
+};
+
+/*
+ * Searches the objects of a ndfbin by object and class name.
+ *
+ * Queries run on the thread pool, starting a new query supersedes the
+ * running one, which then stops at its next cancellation check. Only the
+ * result of the latest query is ever returned.
+ * */
+class ObjectSearch : public std::enable_shared_from_this<ObjectSearch> {
+private:
+  mutable std::shared_mutex m_mutex;
+  TrigramIndex m_names;
+  TrigramIndex m_classes;
+  std::unordered_map<Symbol, Symbol> m_object_class;
+  std::unordered_map<Symbol, std::unordered_set<Symbol>> m_class_objects;
+
+  std::atomic_uint64_t m_generation = 0;
+  std::optional<std::future<std::optional<std::vector<Symbol>>>> m_pending;
+  // drops the pending query if it didn't start yet
+  CancellationToken m_pending_token;
+
+  std::optional<std::vector<Symbol>> query(std::string object_filter,
+                                           std::string class_filter,
+                                           uint64_t generation) const;
+
+public:
+  // changing the index cancels the running query
+  void add_object(Symbol object_name, std::string_view name,
+                  Symbol class_name, std::string_view class_str);
+  void remove_object(Symbol object_name);
+  void clear();
+
+  // the filters need to be lowercase already
+  void start_query(std::string object_filter, std::string class_filter);
+  // drops the running query, its result is never returned
+  void cancel();
+  bool is_pending() const { return m_pending.has_value(); }
+  // returns the result once the latest query is done
+  std::optional<std::vector<Symbol>> take_result();
+};
+
+} // namespace wgrd_files
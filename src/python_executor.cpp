@@ -0,0 +1,80 @@
+#include "python_executor.hpp"
+
+#include <pybind11/pybind11.h>
+namespace py = pybind11;
+
+#include "spdlog/spdlog.h"
+#include "trace.hpp"
+
+using namespace wgrd_files;
+
+PythonExecutor &PythonExecutor::get_instance() {
+  static PythonExecutor instance;
+  return instance;
+}
+
+PythonExecutor::PythonExecutor() {
+  m_thread = std::thread([this]() { work(); });
+}
+
+PythonExecutor::~PythonExecutor() { shutdown(); }
+
+bool PythonExecutor::is_executor_thread() const {
+  return std::this_thread::get_id() == m_thread.get_id();
+}
+
+void PythonExecutor::rethrow_converted() {
+  try {
+    throw;
+  } catch (const py::error_already_set &e) {
+    throw PythonError(e.what());
+  }
+}
+
+void PythonExecutor::push(std::move_only_function<void()> call) {
+  {
+    std::lock_guard lock(m_mutex);
+    if (m_shutdown) {
+      // dropping the call breaks its promise
+      spdlog::error("Python call submitted after shutdown");
+      return;
+    }
+    m_calls.push_back(std::move(call));
+  }
+  m_wakeup.notify_one();
+}
+
+void PythonExecutor::work() {
+  Tracer::set_thread_name("python");
+  std::vector<std::move_only_function<void()>> batch;
+  while (true) {
+    {
+      std::unique_lock lock(m_mutex);
+      m_wakeup.wait(lock, [this]() { return m_shutdown || !m_calls.empty(); });
+      if (m_calls.empty()) {
+        return;
+      }
+      std::swap(batch, m_calls);
+    }
+    {
+      py::gil_scoped_acquire acquire;
+      for (auto &call : batch) {
+        ScopedTrace trace("python call");
+        call();
+      }
+      // the calls may still hold python objects
+      batch.clear();
+    }
+  }
+}
+
+void PythonExecutor::shutdown() {
+  {
+    std::lock_guard lock(m_mutex);
+    m_shutdown = true;
+  }
+  m_wakeup.notify_all();
+  if (m_thread.joinable()) {
+    m_thread.join();
+  }
+}
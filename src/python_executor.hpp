@@ -0,0 +1,92 @@
+#pragma once
+
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "threadpool.hpp"
+
+namespace wgrd_files {
+
+// a python exception, converted on the executor so no python object leaves it
+class PythonError : public std::runtime_error {
+public:
+  using std::runtime_error::runtime_error;
+};
+
+/*
+ * Runs all python calls of the file loaders on one thread.
+ *
+ * The thread takes the GIL once per batch of queued calls and releases it in
+ * between, so the gui thread can still get it. Calls must convert their
+ * results to C++ types before returning, only those cross back to the
+ * callers. Everything else of a file load (reading the data, filling the
+ * C++ structures) stays on the scheduler and runs in parallel, instead of
+ * every worker blocking on the GIL.
+ * */
+class PythonExecutor {
+private:
+  std::mutex m_mutex;
+  std::condition_variable m_wakeup;
+  std::vector<std::move_only_function<void()>> m_calls;
+  bool m_shutdown = false;
+  std::thread m_thread;
+
+  void push(std::move_only_function<void()> call);
+  void work();
+
+public:
+  // the interpreter needs to be initialized before the first call runs
+  static PythonExecutor &get_instance();
+
+  PythonExecutor();
+  ~PythonExecutor();
+  PythonExecutor(const PythonExecutor &) = delete;
+  PythonExecutor &operator=(const PythonExecutor &) = delete;
+
+  bool is_executor_thread() const;
+
+  // queues f, its python exceptions are thrown as PythonError by the future
+  template <typename F>
+  auto submit(F &&f) -> std::future<std::invoke_result_t<std::decay_t<F>>> {
+    typedef std::invoke_result_t<std::decay_t<F>> R;
+    std::packaged_task<R()> task(
+        [f = std::forward<F>(f)]() mutable { return call_python(f); });
+    auto ret = task.get_future();
+    push(std::move(task));
+    return ret;
+  }
+
+  // runs f on the executor and waits for it, scheduler workers run other
+  // tasks while waiting
+  template <typename F> auto run(F &&f) {
+    if (is_executor_thread()) {
+      return call_python(f);
+    }
+    auto future = submit(std::forward<F>(f));
+    ThreadPoolSingleton::get_instance().wait(future);
+    return future.get();
+  }
+
+  // runs the queued calls and stops the thread, needs to be called before
+  // the interpreter is finalized
+  void shutdown();
+
+private:
+  template <typename F> static auto call_python(F &f) {
+    try {
+      return f();
+    } catch (...) {
+      rethrow_converted();
+    }
+  }
+  // rethrows the current exception, python ones as PythonError
+  [[noreturn]] static void rethrow_converted();
+};
+
+} // namespace wgrd_files
@@ -0,0 +1,88 @@
+#include "reference_index.hpp"
+
+#include <mutex>
+
+using namespace wgrd_files;
+
+void ReferenceIndex::replace_import(const std::string &vfs_path,
+                                    const std::string &export_path,
+                                    ObjectNames object_names) {
+  auto it = m_imports.find(export_path);
+  if (it == m_imports.end()) {
+    if (object_names.empty()) {
+      return;
+    }
+    it = m_imports.emplace(export_path, std::make_shared<Importers>()).first;
+  } else if (it->second.use_count() > 1) {
+    // a reader still holds the importers. readers only take them under the
+    // shared lock, so the count can't grow while this holds the unique one.
+    it->second = std::make_shared<Importers>(*it->second);
+  }
+  auto &importers = *it->second;
+  if (object_names.empty()) {
+    importers.erase(vfs_path);
+  } else {
+    importers[vfs_path] =
+        std::make_shared<const ObjectNames>(std::move(object_names));
+  }
+  if (importers.empty()) {
+    m_imports.erase(it);
+  }
+}
+
+void ReferenceIndex::set_file_imports(
+    const std::string &vfs_path,
+    const std::unordered_map<std::string, std::unordered_set<std::string>>
+        &imports) {
+  std::unique_lock lock(m_mutex);
+  auto &file_exports = m_files[vfs_path];
+  for (auto &export_path : file_exports) {
+    if (!imports.contains(export_path)) {
+      replace_import(vfs_path, export_path, {});
+    }
+  }
+  file_exports.clear();
+  for (auto &[export_path, object_names] : imports) {
+    replace_import(vfs_path, export_path,
+                   ObjectNames(object_names.begin(), object_names.end()));
+    if (!object_names.empty()) {
+      file_exports.insert(export_path);
+    }
+  }
+}
+
+void ReferenceIndex::set_imports(
+    const std::string &vfs_path, const std::string &export_path,
+    const std::unordered_set<std::string> &object_names) {
+  std::unique_lock lock(m_mutex);
+  auto &file_exports = m_files[vfs_path];
+  replace_import(vfs_path, export_path,
+                 ObjectNames(object_names.begin(), object_names.end()));
+  if (object_names.empty()) {
+    file_exports.erase(export_path);
+  } else {
+    file_exports.insert(export_path);
+  }
+}
+
+void ReferenceIndex::remove_file(const std::string &vfs_path) {
+  std::unique_lock lock(m_mutex);
+  auto it = m_files.find(vfs_path);
+  if (it == m_files.end()) {
+    return;
+  }
+  for (auto &export_path : it->second) {
+    replace_import(vfs_path, export_path, {});
+  }
+  m_files.erase(it);
+}
+
+std::shared_ptr<const ReferenceIndex::Importers>
+ReferenceIndex::get_importers(const std::string &export_path) const {
+  std::shared_lock lock(m_mutex);
+  auto it = m_imports.find(export_path);
+  if (it == m_imports.end()) {
+    return nullptr;
+  }
+  return it->second;
+}
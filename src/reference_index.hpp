@@ -0,0 +1,62 @@
+#pragma once
+
+#include <map>
+#include <memory>
+#include <set>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace wgrd_files {
+
+/*
+ * Maps export paths to the objects importing them, across all loaded
+ * ndfbins of a workspace.
+ *
+ * Every ndfbin publishes its own imports when it is loaded and when an edit
+ * changes them, so looking up who imports an exported object never touches
+ * the other files. Thread safe, files are loaded in parallel. Importers
+ * handed out to readers never change, so they can be held on to without
+ * copying or locking. Updates change the importers in place while no reader
+ * holds them and replace them with a copy otherwise, the object sets of the
+ * files are shared between the copies.
+ * */
+class ReferenceIndex {
+public:
+  // names of the objects of one file importing the export path
+  typedef std::set<std::string> ObjectNames;
+  // vfs_path -> objects importing the export path
+  typedef std::map<std::string, std::shared_ptr<const ObjectNames>> Importers;
+
+private:
+  mutable std::shared_mutex m_mutex;
+  // export_path -> files and objects importing it
+  std::unordered_map<std::string, std::shared_ptr<Importers>> m_imports;
+  // vfs_path -> export paths imported by the file
+  std::unordered_map<std::string, std::unordered_set<std::string>> m_files;
+
+  // replaces the objects of the file importing export_path with
+  // object_names, an empty set removes the file
+  void replace_import(const std::string &vfs_path,
+                      const std::string &export_path,
+                      ObjectNames object_names);
+
+public:
+  // replaces everything the file imports
+  void set_file_imports(
+      const std::string &vfs_path,
+      const std::unordered_map<std::string, std::unordered_set<std::string>>
+          &imports);
+  // replaces the objects of the file importing export_path, an empty set
+  // removes the entry
+  void set_imports(const std::string &vfs_path, const std::string &export_path,
+                   const std::unordered_set<std::string> &object_names);
+  void remove_file(const std::string &vfs_path);
+  // the importers at the time of the call, nullptr if there are none
+  std::shared_ptr<const Importers>
+  get_importers(const std::string &export_path) const;
+};
+
+} // namespace wgrd_files
@@ -0,0 +1,46 @@
+#include "symbol_table.hpp"
+
+#include <cstring>
+
+using namespace wgrd_files;
+
+std::string_view SymbolTable::store(std::string_view str) {
+  size_t size = str.size() + 1;
+  char *dest;
+  if (size > block_size / 4) {
+    // big strings get their own allocation, so they don't waste a block
+    m_large.push_back(std::make_unique<char[]>(size));
+    m_large_size += size;
+    dest = m_large.back().get();
+  } else {
+    if (block_size - m_block_used < size) {
+      m_blocks.push_back(std::make_unique<char[]>(block_size));
+      m_block_used = 0;
+    }
+    dest = m_blocks.back().get() + m_block_used;
+    m_block_used += size;
+  }
+  std::memcpy(dest, str.data(), str.size());
+  dest[str.size()] = '\0';
+  return std::string_view(dest, str.size());
+}
+
+Symbol SymbolTable::intern(std::string_view str) {
+  auto it = m_ids.find(str);
+  if (it != m_ids.end()) {
+    return it->second;
+  }
+  std::string_view stored = store(str);
+  Symbol ret = m_strings.size();
+  m_strings.push_back(stored);
+  m_ids.emplace(stored, ret);
+  return ret;
+}
+
+std::optional<Symbol> SymbolTable::find(std::string_view str) const {
+  auto it = m_ids.find(str);
+  if (it == m_ids.end()) {
+    return std::nullopt;
+  }
+  return it->second;
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace wgrd_files {
+
+// id of an interned string, only valid for the table that created it
+typedef uint32_t Symbol;
+
+/*
+ * Interns strings into stable integer ids.
+ *
+ * Every distinct string is stored once in a chunked arena, so the indexes of
+ * a ndfbin can hold ids instead of copies of object, class and property names.
+ * The arena never moves its strings, the returned views stay valid until the
+ * table is destroyed. Not thread safe.
+ * */
+class SymbolTable {
+private:
+  static constexpr size_t block_size = 64 * 1024;
+  std::vector<std::unique_ptr<char[]>> m_blocks;
+  size_t m_block_used = block_size;
+  std::vector<std::unique_ptr<char[]>> m_large;
+  size_t m_large_size = 0;
+  // symbol -> string, the strings are null terminated inside the arena
+  std::vector<std::string_view> m_strings;
+  std::unordered_map<std::string_view, Symbol> m_ids;
+
+  std::string_view store(std::string_view str);
+
+public:
+  SymbolTable() = default;
+  SymbolTable(const SymbolTable &) = delete;
+  SymbolTable &operator=(const SymbolTable &) = delete;
+
+  // returns the id of the string, inserting it if it is new
+  Symbol intern(std::string_view str);
+  // returns nullopt if the string was never interned
+  std::optional<Symbol> find(std::string_view str) const;
+  std::string_view str(Symbol symbol) const { return m_strings[symbol]; }
+  const char *c_str(Symbol symbol) const { return m_strings[symbol].data(); }
+  size_t size() const { return m_strings.size(); }
+  // bytes held by the arena
+  size_t memory_usage() const {
+    return m_blocks.size() * block_size + m_large_size;
+  }
+};
+
+} // namespace wgrd_files
@@ -0,0 +1,146 @@
+#include "task_scheduler.hpp"
+
+#include "spdlog/spdlog.h"
+#include "trace.hpp"
+
+#include <algorithm>
+#include <format>
+
+using namespace wgrd_files;
+
+namespace {
+
+// the scheduler and index of the worker running on this thread
+thread_local const TaskScheduler *current_scheduler = nullptr;
+thread_local size_t current_worker = 0;
+
+} // namespace
+
+TaskScheduler::TaskScheduler(size_t worker_count) {
+  if (worker_count == 0) {
+    worker_count = std::max(std::thread::hardware_concurrency(), 2u);
+  }
+  m_workers.reserve(worker_count);
+  for (size_t i = 0; i < worker_count; i++) {
+    m_workers.push_back(std::make_unique<Worker>());
+  }
+  // started after all workers exist, they steal from each other
+  for (size_t i = 0; i < worker_count; i++) {
+    m_workers[i]->thread = std::thread([this, i]() { work(i); });
+  }
+}
+
+TaskScheduler::~TaskScheduler() { shutdown(); }
+
+void TaskScheduler::push(TaskPriority priority, Task task) {
+  auto idx = static_cast<size_t>(priority);
+  Queue &queue = current_scheduler == this
+                     ? m_workers[current_worker]->queues[idx]
+                     : m_shared[idx];
+  // counted before the task is visible, otherwise a worker could take it
+  // and decrement m_pending below zero first
+  m_pending++;
+  {
+    std::lock_guard lock(queue.mutex);
+    queue.tasks.push_back(std::move(task));
+  }
+  // taking the lock orders this with a worker checking m_pending before
+  // going to sleep, so the wakeup can't get lost
+  { std::lock_guard lock(m_sleep_mutex); }
+  m_wakeup.notify_one();
+}
+
+std::optional<TaskScheduler::Task> TaskScheduler::pop(size_t worker_idx) {
+  auto take = [this](Queue &queue, bool back) -> std::optional<Task> {
+    std::lock_guard lock(queue.mutex);
+    if (queue.tasks.empty()) {
+      return std::nullopt;
+    }
+    Task ret;
+    if (back) {
+      ret = std::move(queue.tasks.back());
+      queue.tasks.pop_back();
+    } else {
+      ret = std::move(queue.tasks.front());
+      queue.tasks.pop_front();
+    }
+    m_pending--;
+    return ret;
+  };
+  for (size_t prio = 0; prio < task_priority_count; prio++) {
+    // the newest own task is the most likely to still be in the cache
+    if (auto task = take(m_workers[worker_idx]->queues[prio], true)) {
+      return task;
+    }
+    if (auto task = take(m_shared[prio], false)) {
+      return task;
+    }
+    for (size_t i = 1; i < m_workers.size(); i++) {
+      size_t victim = (worker_idx + i) % m_workers.size();
+      if (auto task = take(m_workers[victim]->queues[prio], false)) {
+        return task;
+      }
+    }
+  }
+  return std::nullopt;
+}
+
+void TaskScheduler::work(size_t worker_idx) {
+  current_scheduler = this;
+  current_worker = worker_idx;
+  Tracer::set_thread_name(std::format("worker {}", worker_idx));
+  while (true) {
+    auto task = pop(worker_idx);
+    if (!task) {
+      std::unique_lock lock(m_sleep_mutex);
+      m_wakeup.wait(lock, [this]() { return m_shutdown || m_pending > 0; });
+      if (m_shutdown) {
+        return;
+      }
+      continue;
+    }
+    if (task->token.is_cancelled()) {
+      continue;
+    }
+    task->run();
+    if (m_shutdown) {
+      return;
+    }
+  }
+}
+
+bool TaskScheduler::is_worker() const { return current_scheduler == this; }
+
+bool TaskScheduler::run_pending() {
+  if (!is_worker() || m_shutdown) {
+    return false;
+  }
+  auto task = pop(current_worker);
+  if (!task) {
+    return false;
+  }
+  if (!task->token.is_cancelled()) {
+    task->run();
+  }
+  return true;
+}
+
+void TaskScheduler::shutdown() {
+  {
+    std::lock_guard lock(m_sleep_mutex);
+    if (m_shutdown) {
+      return;
+    }
+    m_shutdown = true;
+  }
+  m_wakeup.notify_all();
+  for (auto &worker : m_workers) {
+    if (worker->thread.joinable()) {
+      worker->thread.join();
+    }
+  }
+  size_t dropped = m_pending;
+  if (dropped) {
+    spdlog::debug("Dropped {} queued tasks on shutdown", dropped);
+  }
+}
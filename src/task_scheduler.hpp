@@ -0,0 +1,127 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace wgrd_files {
+
+// queued tasks of a higher priority always run before those of a lower one
+enum class TaskPriority : uint8_t {
+  // the user waits for it, e.g. opening a file
+  INTERACTIVE = 0,
+  // shown as soon as it is done, e.g. searches or the progress of a save
+  VISIBLE = 1,
+  // preloading and indexing
+  BACKGROUND = 2,
+};
+constexpr size_t task_priority_count = 3;
+
+// shared between copies, cancelling one cancels all
+class CancellationToken {
+private:
+  std::shared_ptr<std::atomic_bool> m_cancelled =
+      std::make_shared<std::atomic_bool>(false);
+
+public:
+  void cancel() { *m_cancelled = true; }
+  bool is_cancelled() const { return *m_cancelled; }
+};
+
+/*
+ * Runs tasks on one worker per hardware thread.
+ *
+ * Every worker has its own deque per priority. Tasks submitted by a worker
+ * go to its own deque and are taken from the back by it, tasks submitted by
+ * other threads go to a shared queue. Idle workers steal from the front of
+ * the other workers' deques. Before running anything of a lower priority a
+ * worker looks for higher priority tasks everywhere.
+ *
+ * Tasks whose token is cancelled before they start are dropped, their
+ * futures then throw a broken_promise future_error.
+ * */
+class TaskScheduler {
+private:
+  struct Task {
+    std::move_only_function<void()> run;
+    CancellationToken token;
+  };
+  struct Queue {
+    std::mutex mutex;
+    std::deque<Task> tasks;
+  };
+  typedef std::array<Queue, task_priority_count> Queues;
+  struct Worker {
+    Queues queues;
+    std::thread thread;
+  };
+
+  std::vector<std::unique_ptr<Worker>> m_workers;
+  // tasks submitted from outside the workers
+  Queues m_shared;
+  // queued and not yet taken tasks
+  std::atomic_size_t m_pending = 0;
+  std::mutex m_sleep_mutex;
+  std::condition_variable m_wakeup;
+  // only set while holding m_sleep_mutex
+  std::atomic_bool m_shutdown = false;
+
+  void push(TaskPriority priority, Task task);
+  std::optional<Task> pop(size_t worker_idx);
+  void work(size_t worker_idx);
+
+public:
+  // 0 uses one worker per hardware thread
+  explicit TaskScheduler(size_t worker_count = 0);
+  ~TaskScheduler();
+  TaskScheduler(const TaskScheduler &) = delete;
+  TaskScheduler &operator=(const TaskScheduler &) = delete;
+
+  size_t get_worker_count() const { return m_workers.size(); }
+
+  template <typename F>
+  auto submit(TaskPriority priority, F &&f, CancellationToken token = {})
+      -> std::future<std::invoke_result_t<std::decay_t<F>>> {
+    typedef std::invoke_result_t<std::decay_t<F>> R;
+    std::packaged_task<R()> task(std::forward<F>(f));
+    auto ret = task.get_future();
+    push(priority, Task{std::move(task), std::move(token)});
+    return ret;
+  }
+
+  // waits for the future, a worker of this scheduler runs other queued tasks
+  // meanwhile instead of sitting idle
+  template <typename T> void wait(const std::future<T> &future) {
+    while (future.wait_for(std::chrono::seconds(0)) !=
+           std::future_status::ready) {
+      if (!run_pending()) {
+        if (!is_worker()) {
+          future.wait();
+          return;
+        }
+        future.wait_for(std::chrono::milliseconds(1));
+      }
+    }
+  }
+  // whether the calling thread is one of the workers
+  bool is_worker() const;
+  // runs one queued task on the calling worker, false if there was none or
+  // this isn't called from a worker
+  bool run_pending();
+
+  // stops the workers after their current task, queued tasks are dropped
+  void shutdown();
+};
+
+} // namespace wgrd_files
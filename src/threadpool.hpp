@@ -1,16 +1,12 @@
 #pragma once
 
-#include "ThreadPool.h"
+#include "task_scheduler.hpp"
 
+// the scheduler running all background work of the program
 class ThreadPoolSingleton {
 public:
-  static ThreadPool &get_instance() {
-    static ThreadPool instance(32);
-    static bool initialized = false;
-    if (!initialized) {
-      instance.init();
-      initialized = true;
-    }
+  static wgrd_files::TaskScheduler &get_instance() {
+    static wgrd_files::TaskScheduler instance;
     return instance;
   }
 
@@ -0,0 +1,343 @@
+#include "trace.hpp"
+
+#include "spdlog/spdlog.h"
+
+#include <algorithm>
+#include <format>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <mutex>
+
+#include <imgui.h>
+#include <imgui_stdlib.h>
+#include <libintl.h>
+
+using namespace wgrd_files;
+
+namespace {
+
+const auto trace_epoch = std::chrono::steady_clock::now();
+
+struct ThreadBuffer {
+  std::mutex mutex;
+  uint32_t id = 0;
+  std::string name;
+  std::vector<TraceEvent> events;
+  // the oldest event, once the buffer is full
+  size_t next = 0;
+};
+
+struct Registry {
+  std::mutex mutex;
+  // kept after their thread exits, so its events can still be collected
+  std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+};
+
+Registry &get_registry() {
+  static Registry registry;
+  return registry;
+}
+
+ThreadBuffer &get_thread_buffer() {
+  thread_local std::shared_ptr<ThreadBuffer> buffer = []() {
+    auto ret = std::make_shared<ThreadBuffer>();
+    auto &registry = get_registry();
+    std::lock_guard lock(registry.mutex);
+    ret->id = registry.buffers.size() + 1;
+    ret->name = std::format("thread {}", ret->id);
+    registry.buffers.push_back(ret);
+    return ret;
+  }();
+  return *buffer;
+}
+
+std::vector<std::shared_ptr<ThreadBuffer>> get_buffers() {
+  auto &registry = get_registry();
+  std::lock_guard lock(registry.mutex);
+  return registry.buffers;
+}
+
+std::string json_escape(std::string_view str) {
+  std::string ret;
+  ret.reserve(str.size());
+  for (char c : str) {
+    switch (c) {
+    case '"':
+      ret += "\\\"";
+      break;
+    case '\\':
+      ret += "\\\\";
+      break;
+    case '\n':
+      ret += "\\n";
+      break;
+    case '\t':
+      ret += "\\t";
+      break;
+    default:
+      if (static_cast<unsigned char>(c) < 0x20) {
+        ret += std::format("\\u{:04x}", static_cast<int>(c));
+      } else {
+        ret += c;
+      }
+    }
+  }
+  return ret;
+}
+
+ImU32 event_color(const char *name) {
+  size_t hash = std::hash<std::string_view>{}(name);
+  return ImColor::HSV((hash % 360) / 360.0f, 0.5f, 0.75f);
+}
+
+} // namespace
+
+void Tracer::set_enabled(bool enabled) {
+  s_enabled.store(enabled, std::memory_order_relaxed);
+  spdlog::info("Tracing {}", enabled ? "enabled" : "disabled");
+}
+
+int64_t Tracer::now_ns() {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(
+             std::chrono::steady_clock::now() - trace_epoch)
+      .count();
+}
+
+void Tracer::set_thread_name(std::string name) {
+  auto &buffer = get_thread_buffer();
+  std::lock_guard lock(buffer.mutex);
+  buffer.name = std::move(name);
+}
+
+void Tracer::record(const char *name, std::string detail, int64_t start_ns,
+                    int64_t end_ns) {
+  auto &buffer = get_thread_buffer();
+  TraceEvent event{name, std::move(detail), start_ns, end_ns - start_ns};
+  std::lock_guard lock(buffer.mutex);
+  if (buffer.events.size() < trace_buffer_size) {
+    buffer.events.push_back(std::move(event));
+    return;
+  }
+  buffer.events[buffer.next] = std::move(event);
+  buffer.next = (buffer.next + 1) % trace_buffer_size;
+}
+
+void Tracer::clear() {
+  for (auto &buffer : get_buffers()) {
+    std::lock_guard lock(buffer->mutex);
+    buffer->events.clear();
+    buffer->next = 0;
+  }
+}
+
+std::vector<TraceThread> Tracer::collect(int64_t since_ns) {
+  std::vector<TraceThread> ret;
+  for (auto &buffer : get_buffers()) {
+    TraceThread thread;
+    {
+      std::lock_guard lock(buffer->mutex);
+      thread.id = buffer->id;
+      thread.name = buffer->name;
+      for (auto &event : buffer->events) {
+        if (event.start_ns + event.duration_ns >= since_ns) {
+          thread.events.push_back(event);
+        }
+      }
+    }
+    if (thread.events.empty()) {
+      continue;
+    }
+    // events are recorded when they end, parents go before their children
+    std::sort(thread.events.begin(), thread.events.end(),
+              [](const TraceEvent &a, const TraceEvent &b) {
+                if (a.start_ns != b.start_ns) {
+                  return a.start_ns < b.start_ns;
+                }
+                return a.duration_ns > b.duration_ns;
+              });
+    ret.push_back(std::move(thread));
+  }
+  return ret;
+}
+
+bool Tracer::export_chrome_trace(const fs::path &path) {
+  auto threads = collect();
+  std::ofstream file(path, std::ios::out | std::ios::trunc);
+  if (!file) {
+    spdlog::error("Could not open {}", path.string());
+    return false;
+  }
+  size_t count = 0;
+  file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+  bool first = true;
+  for (auto &thread : threads) {
+    file << std::format("{}{{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,"
+                        "\"tid\":{},\"args\":{{\"name\":\"{}\"}}}}",
+                        first ? "" : ",\n", thread.id,
+                        json_escape(thread.name));
+    first = false;
+    for (auto &event : thread.events) {
+      // microseconds with fractions
+      file << std::format(",\n{{\"name\":\"{}\",\"cat\":\"modding_suite\","
+                          "\"ph\":\"X\",\"pid\":1,\"tid\":{},\"ts\":{:.3f},"
+                          "\"dur\":{:.3f},\"args\":{{\"detail\":\"{}\"}}}}",
+                          json_escape(event.name), thread.id,
+                          event.start_ns / 1000.0, event.duration_ns / 1000.0,
+                          json_escape(event.detail));
+      count++;
+    }
+  }
+  file << "]}\n";
+  file.close();
+  if (!file) {
+    spdlog::error("Could not write {}", path.string());
+    return false;
+  }
+  spdlog::info("Exported {} trace events to {}", count, path.string());
+  return true;
+}
+
+void TraceWindow::render() {
+  if (!open) {
+    return;
+  }
+  if (!ImGui::Begin(gettext("Trace"), &open)) {
+    ImGui::End();
+    return;
+  }
+
+  bool enabled = Tracer::is_enabled();
+  if (ImGui::Checkbox(gettext("Record"), &enabled)) {
+    Tracer::set_enabled(enabled);
+  }
+  ImGui::SameLine();
+  if (ImGui::Button(gettext("Clear"))) {
+    Tracer::clear();
+  }
+  ImGui::SameLine();
+  ImGui::Checkbox(gettext("Follow"), &m_follow);
+  ImGui::SameLine();
+  ImGui::SetNextItemWidth(200.0f);
+  ImGui::SliderFloat(gettext("Range"), &m_range_s, 0.01f, 600.0f, "%.2fs",
+                     ImGuiSliderFlags_Logarithmic);
+  ImGui::SetNextItemWidth(300.0f);
+  ImGui::InputText("##trace_export_path", &m_export_path);
+  ImGui::SameLine();
+  if (ImGui::Button(gettext("Export Chrome trace"))) {
+    Tracer::export_chrome_trace(m_export_path);
+  }
+
+  if (m_follow || m_end_ns == 0) {
+    m_end_ns = Tracer::now_ns();
+  }
+  int64_t range_ns = std::max<int64_t>(m_range_s * 1e9, 1);
+  int64_t start_ns = m_end_ns - range_ns;
+  auto threads = Tracer::collect(start_ns);
+
+  struct Totals {
+    size_t count = 0;
+    int64_t total_ns = 0;
+    int64_t max_ns = 0;
+  };
+  std::map<std::string_view, Totals> totals;
+  const TraceEvent *hovered = nullptr;
+
+  float label_width = 120.0f;
+  float bar_height = ImGui::GetTextLineHeight() + 4.0f;
+  ImGui::BeginChild("##timeline",
+                    ImVec2(0, ImGui::GetContentRegionAvail().y * 0.6f), true);
+  float width = std::max(ImGui::GetContentRegionAvail().x - label_width, 1.0f);
+  double scale = width / range_ns;
+  ImDrawList *draw_list = ImGui::GetWindowDrawList();
+  for (auto &thread : threads) {
+    // nested events are drawn below their parent
+    std::vector<size_t> depths;
+    std::vector<int64_t> ends;
+    size_t max_depth = 0;
+    for (auto &event : thread.events) {
+      while (!ends.empty() && ends.back() <= event.start_ns) {
+        ends.pop_back();
+      }
+      depths.push_back(ends.size());
+      max_depth = std::max(max_depth, ends.size());
+      ends.push_back(event.start_ns + event.duration_ns);
+    }
+
+    ImVec2 origin = ImGui::GetCursorScreenPos();
+    float row_height = (max_depth + 1) * bar_height;
+    draw_list->AddText(origin, ImGui::GetColorU32(ImGuiCol_Text),
+                       thread.name.c_str());
+    float left = origin.x + label_width;
+    float right = left + width;
+    for (size_t i = 0; i < thread.events.size(); i++) {
+      auto &event = thread.events[i];
+      if (event.start_ns > m_end_ns) {
+        continue;
+      }
+      auto &total = totals[event.name];
+      total.count++;
+      total.total_ns += event.duration_ns;
+      total.max_ns = std::max(total.max_ns, event.duration_ns);
+
+      float x0 = left + (event.start_ns - start_ns) * scale;
+      float x1 = x0 + std::max<float>(event.duration_ns * scale, 1.0f);
+      x0 = std::max(x0, left);
+      x1 = std::min(x1, right);
+      if (x1 < x0) {
+        continue;
+      }
+      ImVec2 min(x0, origin.y + depths[i] * bar_height);
+      ImVec2 max(x1, min.y + bar_height - 1.0f);
+      draw_list->AddRectFilled(min, max, event_color(event.name));
+      if (x1 - x0 > ImGui::CalcTextSize(event.name).x + 4.0f) {
+        draw_list->AddText(ImVec2(x0 + 2.0f, min.y + 2.0f),
+                           IM_COL32(0, 0, 0, 255), event.name);
+      }
+      if (ImGui::IsMouseHoveringRect(min, max)) {
+        hovered = &event;
+      }
+    }
+    ImGui::Dummy(ImVec2(label_width + width, row_height));
+    ImGui::Separator();
+  }
+  if (hovered && ImGui::BeginTooltip()) {
+    ImGui::TextUnformatted(hovered->name);
+    if (!hovered->detail.empty()) {
+      ImGui::TextUnformatted(hovered->detail.c_str());
+    }
+    ImGui::Text("%.3fms", hovered->duration_ns / 1e6);
+    ImGui::EndTooltip();
+  }
+  ImGui::EndChild();
+
+  // where the time of the shown range went
+  std::vector<std::pair<std::string_view, Totals>> sorted(totals.begin(),
+                                                          totals.end());
+  std::sort(sorted.begin(), sorted.end(), [](auto &a, auto &b) {
+    return a.second.total_ns > b.second.total_ns;
+  });
+  if (ImGui::BeginTable("##trace_totals", 4,
+                        ImGuiTableFlags_ScrollY | ImGuiTableFlags_RowBg |
+                            ImGuiTableFlags_Borders)) {
+    ImGui::TableSetupScrollFreeze(0, 1);
+    ImGui::TableSetupColumn(gettext("Event"));
+    ImGui::TableSetupColumn(gettext("Count"));
+    ImGui::TableSetupColumn(gettext("Total"));
+    ImGui::TableSetupColumn(gettext("Max"));
+    ImGui::TableHeadersRow();
+    for (auto &[name, total] : sorted) {
+      ImGui::TableNextRow();
+      ImGui::TableNextColumn();
+      ImGui::TextUnformatted(name.data(), name.data() + name.size());
+      ImGui::TableNextColumn();
+      ImGui::Text("%zu", total.count);
+      ImGui::TableNextColumn();
+      ImGui::Text("%.3fms", total.total_ns / 1e6);
+      ImGui::TableNextColumn();
+      ImGui::Text("%.3fms", total.max_ns / 1e6);
+    }
+    ImGui::EndTable();
+  }
+  ImGui::End();
+}
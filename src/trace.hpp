@@ -0,0 +1,105 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <filesystem>
+namespace fs = std::filesystem;
+
+namespace wgrd_files {
+
+// events kept per thread, older ones get overwritten
+constexpr size_t trace_buffer_size = 1 << 14;
+
+struct TraceEvent {
+  // a string literal
+  const char *name = nullptr;
+  // e.g. the vfs path of the file
+  std::string detail;
+  // nanoseconds since the program started
+  int64_t start_ns = 0;
+  int64_t duration_ns = 0;
+};
+
+struct TraceThread {
+  uint32_t id = 0;
+  std::string name;
+  // sorted by start
+  std::vector<TraceEvent> events;
+};
+
+/*
+ * Records timed events into a ring buffer per thread.
+ *
+ * While tracing is disabled recording costs a single relaxed load. The
+ * buffers only take a lock that the collecting thread competes for, so
+ * the workers don't contend with each other. Each thread keeps its last
+ * trace_buffer_size events.
+ * */
+class Tracer {
+private:
+  static inline std::atomic_bool s_enabled = false;
+
+public:
+  static bool is_enabled() {
+    return s_enabled.load(std::memory_order_relaxed);
+  }
+  static void set_enabled(bool enabled);
+  static int64_t now_ns();
+  // shown in the timeline and the exported trace
+  static void set_thread_name(std::string name);
+  static void record(const char *name, std::string detail, int64_t start_ns,
+                     int64_t end_ns);
+  static void clear();
+  // the events of every thread that ended after since_ns
+  static std::vector<TraceThread> collect(int64_t since_ns = 0);
+  // writes all events in the chrome trace event format, which can be opened
+  // in chrome://tracing or perfetto
+  static bool export_chrome_trace(const fs::path &path);
+};
+
+// records the time between its construction and destruction
+class ScopedTrace {
+private:
+  // nullptr if tracing was disabled on construction
+  const char *m_name = nullptr;
+  std::string m_detail;
+  int64_t m_start_ns = 0;
+
+public:
+  explicit ScopedTrace(const char *name, std::string_view detail = {}) {
+    if (Tracer::is_enabled()) {
+      m_name = name;
+      m_detail = detail;
+      m_start_ns = Tracer::now_ns();
+    }
+  }
+  ~ScopedTrace() {
+    if (m_name) {
+      Tracer::record(m_name, std::move(m_detail), m_start_ns,
+                     Tracer::now_ns());
+    }
+  }
+  ScopedTrace(const ScopedTrace &) = delete;
+  ScopedTrace &operator=(const ScopedTrace &) = delete;
+};
+
+// timeline of the recorded events, one row per thread
+class TraceWindow {
+private:
+  float m_range_s = 10.0f;
+  // while following, the timeline ends at the current time
+  bool m_follow = true;
+  int64_t m_end_ns = 0;
+  std::string m_export_path = "trace.json";
+
+public:
+  bool open = false;
+  void render();
+};
+
+} // namespace wgrd_files
@@ -0,0 +1,255 @@
+#include "vfs_cache.hpp"
+
+#include "edat_reader.hpp"
+#include "mapped_file.hpp"
+
+#include "spdlog/spdlog.h"
+
+#include <cstring>
+#include <format>
+#include <fstream>
+#include <random>
+#include <zlib.h>
+
+using namespace wgrd_files;
+
+namespace {
+
+constexpr char cache_magic[4] = {'W', 'V', 'F', 'S'};
+// increment when changing the layout
+constexpr uint32_t cache_version = 1;
+// magic and version, the crc32 of everything after them is appended
+constexpr size_t cache_header_size = 4 + 4;
+constexpr size_t cache_crc_size = 4;
+
+class CacheWriter {
+private:
+  std::ofstream &m_stream;
+  uLong m_crc = crc32(0L, nullptr, 0);
+
+  void write_bytes(const char *data, size_t size) {
+    m_stream.write(data, size);
+    m_crc = crc32(m_crc, reinterpret_cast<const Bytef *>(data), size);
+  }
+
+public:
+  explicit CacheWriter(std::ofstream &stream) : m_stream(stream) {}
+  template <typename T> void write(T value) {
+    write_bytes(reinterpret_cast<const char *>(&value), sizeof(T));
+  }
+  void write_string(std::string_view str) {
+    write<uint32_t>(str.size());
+    write_bytes(str.data(), str.size());
+  }
+  // the crc32 of everything written so far
+  uint32_t get_crc() const { return m_crc; }
+};
+
+class CacheReader {
+private:
+  const char *m_pos;
+  const char *m_end;
+
+public:
+  bool failed = false;
+  CacheReader(const char *data, size_t size)
+      : m_pos(data), m_end(data + size) {}
+  template <typename T> T read() {
+    T ret{};
+    if (failed || m_end - m_pos < (ptrdiff_t)sizeof(T)) {
+      failed = true;
+      return ret;
+    }
+    std::memcpy(&ret, m_pos, sizeof(T));
+    m_pos += sizeof(T);
+    return ret;
+  }
+  std::string_view read_string() {
+    uint32_t size = read<uint32_t>();
+    if (failed || m_end - m_pos < (ptrdiff_t)size) {
+      failed = true;
+      return {};
+    }
+    std::string_view ret(m_pos, size);
+    m_pos += size;
+    return ret;
+  }
+};
+
+} // namespace
+
+std::optional<VfsCacheDat> VfsCacheDat::from_path(const fs::path &path) {
+  std::error_code ec;
+  VfsCacheDat ret;
+  ret.path = path.string();
+  ret.size = fs::file_size(path, ec);
+  if (ec) {
+    return std::nullopt;
+  }
+  ret.mtime = fs::last_write_time(path, ec).time_since_epoch().count();
+  if (ec) {
+    return std::nullopt;
+  }
+  std::ifstream stream(path, std::ios::in | std::ios::binary);
+  char header[edat_header::size] = {};
+  stream.read(header, sizeof(header));
+  ret.header_hash = fnv1a_hash(std::string_view(header, stream.gcount()));
+  return ret;
+}
+
+fs::path VfsCache::get_cache_path(const fs::path &cache_dir,
+                                  const fs::path &root) {
+  return cache_dir /
+         std::format("vfs_{:016x}.cache", fnv1a_hash(root.string()));
+}
+
+bool VfsCache::save(const fs::path &path) const {
+  std::error_code ec;
+  fs::create_directories(path.parent_path(), ec);
+  // write to a temporary file first, so a crash never leaves a broken cache.
+  // the name is unique per writer, other workspaces or processes with the
+  // same db_path and root may save the same cache at the same time.
+  std::random_device rd;
+  fs::path tmp_path = path;
+  tmp_path += std::format(".{:08x}{:08x}.tmp", rd(), rd());
+  {
+    std::ofstream stream(tmp_path,
+                         std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!stream.is_open()) {
+      spdlog::warn("Failed to open vfs cache {}", tmp_path.string());
+      return false;
+    }
+    stream.write(cache_magic, sizeof(cache_magic));
+    stream.write(reinterpret_cast<const char *>(&cache_version),
+                 sizeof(cache_version));
+    CacheWriter writer(stream);
+
+    writer.write<uint32_t>(dats.size());
+    for (auto &dat : dats) {
+      writer.write_string(dat.path);
+      writer.write<uint64_t>(dat.size);
+      writer.write<int64_t>(dat.mtime);
+      writer.write<uint64_t>(dat.header_hash);
+    }
+
+    writer.write<uint32_t>(strings.size());
+    for (auto &str : strings) {
+      writer.write_string(str);
+    }
+
+    writer.write<uint32_t>(entries.size());
+    for (auto &entry : entries) {
+      writer.write<uint32_t>(entry.parts.size());
+      for (uint32_t part : entry.parts) {
+        writer.write<uint32_t>(part);
+      }
+      writer.write<uint32_t>(entry.metas.size());
+      for (auto &meta : entry.metas) {
+        writer.write<uint32_t>(meta.dat_idx);
+        writer.write<uint64_t>(meta.offset);
+        writer.write<uint64_t>(meta.size);
+        writer.write<uint8_t>((uint8_t)meta.type);
+      }
+    }
+    uint32_t crc = writer.get_crc();
+    stream.write(reinterpret_cast<const char *>(&crc), sizeof(crc));
+    if (!stream.good()) {
+      spdlog::warn("Failed to write vfs cache {}", tmp_path.string());
+      stream.close();
+      fs::remove(tmp_path, ec);
+      return false;
+    }
+  }
+  fs::rename(tmp_path, path, ec);
+  if (ec) {
+    spdlog::warn("Failed to move vfs cache to {}: {}", path.string(),
+                 ec.message());
+    fs::remove(tmp_path, ec);
+    return false;
+  }
+  return true;
+}
+
+std::optional<VfsCache> VfsCache::load(const fs::path &path) {
+  if (!fs::exists(path)) {
+    return std::nullopt;
+  }
+  MappedFile file;
+  if (!file.open(path)) {
+    return std::nullopt;
+  }
+  uint32_t version = 0;
+  if (file.size() >= cache_header_size) {
+    std::memcpy(&version, file.data() + sizeof(cache_magic), sizeof(version));
+  }
+  if (file.size() < cache_header_size + cache_crc_size ||
+      std::memcmp(file.data(), cache_magic, sizeof(cache_magic)) ||
+      version != cache_version) {
+    spdlog::info("vfs cache {} has an old format, ignoring it", path.string());
+    return std::nullopt;
+  }
+  const char *body = file.data() + cache_header_size;
+  size_t body_size = file.size() - cache_header_size - cache_crc_size;
+  uint32_t crc;
+  std::memcpy(&crc, body + body_size, sizeof(crc));
+  if (crc32(crc32(0L, nullptr, 0), reinterpret_cast<const Bytef *>(body),
+            body_size) != crc) {
+    spdlog::warn("vfs cache {} is corrupt, ignoring it", path.string());
+    return std::nullopt;
+  }
+  CacheReader reader(body, body_size);
+
+  VfsCache ret;
+  // counts are only used as loop bounds, so a broken cache can not trigger
+  // huge allocations
+  uint32_t dat_count = reader.read<uint32_t>();
+  for (uint32_t i = 0; i < dat_count && !reader.failed; i++) {
+    VfsCacheDat dat;
+    dat.path = reader.read_string();
+    dat.size = reader.read<uint64_t>();
+    dat.mtime = reader.read<int64_t>();
+    dat.header_hash = reader.read<uint64_t>();
+    ret.dats.push_back(std::move(dat));
+  }
+
+  uint32_t string_count = reader.read<uint32_t>();
+  for (uint32_t i = 0; i < string_count && !reader.failed; i++) {
+    ret.strings.emplace_back(reader.read_string());
+  }
+
+  uint32_t entry_count = reader.read<uint32_t>();
+  for (uint32_t i = 0; i < entry_count && !reader.failed; i++) {
+    VfsCacheEntry entry;
+    uint32_t part_count = reader.read<uint32_t>();
+    for (uint32_t j = 0; j < part_count && !reader.failed; j++) {
+      uint32_t part = reader.read<uint32_t>();
+      if (part >= ret.strings.size()) {
+        reader.failed = true;
+        break;
+      }
+      entry.parts.push_back(part);
+    }
+    uint32_t meta_count = reader.read<uint32_t>();
+    for (uint32_t j = 0; j < meta_count && !reader.failed; j++) {
+      VfsCacheMeta meta;
+      meta.dat_idx = reader.read<uint32_t>();
+      meta.offset = reader.read<uint64_t>();
+      meta.size = reader.read<uint64_t>();
+      uint8_t type = reader.read<uint8_t>();
+      if (meta.dat_idx >= ret.dats.size() ||
+          type > (uint8_t)FileType::UNKNOWN) {
+        reader.failed = true;
+        break;
+      }
+      meta.type = (FileType)type;
+      entry.metas.push_back(meta);
+    }
+    ret.entries.push_back(std::move(entry));
+  }
+
+  if (reader.failed) {
+    spdlog::warn("vfs cache {} is inconsistent, ignoring it", path.string());
+    return std::nullopt;
+  }
+  return ret;
+}
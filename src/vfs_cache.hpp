@@ -0,0 +1,72 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include <filesystem>
+namespace fs = std::filesystem;
+
+#include "files/configs.hpp"
+
+namespace wgrd_files {
+
+// stable 64 bit FNV-1a hash, used for cache keys written to disk
+inline uint64_t fnv1a_hash(std::string_view data,
+                           uint64_t hash = 0xcbf29ce484222325ULL) {
+  for (unsigned char c : data) {
+    hash ^= c;
+    hash *= 0x100000001b3ULL;
+  }
+  return hash;
+}
+
+// identifies the state of a dat file, if any of these change the cache is
+// invalid
+struct VfsCacheDat {
+  std::string path;
+  uint64_t size = 0;
+  int64_t mtime = 0;
+  // hash of the edat header, which contains the dictionary checksum
+  uint64_t header_hash = 0;
+
+  bool operator==(const VfsCacheDat &other) const = default;
+  static std::optional<VfsCacheDat> from_path(const fs::path &path);
+};
+
+struct VfsCacheMeta {
+  // index into VfsCache::dats
+  uint32_t dat_idx;
+  uint64_t offset;
+  uint64_t size;
+  FileType type;
+};
+
+struct VfsCacheEntry {
+  // indices into VfsCache::strings, joined by '/' these are the vfs path
+  std::vector<uint32_t> parts;
+  std::vector<VfsCacheMeta> metas;
+};
+
+/*
+ * Binary cache of the parsed dat dictionaries of one FileTree root.
+ *
+ * Stored in the db_path of the workspace with a crc32 of its content and
+ * validated against the size, mtime and header of every dat file, so
+ * reopening a workspace does not need to walk the dictionaries again.
+ * */
+struct VfsCache {
+  std::vector<VfsCacheDat> dats;
+  std::vector<std::string> strings;
+  std::vector<VfsCacheEntry> entries;
+
+  bool save(const fs::path &path) const;
+  static std::optional<VfsCache> load(const fs::path &path);
+  // returns the cache file for the given root inside the cache directory
+  static fs::path get_cache_path(const fs::path &cache_dir,
+                                 const fs::path &root);
+};
+
+} // namespace wgrd_files
@@ -106,6 +106,8 @@ bool Workspace::init(fs::path fs_path, fs::path out_path) {
 }
 
 bool Workspace::init(const WorkspaceConfig &config) {
+  m_config.undo_history_entries = config.undo_history_entries;
+  m_config.undo_history_bytes = config.undo_history_bytes;
   return init(config.fs_path, config.dat_path, config.bin_path, config.xml_path,
               config.db_path, config.tmp_path);
 }
@@ -121,15 +123,17 @@ bool Workspace::init(fs::path fs_path, fs::path dat_path, fs::path bin_path,
   m_parsed_promise = std::promise<bool>();
   m_parsed_future = m_parsed_promise->get_future();
 
-  ThreadPoolSingleton::get_instance().submit([this, dat_path]() {
-    try {
-      file_tree.init_from_dat_path(dat_path);
-      m_parsed_promise->set_value(true);
-    } catch (const std::exception &e) {
-      spdlog::error("Failed to parse workspace: {}", e.what());
-      m_parsed_promise->set_value(false);
-    }
-  });
+  file_tree.set_cache_dir(db_path);
+  ThreadPoolSingleton::get_instance().submit(
+      TaskPriority::VISIBLE, [this, dat_path]() {
+        try {
+          file_tree.init_from_dat_path(dat_path);
+          m_parsed_promise->set_value(true);
+        } catch (const std::exception &e) {
+          spdlog::error("Failed to parse workspace: {}", e.what());
+          m_parsed_promise->set_value(false);
+        }
+      });
 
   m_config.name = workspace_name;
   assert(!workspace_name.empty());
@@ -160,26 +164,73 @@ bool Workspace::init_from_file(fs::path file_path, fs::path dat_path,
   m_parsed_promise = std::promise<bool>();
   m_parsed_future = m_parsed_promise->get_future();
 
-  ThreadPoolSingleton::get_instance().submit([this, file_path]() {
-    try {
-      bool ret = file_tree.init_from_path(file_path);
-      m_parsed_promise->set_value(ret);
-    } catch (const std::exception &e) {
-      spdlog::error("Failed to parse workspace: {}", e.what());
-      m_parsed_promise->set_value(false);
-    }
-  });
+  file_tree.set_cache_dir(db_path);
+  ThreadPoolSingleton::get_instance().submit(
+      TaskPriority::VISIBLE, [this, file_path]() {
+        try {
+          bool ret = file_tree.init_from_path(file_path);
+          m_parsed_promise->set_value(ret);
+        } catch (const std::exception &e) {
+          spdlog::error("Failed to parse workspace: {}", e.what());
+          m_parsed_promise->set_value(false);
+        }
+      });
   return true;
 }
 
+Workspace::~Workspace() {
+  // the bulk load parses files of this workspace on the pool
+  if (m_bulk_load) {
+    m_bulk_load->cancel();
+  }
+}
+
+std::shared_future<bool> Workspace::load_all_files(FileType type,
+                                                   size_t max_concurrency) {
+  if (m_bulk_load && !m_bulk_load->is_done()) {
+    spdlog::warn("Workspace {} is already loading files", workspace_name);
+    return m_bulk_load->get_future();
+  }
+  std::vector<File *> queued;
+  for (auto &metas : file_tree.get_files_of_type(type)) {
+    File *file = files.add_file(std::move(metas), false);
+    if (!file) {
+      continue;
+    }
+    // files that were opened or loaded before are parsed or still parsing
+    file->check_parsing();
+    if (file->is_parsed() || file->is_parsing()) {
+      continue;
+    }
+    if (file->prepare_parsing()) {
+      queued.push_back(file);
+    }
+  }
+  m_bulk_load = std::make_shared<BulkLoad>(queued);
+  return m_bulk_load->start(max_concurrency);
+}
+
+std::optional<std::shared_future<bool>>
+Workspace::get_load_all_future() const {
+  if (!m_bulk_load) {
+    return std::nullopt;
+  }
+  return m_bulk_load->get_future();
+}
+
 void Workspace::render_window() {
-  // static bool test = false;
-  // if (!test) {
-  //   for (auto &metas : file_tree.get_all_files()) {
-  //     files.add_file(std::move(metas));
-  //   }
-  //   test = true;
-  // }
+  bool loading = m_bulk_load && !m_bulk_load->is_done();
+  ImGui::BeginDisabled(loading);
+  if (ImGui::Button(gettext("Load all NDF files"))) {
+    load_all_files();
+  }
+  ImGui::EndDisabled();
+  if (m_bulk_load) {
+    m_bulk_load->render();
+  }
+  if (auto &save_job = files.get_save_job()) {
+    save_job->render();
+  }
   auto file_metas = file_tree.render();
   if (file_metas) {
     if (!file_metas->size()) {
@@ -194,10 +245,29 @@ void Workspace::render_window() {
 
 void Workspace::render_extra() { files.render(); }
 
-void Workspace::save_changes_to_dat(bool save_to_fs_path) {
-  files.save_changes_to_dat(save_to_fs_path);
+size_t Workspace::import_xml_edits(FileType type) {
+  size_t ret = 0;
+  for (auto &vfs_path : files.get_files_of_type(type)) {
+    File *file = files.get_file(vfs_path);
+    file->check_parsing();
+    if (!file->is_parsed() || !fs::exists(file->get_xml_path())) {
+      continue;
+    }
+    if (file->import_xml()) {
+      ret++;
+    } else {
+      spdlog::error("Could not import {}", file->get_xml_path().string());
+    }
+  }
+  return ret;
+}
+
+std::shared_future<bool> Workspace::save_changes_to_dat(bool save_to_fs_path) {
+  return files.save_changes_to_dat(save_to_fs_path);
 }
 
+bool Workspace::is_saving() const { return files.is_saving(); }
+
 bool Workspace::is_changed() { return files.is_changed(); }
 
 void Workspace::check_parsing() {
@@ -226,11 +296,20 @@ void Workspace::check_parsing() {
   }
 }
 
+bool Workspace::wait_until_parsed() {
+  if (m_is_parsing && m_parsed_future) {
+    m_parsed_future->wait();
+  }
+  check_parsing();
+  return m_is_parsed;
+}
+
 bool Workspace::is_parsed() { return m_is_parsed; }
 
 bool Workspace::is_parsing() { return m_is_parsing; }
 
 void Workspaces::render() {
+  check_saves();
   for (auto &[workspace_name, p_open] : open_workspace_windows) {
     if (!p_open) {
       continue;
@@ -327,10 +406,59 @@ void Workspaces::load_project_file(fs::path path) {
 }
 
 void Workspaces::save_workspaces(bool save_to_fs_path) {
-  for (auto &[_, workspace] : workspaces) {
-    if (!workspace->is_parsed() || workspace->is_parsing()) {
+  m_save_failed = false;
+  for (auto &[name, workspace] : workspaces) {
+    if (!workspace->is_parsed() || workspace->is_parsing() ||
+        workspace->is_saving()) {
       continue;
     }
-    workspace->save_changes_to_dat(save_to_fs_path);
+    m_saves[name] = workspace->save_changes_to_dat(save_to_fs_path);
+  }
+}
+
+void Workspaces::check_saves() {
+  if (m_saves.empty()) {
+    return;
+  }
+  for (auto &[_, future] : m_saves) {
+    if (future.wait_for(std::chrono::seconds(0)) !=
+        std::future_status::ready) {
+      return;
+    }
   }
+  m_save_failed = !wait_for_saves();
+  if (!m_save_failed) {
+    spdlog::info("Saved all workspaces");
+  }
+}
+
+void Workspaces::render_saves_popup() {
+  const char *title = gettext("Saving workspaces");
+  if (!ImGui::IsPopupOpen(title)) {
+    ImGui::OpenPopup(title);
+  }
+  if (!ImGui::BeginPopupModal(title, nullptr,
+                              ImGuiWindowFlags_AlwaysAutoResize)) {
+    return;
+  }
+  ImGui::TextUnformatted(gettext("Exiting once all workspaces are saved..."));
+  for (auto &[name, _] : m_saves) {
+    ImGui::SeparatorText(name.c_str());
+    if (auto &save_job = workspaces[name]->files.get_save_job()) {
+      save_job->render();
+    }
+  }
+  ImGui::EndPopup();
+}
+
+bool Workspaces::wait_for_saves() {
+  bool ret = true;
+  for (auto &[name, future] : m_saves) {
+    if (!future.get()) {
+      spdlog::error("Failed to save workspace {}", name);
+      ret = false;
+    }
+  }
+  m_saves.clear();
+  return ret;
 }
@@ -1,12 +1,15 @@
 #pragma once
 
 #include "file_tree.hpp"
+#include "files/bulk_load.hpp"
 #include "files/file.hpp"
 #include "files/files.hpp"
 
 #include "helpers.hpp"
 #include "toml.hpp"
 
+#include <thread>
+
 using namespace wgrd_files;
 
 class Workspaces;
@@ -25,6 +28,8 @@ private:
 
   WorkspaceConfig m_config;
 
+  std::shared_ptr<BulkLoad> m_bulk_load;
+
   friend class Workspaces;
   // checks and creates directories
   bool check_directories(fs::path fs_path, fs::path dat_path, fs::path bin_path,
@@ -33,6 +38,7 @@ private:
 
 public:
   explicit Workspace() : files(m_config) {}
+  ~Workspace();
   std::string workspace_name;
   static std::optional<std::unique_ptr<Workspace>>
   render_init_workspace(bool *show_workspace);
@@ -44,13 +50,27 @@ public:
   bool init_from_file(const WorkspaceConfig &config);
   bool init_from_file(fs::path file_path, fs::path dat_path, fs::path bin_path,
                       fs::path xml_path, fs::path db_path, fs::path tmp_path);
+  // parses all files of the given type in the background, at most
+  // max_concurrency at the same time. The future is true once all of them
+  // are parsed successfully.
+  std::shared_future<bool>
+  load_all_files(FileType type = FileType::NDFBIN,
+                 size_t max_concurrency = std::thread::hardware_concurrency());
+  // returns the future of the last load_all_files call
+  std::optional<std::shared_future<bool>> get_load_all_future() const;
   void render_window();
   void render_extra();
+  // loads the saved xml edits of all parsed files of the given type that
+  // have one, returns how many were imported
+  size_t import_xml_edits(FileType type = FileType::NDFBIN);
   // argument determines whether to save to the given dat_path or to save to the
-  // input folder
-  void save_changes_to_dat(bool save_to_fs_path);
+  // input folder. Saves in the background, the future is true on success.
+  std::shared_future<bool> save_changes_to_dat(bool save_to_fs_path);
+  bool is_saving() const;
   bool is_changed();
   void check_parsing();
+  // blocks until the file tree is parsed, returns is_parsed()
+  bool wait_until_parsed();
   bool is_parsed();
   bool is_parsing();
 };
@@ -61,12 +81,32 @@ private:
 
   std::unordered_map<std::string, bool> open_workspace_windows;
 
+  // workspace name -> running save
+  std::unordered_map<std::string, std::shared_future<bool>> m_saves;
+  // set if a save failed, until the next save starts
+  bool m_save_failed = false;
+  // reports the result once all running saves are done
+  void check_saves();
+
 public:
   bool show_add_workspace = false;
   void render();
   void render_menu();
   void add_workspace(std::unique_ptr<Workspace> workspace);
+  const std::unordered_map<std::string, std::unique_ptr<Workspace>> &
+  get_workspaces() const {
+    return workspaces;
+  }
+  // saves all workspaces in parallel in the background
   void save_workspaces(bool save_to_fs_path = false);
+  bool is_saving() const { return !m_saves.empty(); }
+  // true if any of the last finished saves failed
+  bool save_failed() const { return m_save_failed; }
+  // shows the progress of the running saves in a modal popup, e.g. while
+  // waiting for them to exit
+  void render_saves_popup();
+  // blocks until all running saves are done, false if any of them failed
+  bool wait_for_saves();
   void save_project_file(fs::path path);
   void load_project_file(fs::path path);
 };
@@ -0,0 +1,980 @@
+#include <algorithm>
+#include <chrono>
+#include <format>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <numeric>
+#include <sstream>
+#include <thread>
+#include <unistd.h>
+
+#include <argparse/argparse.hpp>
+#include <magic_enum.hpp>
+
+#include "spdlog/sinks/stdout_color_sinks.h"
+#include "spdlog/spdlog.h"
+
+#include "edat_generator.hpp"
+#include "edat_reader.hpp"
+#include "edat_writer.hpp"
+#include "files/file.hpp"
+#include "files/file_type.hpp"
+#include "ndf_generator.hpp"
+#include "ndftransactions.hpp"
+#include "object_digests.hpp"
+#include "object_search.hpp"
+#include "threadpool.hpp"
+#include "trace.hpp"
+
+/*
+ * Measures the hot paths of ndfbins on generated object graphs and of the
+ * dat files on a generated edat file.
+ *
+ * Every benchmark prints one json object per line to stdout with the same
+ * keys in the same order, so results of different versions can be compared
+ * by a script. Times are in nanoseconds per iteration, the rates are based
+ * on the median. Logs go to stderr.
+ * */
+
+using namespace wgrd_files;
+
+namespace {
+
+const std::string bench_vfs_path = "$/Bench/Generated.ndfbin";
+
+struct Options {
+  NdfGeneratorConfig generator;
+  EDatGeneratorConfig edat;
+  size_t iterations = 10;
+  // transactions applied and undone per iteration
+  size_t transactions = 1000;
+  // only benchmarks whose name contains it run
+  std::string filter;
+};
+
+typedef std::chrono::steady_clock Clock;
+
+int64_t elapsed_ns(Clock::time_point start) {
+  return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() -
+                                                              start)
+      .count();
+}
+
+class Runner {
+private:
+  const Options &m_options;
+  bool m_failed = false;
+
+public:
+  explicit Runner(const Options &options) : m_options(options) {}
+  const Options &get_options() const { return m_options; }
+  bool is_enabled(std::string_view name) const {
+    return name.contains(m_options.filter);
+  }
+  // marks the run as failed, the results are still printed
+  void fail(std::string_view name, std::string_view reason) {
+    spdlog::error("{} failed: {}", name, reason);
+    m_failed = true;
+  }
+  bool failed() const { return m_failed; }
+
+  // times body, setup runs before every iteration and isn't timed
+  std::vector<int64_t> measure(const std::function<void()> &body,
+                               const std::function<void()> &setup = {}) {
+    std::vector<int64_t> ret;
+    for (size_t i = 0; i < m_options.iterations; i++) {
+      if (setup) {
+        setup();
+      }
+      auto start = Clock::now();
+      body();
+      ret.push_back(elapsed_ns(start));
+    }
+    return ret;
+  }
+
+  // items and bytes are processed per iteration, bytes may be 0
+  void report(std::string_view name, size_t items, size_t bytes,
+              std::vector<int64_t> durations) {
+    if (durations.empty()) {
+      return;
+    }
+    std::sort(durations.begin(), durations.end());
+    int64_t median = durations[durations.size() / 2];
+    int64_t mean = std::accumulate(durations.begin(), durations.end(),
+                                   int64_t(0)) /
+                   static_cast<int64_t>(durations.size());
+    double seconds = std::max<int64_t>(median, 1) / 1e9;
+    std::cout << std::format(
+        "{{\"benchmark\":\"{}\",\"objects\":{},\"entries\":{},"
+        "\"iterations\":{},\"items\":{},\"bytes\":{},\"min_ns\":{},"
+        "\"median_ns\":{},\"mean_ns\":{},\"max_ns\":{},"
+        "\"items_per_s\":{:.1f},\"bytes_per_s\":{:.1f}}}\n",
+        name, m_options.generator.object_count, m_options.edat.entry_count,
+        durations.size(), items, bytes, durations.front(), median, mean,
+        durations.back(), items / seconds, bytes / seconds);
+    std::cout.flush();
+  }
+
+  void run(std::string_view name, size_t items, size_t bytes,
+           const std::function<void()> &body,
+           const std::function<void()> &setup = {}) {
+    if (is_enabled(name)) {
+      report(name, items, bytes, measure(body, setup));
+    }
+  }
+};
+
+WorkspaceConfig make_workspace_config(const fs::path &dir) {
+  WorkspaceConfig config;
+  config.name = "benchmarks";
+  config.fs_path = dir;
+  config.dat_path = dir / "dat";
+  config.bin_path = dir / "bin";
+  config.xml_path = dir / "xml";
+  config.db_path = dir / "db";
+  config.tmp_path = dir / "tmp";
+  fs::create_directories(config.db_path);
+  return config;
+}
+
+void bench_load_and_save(Runner &runner, std::span<const char> data) {
+  size_t objects = runner.get_options().generator.object_count;
+  NdfBinFile ndfbin;
+  runner.run("ndfbin/load", objects, data.size(),
+             [&]() { ndfbin.start_parsing(bench_vfs_path, data); });
+  if (!runner.is_enabled("ndfbin/save")) {
+    return;
+  }
+  if (ndfbin.get_object_count() != objects) {
+    ndfbin.start_parsing(bench_vfs_path, data);
+  }
+  size_t bytes = 0;
+  auto durations = runner.measure([&]() {
+    std::stringstream stream;
+    if (!ndfbin.save_ndfbin_to_stream(stream)) {
+      runner.fail("ndfbin/save", "save_ndfbin_to_stream returned false");
+    }
+    bytes = stream.view().size();
+  });
+  runner.report("ndfbin/save", objects, bytes, durations);
+}
+
+// parses a ndfbin of a workspace the way opening it does. The time of the
+// stages is taken from the trace, fill_class_list and reload_db are only
+// reachable through the file.
+void bench_parse(Runner &runner, const fs::path &dir,
+                 const fs::path &ndfbin_path) {
+  const std::vector<std::pair<const char *, std::string>> stages = {
+      {"decompress", "ndfbin/parse/decompress"},
+      {"parse ndf", "ndfbin/parse/parse_ndf"},
+      {"fill_class_list", "ndfbin/parse/fill_class_list"},
+      {"reload_db", "ndfbin/parse/reload_db"},
+      {"save_snapshot", "ndfbin/parse/save_snapshot"},
+  };
+  if (!runner.is_enabled("ndfbin/parse") &&
+      std::ranges::none_of(stages, [&](auto &stage) {
+        return runner.is_enabled(stage.second);
+      })) {
+    return;
+  }
+
+  WorkspaceConfig config = make_workspace_config(dir);
+  Files files(config);
+  size_t size = fs::file_size(ndfbin_path);
+  File *file = files.add_file(
+      {FileMeta{bench_vfs_path, ndfbin_path, 0, size, 0, FileType::NDFBIN}},
+      false);
+
+  Tracer::clear();
+  Tracer::set_enabled(true);
+  int64_t start_ns = Tracer::now_ns();
+  auto durations = runner.measure([&]() {
+    if (!file->prepare_parsing() || !file->parse(false)) {
+      runner.fail("ndfbin/parse", "parsing the generated ndfbin failed");
+    }
+    file->check_parsing();
+  });
+  Tracer::set_enabled(false);
+
+  size_t objects = runner.get_options().generator.object_count;
+  if (runner.is_enabled("ndfbin/parse")) {
+    runner.report("ndfbin/parse", objects, size, durations);
+  }
+  auto threads = Tracer::collect(start_ns);
+  for (auto &[event_name, name] : stages) {
+    if (!runner.is_enabled(name)) {
+      continue;
+    }
+    std::vector<int64_t> stage_durations;
+    for (auto &thread : threads) {
+      for (auto &event : thread.events) {
+        if (std::string_view(event.name) == event_name) {
+          stage_durations.push_back(event.duration_ns);
+        }
+      }
+    }
+    runner.report(name, objects, 0, std::move(stage_durations));
+  }
+  Tracer::clear();
+}
+
+// the lower case filters, like the ndfbin passes them
+void bench_search(Runner &runner) {
+  const auto &generator = runner.get_options().generator;
+  SymbolTable symbols;
+  std::vector<std::pair<Symbol, Symbol>> objects;
+  objects.reserve(generator.object_count);
+  for (size_t i = 0; i < generator.object_count; i++) {
+    objects.emplace_back(
+        symbols.intern(generated_object_name(i)),
+        symbols.intern(
+            generated_class_name(generated_class_idx(generator, i))));
+  }
+  auto search = std::make_shared<ObjectSearch>();
+  auto fill = [&]() {
+    for (auto [object_name, class_name] : objects) {
+      search->add_object(object_name, symbols.str(object_name), class_name,
+                         symbols.str(class_name));
+    }
+  };
+  runner.run("search/index", objects.size(), 0, fill,
+             [&]() { search->clear(); });
+  search->clear();
+  fill();
+
+  const std::vector<std::tuple<const char *, std::string, std::string>>
+      queries = {
+          {"search/object", "unit_00001", ""},
+          {"search/class", "", "descriptor01"},
+          {"search/object_and_class", "unit_0000", "descriptor01"},
+          {"search/all", "", ""},
+      };
+  for (auto &[name, object_filter, class_filter] : queries) {
+    runner.run(name, objects.size(), 0, [&]() {
+      search->start_query(object_filter, class_filter);
+      std::optional<std::vector<Symbol>> result;
+      while (!(result = search->take_result())) {
+        std::this_thread::yield();
+      }
+    });
+  }
+}
+
+template <typename T>
+std::unique_ptr<T> make_change(const std::string &object_name,
+                               const char *property_name) {
+  auto ret = std::make_unique<T>();
+  ret->object_name = object_name;
+  ret->property_name = property_name;
+  return ret;
+}
+
+// a transaction of the type on the object, nullptr for types that need more
+// than one object
+std::unique_ptr<NdfTransaction>
+make_transaction(NdfTransactionType type, const std::string &object_name,
+                 const std::string &other_name, size_t seed) {
+  namespace prop = generated_property;
+  float f = static_cast<float>(seed % 1000) / 10.0f;
+  int32_t i = static_cast<int32_t>(seed % 1000);
+  switch (type) {
+  case NdfTransactionType::AddObject: {
+    auto ret = std::make_unique<NdfTransactionAddObject>();
+    ret->object_name = object_name;
+    return ret;
+  }
+  case NdfTransactionType::RemoveObject: {
+    auto ret = std::make_unique<NdfTransactionRemoveObject>();
+    ret->object_name = object_name;
+    return ret;
+  }
+  case NdfTransactionType::CopyObject: {
+    auto ret = std::make_unique<NdfTransactionCopyObject>();
+    ret->object_name = object_name;
+    ret->new_object_name = object_name + "_Copy";
+    return ret;
+  }
+  case NdfTransactionType::ChangeObjectName: {
+    auto ret = std::make_unique<NdfTransactionChangeObjectName>();
+    ret->object_name = object_name;
+    ret->name = object_name + "_Renamed";
+    return ret;
+  }
+  case NdfTransactionType::ChangeObjectExportPath: {
+    auto ret = std::make_unique<NdfTransactionChangeObjectExportPath>();
+    ret->object_name = object_name;
+    ret->export_path = "$/Changed/" + object_name;
+    return ret;
+  }
+  case NdfTransactionType::ChangeObjectTopObject: {
+    auto ret = std::make_unique<NdfTransactionChangeObjectTopObject>();
+    ret->object_name = object_name;
+    ret->top_object = seed % 2;
+    return ret;
+  }
+  case NdfTransactionType::BulkRename:
+  case NdfTransactionType::CoalescedSet:
+    return nullptr;
+  case NdfTransactionType::ChangeProperty_Bool: {
+    auto ret =
+        make_change<NdfTransactionChangeProperty_Bool>(object_name, prop::Bool);
+    ret->value = seed % 2;
+    return ret;
+  }
+  case NdfTransactionType::ChangeProperty_UInt8: {
+    auto ret = make_change<NdfTransactionChangeProperty_UInt8>(
+        object_name, prop::UInt8);
+    ret->value = i % 100;
+    return ret;
+  }
+  case NdfTransactionType::ChangeProperty_UInt16: {
+    auto ret = make_change<NdfTransactionChangeProperty_UInt16>(
+        object_name, prop::UInt16);
+    ret->value = i;
+    return ret;
+  }
+  case NdfTransactionType::ChangeProperty_Int16: {
+    auto ret = make_change<NdfTransactionChangeProperty_Int16>(
+        object_name, prop::Int16);
+    ret->value = -i;
+    return ret;
+  }
+  case NdfTransactionType::ChangeProperty_Int32: {
+    auto ret = make_change<NdfTransactionChangeProperty_Int32>(
+        object_name, prop::Int32);
+    ret->value = i;
+    return ret;
+  }
+  case NdfTransactionType::ChangeProperty_UInt32: {
+    auto ret = make_change<NdfTransactionChangeProperty_UInt32>(
+        object_name, prop::UInt32);
+    ret->value = i;
+    return ret;
+  }
+  case NdfTransactionType::ChangeProperty_Float32: {
+    auto ret = make_change<NdfTransactionChangeProperty_Float32>(
+        object_name, prop::Float32);
+    ret->value = f;
+    return ret;
+  }
+  case NdfTransactionType::ChangeProperty_Float64: {
+    auto ret = make_change<NdfTransactionChangeProperty_Float64>(
+        object_name, prop::Float64);
+    ret->value = f;
+    return ret;
+  }
+  case NdfTransactionType::ChangeProperty_String: {
+    auto ret = make_change<NdfTransactionChangeProperty_String>(
+        object_name, prop::String);
+    ret->value = std::format("'Changed_{}'", seed);
+    return ret;
+  }
+  case NdfTransactionType::ChangeProperty_WideString: {
+    auto ret = make_change<NdfTransactionChangeProperty_WideString>(
+        object_name, prop::WideString);
+    ret->value = std::format("Changed {}", seed);
+    return ret;
+  }
+  case NdfTransactionType::ChangeProperty_GUID: {
+    auto ret =
+        make_change<NdfTransactionChangeProperty_GUID>(object_name, prop::GUID);
+    ret->guid = std::format("{:032x}", seed);
+    return ret;
+  }
+  case NdfTransactionType::ChangeProperty_LocalisationHash: {
+    auto ret = make_change<NdfTransactionChangeProperty_LocalisationHash>(
+        object_name, prop::LocalisationHash);
+    ret->hash = std::format("{:016x}", seed);
+    return ret;
+  }
+  case NdfTransactionType::ChangeProperty_Hash: {
+    auto ret =
+        make_change<NdfTransactionChangeProperty_Hash>(object_name, prop::Hash);
+    ret->hash = std::format("{:024x}", seed);
+    return ret;
+  }
+  case NdfTransactionType::ChangeProperty_PathReference: {
+    auto ret = make_change<NdfTransactionChangeProperty_PathReference>(
+        object_name, prop::PathReference);
+    ret->path = std::format("GameData:/Changed/Model_{}.fbx", seed);
+    return ret;
+  }
+  case NdfTransactionType::ChangeProperty_ObjectReference: {
+    auto ret = make_change<NdfTransactionChangeProperty_ObjectReference>(
+        object_name, prop::ObjectReference);
+    ret->value = other_name;
+    return ret;
+  }
+  case NdfTransactionType::ChangeProperty_ImportReference: {
+    auto ret = make_change<NdfTransactionChangeProperty_ImportReference>(
+        object_name, prop::ImportReference);
+    ret->value = std::format("$/GFX/Changed/Import_{}", seed);
+    return ret;
+  }
+  case NdfTransactionType::ChangeProperty_F32_vec2: {
+    auto ret = make_change<NdfTransactionChangeProperty_F32_vec2>(
+        object_name, prop::F32_vec2);
+    ret->x = f;
+    ret->y = f;
+    return ret;
+  }
+  case NdfTransactionType::ChangeProperty_F32_vec3: {
+    auto ret = make_change<NdfTransactionChangeProperty_F32_vec3>(
+        object_name, prop::F32_vec3);
+    ret->x = f;
+    ret->y = f;
+    ret->z = f;
+    return ret;
+  }
+  case NdfTransactionType::ChangeProperty_F32_vec4: {
+    auto ret = make_change<NdfTransactionChangeProperty_F32_vec4>(
+        object_name, prop::F32_vec4);
+    ret->x = f;
+    ret->y = f;
+    ret->z = f;
+    ret->w = f;
+    return ret;
+  }
+  case NdfTransactionType::ChangeProperty_Color: {
+    auto ret = make_change<NdfTransactionChangeProperty_Color>(
+        object_name, prop::Color);
+    ret->r = i % 256;
+    ret->g = i % 256;
+    ret->b = i % 256;
+    ret->a = 255;
+    return ret;
+  }
+  case NdfTransactionType::ChangeProperty_S32_vec2: {
+    auto ret = make_change<NdfTransactionChangeProperty_S32_vec2>(
+        object_name, prop::S32_vec2);
+    ret->x = i;
+    ret->y = i;
+    return ret;
+  }
+  case NdfTransactionType::ChangeProperty_S32_vec3: {
+    auto ret = make_change<NdfTransactionChangeProperty_S32_vec3>(
+        object_name, prop::S32_vec3);
+    ret->x = i;
+    ret->y = i;
+    ret->z = i;
+    return ret;
+  }
+  case NdfTransactionType::ChangeProperty_AddListItem: {
+    auto ret = make_change<NdfTransactionChangeProperty_AddListItem>(
+        object_name, prop::List);
+    ret->index = 0;
+    auto value = std::make_unique<NDFPropertyObjectReference>();
+    value->property_name = "ListItem";
+    value->property_type = NDFPropertyType::ObjectReference;
+    value->object_name = other_name;
+    ret->value = std::move(value);
+    return ret;
+  }
+  case NdfTransactionType::ChangeProperty_RemoveListItem: {
+    auto ret = make_change<NdfTransactionChangeProperty_RemoveListItem>(
+        object_name, prop::List);
+    ret->index = 0;
+    return ret;
+  }
+  case NdfTransactionType::ChangeProperty_ChangeListItem: {
+    auto ret = make_change<NdfTransactionChangeProperty_ChangeListItem>(
+        object_name, prop::List);
+    ret->index = 0;
+    auto change =
+        std::make_unique<NdfTransactionChangeProperty_ObjectReference>();
+    change->value = other_name;
+    ret->change = std::move(change);
+    return ret;
+  }
+  case NdfTransactionType::ChangeProperty_AddMapItem: {
+    auto ret = make_change<NdfTransactionChangeProperty_AddMapItem>(
+        object_name, prop::Map);
+    ret->index = 0;
+    auto key = std::make_unique<NDFPropertyString>();
+    key->property_name = "Key";
+    key->property_type = NDFPropertyType::String;
+    key->value = std::format("'Added{}'", seed);
+    auto value = std::make_unique<NDFPropertyInt32>();
+    value->property_name = "Value";
+    value->property_type = NDFPropertyType::Int32;
+    value->value = i;
+    ret->value = std::make_pair(std::move(key), std::move(value));
+    return ret;
+  }
+  case NdfTransactionType::ChangeProperty_RemoveMapItem: {
+    auto ret = make_change<NdfTransactionChangeProperty_RemoveMapItem>(
+        object_name, prop::Map);
+    ret->index = 0;
+    return ret;
+  }
+  case NdfTransactionType::ChangeProperty_ChangeMapItem: {
+    auto ret = make_change<NdfTransactionChangeProperty_ChangeMapItem>(
+        object_name, prop::Map);
+    ret->index = 0;
+    ret->key = false;
+    auto change = std::make_unique<NdfTransactionChangeProperty_Int32>();
+    change->value = i;
+    ret->change = std::move(change);
+    return ret;
+  }
+  case NdfTransactionType::ChangeProperty_ChangePairItem: {
+    auto ret = make_change<NdfTransactionChangeProperty_ChangePairItem>(
+        object_name, prop::Pair);
+    ret->first = true;
+    auto change = std::make_unique<NdfTransactionChangeProperty_Int32>();
+    change->value = i;
+    ret->change = std::move(change);
+    return ret;
+  }
+  }
+  return nullptr;
+}
+
+// applies the transactions as separate ui interactions and undoes them
+// again, apply and undo are reported separately
+void bench_transactions(
+    Runner &runner, NdfBinFile &ndfbin, std::string_view name, size_t items,
+    const std::function<std::vector<std::unique_ptr<NdfTransaction>>()>
+        &create,
+    size_t sets_per_interaction = 1) {
+  std::string apply_name = std::format("{}/apply", name);
+  std::string undo_name = std::format("{}/undo", name);
+  if (!runner.is_enabled(apply_name) && !runner.is_enabled(undo_name)) {
+    return;
+  }
+  std::vector<int64_t> apply_durations;
+  std::vector<int64_t> undo_durations;
+  try {
+    for (size_t i = 0; i < runner.get_options().iterations; i++) {
+      auto transactions = create();
+      // the redo history of the last iteration would be dropped by the
+      // first apply
+      ndfbin.clear_redo_history();
+      size_t interactions = 0;
+      auto start = Clock::now();
+      for (size_t j = 0; j < transactions.size(); j++) {
+        ndfbin.apply_transaction(std::move(transactions[j]));
+        if ((j + 1) % sets_per_interaction == 0) {
+          ndfbin.end_interaction();
+          interactions++;
+        }
+      }
+      apply_durations.push_back(elapsed_ns(start));
+      start = Clock::now();
+      for (size_t j = 0; j < interactions; j++) {
+        ndfbin.undo_transaction();
+      }
+      undo_durations.push_back(elapsed_ns(start));
+      ndfbin.take_changes();
+    }
+  } catch (const std::exception &e) {
+    runner.fail(name, e.what());
+    return;
+  }
+  if (runner.is_enabled(apply_name)) {
+    runner.report(apply_name, items, 0, std::move(apply_durations));
+  }
+  if (runner.is_enabled(undo_name)) {
+    runner.report(undo_name, items, 0, std::move(undo_durations));
+  }
+}
+
+void bench_all_transactions(Runner &runner, std::span<const char> data) {
+  const auto &options = runner.get_options();
+  size_t objects = options.generator.object_count;
+  NdfBinFile ndfbin;
+  ndfbin.start_parsing(bench_vfs_path, data);
+  if (ndfbin.get_object_count() != objects) {
+    runner.fail("transaction", "the generated ndfbin could not be loaded");
+    return;
+  }
+  // distinct objects spread over the whole file
+  size_t count = std::min(options.transactions, objects);
+  auto target = [&](size_t j) {
+    return generated_object_name(j * objects / count);
+  };
+  auto other = [&](size_t j) {
+    return generated_object_name((j * objects / count + 1) % objects);
+  };
+
+  for (auto type : magic_enum::enum_values<NdfTransactionType>()) {
+    std::string name =
+        std::format("transaction/{}", magic_enum::enum_name(type));
+    switch (type) {
+    case NdfTransactionType::BulkRename: {
+      // renames every object of the first class in one transaction
+      std::unordered_map<std::string, std::string> renames;
+      for (size_t i = 0; i < objects; i++) {
+        if (generated_class_idx(options.generator, i) == 0) {
+          std::string object_name = generated_object_name(i);
+          renames[object_name] = "Renamed_" + object_name;
+        }
+      }
+      bench_transactions(runner, ndfbin, name, renames.size(), [&]() {
+        auto transaction = std::make_unique<NdfTransactionBulkRename>();
+        transaction->renames = renames;
+        std::vector<std::unique_ptr<NdfTransaction>> ret;
+        ret.push_back(std::move(transaction));
+        return ret;
+      });
+      break;
+    }
+    case NdfTransactionType::CoalescedSet: {
+      // two sets of the same property within one interaction get merged
+      bench_transactions(
+          runner, ndfbin, name, count,
+          [&]() {
+            std::vector<std::unique_ptr<NdfTransaction>> ret;
+            for (size_t j = 0; j < count; j++) {
+              for (size_t seed : {j, j + 1}) {
+                ret.push_back(make_transaction(
+                    NdfTransactionType::ChangeProperty_Float32, target(j),
+                    other(j), seed));
+              }
+            }
+            return ret;
+          },
+          2);
+      break;
+    }
+    default:
+      bench_transactions(runner, ndfbin, name, count, [&]() {
+        std::vector<std::unique_ptr<NdfTransaction>> ret;
+        for (size_t j = 0; j < count; j++) {
+          ret.push_back(make_transaction(type, target(j), other(j), j));
+        }
+        return ret;
+      });
+    }
+  }
+}
+
+// reads, sniffs and repacks a generated dat file the way opening and saving a
+// workspace does
+void bench_edat(Runner &runner, const fs::path &dir) {
+  const std::vector<std::string> names = {
+      "edat/read_entries",    "edat/file_tree",       "edat/file_tree/cached",
+      "edat/add_files/sniff", "edat/add_files/typed", "edat/get_data",
+      "edat/write",
+  };
+  if (std::ranges::none_of(
+          names, [&](auto &name) { return runner.is_enabled(name); })) {
+    return;
+  }
+
+  fs::path dat_path = dir / "generated.dat";
+  auto generated = generate_edat(dat_path, runner.get_options().edat);
+  if (!generated) {
+    runner.fail("edat", "the edat file could not be generated");
+    return;
+  }
+  size_t entries = generated->size();
+
+  // the metas as the file tree creates them, without the detected types
+  std::vector<FileMeta> metas;
+  metas.reserve(entries);
+  size_t data_size = 0;
+  auto read_metas = [&]() {
+    EDatReader reader;
+    if (!reader.open(dat_path)) {
+      return false;
+    }
+    auto dat_entries = reader.read_entries();
+    if (!dat_entries || dat_entries->size() != entries) {
+      return false;
+    }
+    metas.clear();
+    data_size = 0;
+    for (size_t i = 0; i < entries; i++) {
+      auto &entry = dat_entries->at(i);
+      std::replace(entry.path.begin(), entry.path.end(), '\\', '/');
+      metas.push_back(
+          FileMeta("$/" + entry.path, dat_path, entry.offset, entry.size, 0));
+      data_size += entry.size;
+    }
+    return true;
+  };
+  runner.run("edat/read_entries", entries, 0, [&]() {
+    if (!read_metas()) {
+      runner.fail("edat/read_entries", "reading the dictionary failed");
+    }
+  });
+  if (metas.size() != entries && !read_metas()) {
+    runner.fail("edat", "reading the dictionary failed");
+    return;
+  }
+
+  std::unique_ptr<FileTree> tree;
+  runner.run(
+      "edat/file_tree", entries, 0,
+      [&]() { tree->init_from_path(dat_path); },
+      [&]() { tree = std::make_unique<FileTree>(); });
+  if (runner.is_enabled("edat/file_tree/cached")) {
+    fs::path cache_dir = dir / "vfs_cache";
+    auto reset_tree = [&]() {
+      tree = std::make_unique<FileTree>();
+      tree->set_cache_dir(cache_dir);
+    };
+    // the first run writes the cache, all measured ones read it
+    reset_tree();
+    tree->init_from_path(dat_path);
+    runner.run(
+        "edat/file_tree/cached", entries, 0,
+        [&]() { tree->init_from_path(dat_path); }, reset_tree);
+  }
+  if (tree) {
+    size_t ndfbins = std::ranges::count(*generated, FileType::NDFBIN,
+                                        &GeneratedEDatEntry::type);
+    if (tree->get_files_of_type(FileType::NDFBIN).size() != ndfbins) {
+      runner.fail("edat/file_tree", "the file tree has the wrong ndfbins");
+    }
+  }
+  tree.reset();
+
+  WorkspaceConfig config = make_workspace_config(dir);
+  std::unique_ptr<Files> files;
+  std::vector<File *> added;
+  auto reset_files = [&]() {
+    added.clear();
+    files = std::make_unique<Files>(config);
+  };
+  // typed like the file tree passes them, otherwise add_file sniffs the
+  // header from the dat file
+  auto add_files = [&](bool typed) {
+    added.reserve(entries);
+    for (size_t i = 0; i < entries; i++) {
+      FileMeta meta = metas[i];
+      if (typed) {
+        meta.type = generated->at(i).type;
+      }
+      added.push_back(files->add_file({std::move(meta)}, false));
+    }
+  };
+  auto check_types = [&](std::string_view name) {
+    for (size_t i = 0; i < added.size(); i++) {
+      if (added[i]->get_type() != generated->at(i).type) {
+        runner.fail(name, std::format("{} got the wrong type",
+                                      generated->at(i).vfs_path));
+        return;
+      }
+    }
+  };
+  if (runner.is_enabled("edat/add_files/sniff")) {
+    runner.run(
+        "edat/add_files/sniff", entries, 0, [&]() { add_files(false); },
+        reset_files);
+    check_types("edat/add_files/sniff");
+  }
+  runner.run(
+      "edat/add_files/typed", entries, 0, [&]() { add_files(true); },
+      reset_files);
+  if (added.size() != entries) {
+    reset_files();
+    add_files(true);
+  }
+
+  runner.run("edat/get_data", entries, data_size, [&]() {
+    size_t sum = 0;
+    for (File *file : added) {
+      DatView view = file->get_data();
+      if (view.size() != file->get_meta().size) {
+        runner.fail("edat/get_data", "a view has the wrong size");
+        return;
+      }
+      // touches every page, so the data is actually read
+      for (size_t pos = 0; pos < view.size(); pos += 4096) {
+        sum += static_cast<unsigned char>(view.data()[pos]);
+      }
+    }
+    static volatile size_t sink;
+    sink = sum;
+  });
+  reset_files();
+
+  if (!runner.is_enabled("edat/write")) {
+    return;
+  }
+  // every 100th entry gets a new size, so the offsets of all following
+  // entries move
+  EDatWriter writer;
+  fs::path replaced_dir = dir / "replaced";
+  fs::create_directories(replaced_dir);
+  for (size_t i = 0; i < entries; i += 100) {
+    fs::path path = replaced_dir / std::format("{}.bin", i);
+    std::string data(generated->at(i).size / 2 + file_type_header_size, '\0');
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(data.data(), data.size());
+    writer.replace(generated->at(i).vfs_path, path);
+  }
+  fs::path out_path = dir / "written.dat";
+  auto durations = runner.measure([&]() {
+    if (!writer.write(dat_path, out_path)) {
+      runner.fail("edat/write", "writing the dat file failed");
+    }
+  });
+  std::error_code ec;
+  size_t bytes = fs::file_size(out_path, ec);
+  EDatReader reader;
+  auto written = reader.open(out_path) ? reader.read_entries() : std::nullopt;
+  if (ec || !written || written->size() != entries) {
+    runner.fail("edat/write", "the written dat file is broken");
+  }
+  runner.report("edat/write", entries, bytes, std::move(durations));
+}
+
+} // namespace
+
+// the walk over all objects that rebuilding the indexes of a ndfbin does,
+// once through the ndf properties and once through the digests
+void bench_walk(Runner &runner) {
+  NDF ndf;
+  generate_ndf(ndf, runner.get_options().generator);
+  SymbolTable symbols;
+  std::vector<std::pair<Symbol, NDFObject *>> objects;
+  for (auto &[name, object] : ndf.object_map) {
+    objects.emplace_back(symbols.intern(name), &object);
+  }
+  // keeps the walks from being optimized out
+  size_t checksum = 0;
+
+  runner.run("walk/properties", objects.size(), 0, [&]() {
+    for (auto [name, object] : objects) {
+      for (auto &property : object->properties) {
+        for (auto &ref : property->get_object_references()) {
+          checksum += symbols.intern(ref);
+        }
+        for (auto &ref : property->get_import_references()) {
+          checksum += symbols.intern(ref);
+        }
+        checksum += symbols.intern(property->property_name);
+        checksum += property->as_string().size();
+      }
+    }
+  });
+
+  ObjectDigests digests;
+  auto walk_digests = [&]() {
+    for (auto [name, object] : objects) {
+      auto digest = digests.get(name, *object, symbols);
+      for (Symbol ref : digest.object_references) {
+        checksum += ref;
+      }
+      for (Symbol ref : digest.import_references) {
+        checksum += ref;
+      }
+      for (auto &property : digest.properties) {
+        checksum += property.property_name;
+        checksum += digest.value(property).size();
+      }
+    }
+  };
+  runner.run("walk/digests_cold", objects.size(), 0, walk_digests,
+             [&]() { digests.clear(); });
+  walk_digests();
+  runner.run("walk/digests", objects.size(), 0, walk_digests);
+  spdlog::debug("walk checksum {}", checksum);
+}
+
+int main(int argc, char *argv[]) {
+  // stdout only gets the results
+  spdlog::set_default_logger(spdlog::stderr_color_mt("benchmarks"));
+  spdlog::set_level(spdlog::level::warn);
+
+  argparse::ArgumentParser program("benchmarks");
+  program.add_argument("-n", "--objects")
+      .help("Objects of the generated ndfbin")
+      .default_value(10000)
+      .scan<'i', int>();
+  program.add_argument("--classes")
+      .help("Classes of the generated objects")
+      .default_value(64)
+      .scan<'i', int>();
+  program.add_argument("-i", "--iterations")
+      .help("Runs of every benchmark")
+      .default_value(10)
+      .scan<'i', int>();
+  program.add_argument("-t", "--transactions")
+      .help("Transactions applied and undone per iteration")
+      .default_value(1000)
+      .scan<'i', int>();
+  program.add_argument("-e", "--entries")
+      .help("Entries of the generated edat file")
+      .default_value(10000)
+      .scan<'i', int>();
+  program.add_argument("--min-entry-size")
+      .help("Minimum size of the generated edat entries in bytes")
+      .default_value(256)
+      .scan<'i', int>();
+  program.add_argument("--max-entry-size")
+      .help("Maximum size of the generated edat entries in bytes")
+      .default_value(8192)
+      .scan<'i', int>();
+  program.add_argument("--alignment")
+      .help("Alignment of the data of the generated edat entries")
+      .default_value(1)
+      .scan<'i', int>();
+  program.add_argument("--write-edat")
+      .help("Only writes the generated edat file to this path");
+  program.add_argument("-f", "--filter")
+      .help("Only runs the benchmarks whose name contains this")
+      .default_value(std::string{});
+  program.add_argument("-v", "--verbose")
+      .help("Shows info logs")
+      .default_value(false)
+      .implicit_value(true);
+  try {
+    program.parse_args(argc, argv);
+  } catch (const std::exception &e) {
+    std::cerr << e.what() << "\n" << program;
+    return 1;
+  }
+  if (program.get<bool>("-v")) {
+    spdlog::set_level(spdlog::level::info);
+  }
+
+  Options options;
+  options.generator.object_count = std::max(program.get<int>("-n"), 1);
+  options.generator.class_count = std::max(program.get<int>("--classes"), 1);
+  options.iterations = std::max(program.get<int>("-i"), 1);
+  options.transactions = std::max(program.get<int>("-t"), 1);
+  options.edat.entry_count = std::max(program.get<int>("-e"), 1);
+  options.edat.min_entry_size =
+      std::max(program.get<int>("--min-entry-size"), 0);
+  options.edat.max_entry_size =
+      std::max(program.get<int>("--max-entry-size"), 0);
+  options.edat.alignment = std::max(program.get<int>("--alignment"), 1);
+  options.filter = program.get("-f");
+  Runner runner(options);
+
+  // fixture for running the suite itself on a large dat file
+  if (auto path = program.present("--write-edat")) {
+    return generate_edat(path.value(), options.edat) ? 0 : 1;
+  }
+
+  auto data = generate_ndfbin(options.generator);
+  if (data.empty()) {
+    return 1;
+  }
+  fs::path dir = fs::temp_directory_path() /
+                 std::format("modding_suite_benchmarks_{}", getpid());
+  fs::create_directories(dir);
+  fs::path ndfbin_path = dir / "generated.ndfbin";
+  {
+    std::ofstream file(ndfbin_path, std::ios::binary | std::ios::trunc);
+    file.write(data.data(), data.size());
+  }
+
+  bench_load_and_save(runner, data);
+  bench_parse(runner, dir, ndfbin_path);
+  bench_search(runner);
+  bench_walk(runner);
+  bench_all_transactions(runner, data);
+  bench_edat(runner, dir);
+
+  ThreadPoolSingleton::get_instance().shutdown();
+  std::error_code ec;
+  fs::remove_all(dir, ec);
+  return runner.failed() ? 1 : 0;
+}
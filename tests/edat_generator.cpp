@@ -0,0 +1,330 @@
+#include "edat_generator.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <format>
+#include <fstream>
+#include <random>
+#include <string_view>
+
+#include "spdlog/spdlog.h"
+
+#include "edat_reader.hpp"
+#include "files/file_type.hpp"
+
+using namespace wgrd_files;
+
+namespace {
+
+using namespace std::string_view_literals;
+
+struct GeneratedMagic {
+  size_t offset;
+  std::string_view magic;
+};
+
+struct GeneratedType {
+  FileType type;
+  // relative share of the entries
+  uint32_t weight;
+  // folder of the type in the dictionary, with backslashes
+  std::string_view root;
+  std::string_view prefix;
+  std::string_view extension;
+  // empty magics are not written
+  std::array<GeneratedMagic, 2> magics;
+};
+
+// roughly the mix of the game's dat files, textures and sounds dominate
+constexpr std::array generated_types = {
+    GeneratedType{FileType::TGV,
+                  40,
+                  "pc\\texture\\assets\\",
+                  "Texture",
+                  ".tgv",
+                  {{{0, "\x02\x00\x00\x00"sv}}}},
+    GeneratedType{FileType::ESS,
+                  12,
+                  "pc\\sound\\",
+                  "Sound",
+                  ".ess",
+                  {{{0, "\x01\x00\x02\x02"sv}}}},
+    GeneratedType{FileType::NDFBIN,
+                  10,
+                  "pc\\ndf\\patchable\\gfx\\",
+                  "Descriptor",
+                  ".ndfbin",
+                  {{{0, "EUG0"}, {8, "CNDF"}}}},
+    GeneratedType{FileType::PPK,
+                  6,
+                  "pc\\mesh\\",
+                  "Mesh",
+                  ".ppk",
+                  {{{0, "PRXYPCPC"}}}},
+    GeneratedType{FileType::DIC,
+                  4,
+                  "pc\\localisation\\us\\localisation\\",
+                  "Text",
+                  ".dic",
+                  {{{0, "TRAD"}}}},
+    GeneratedType{
+        FileType::SFORMAT, 3, "pc\\sformat\\", "Format", ".sformat", {}},
+    GeneratedType{FileType::SCENARIO,
+                  1,
+                  "pc\\maps\\",
+                  "Map",
+                  ".scenario",
+                  {{{0, "SCENARIO"}}}},
+    GeneratedType{FileType::UNKNOWN, 24, "pc\\shader\\", "Shader", ".fx", {}},
+};
+
+constexpr std::array directory_names = {
+    "Units",  "Vehicles", "Infantry", "Effects", "Interface",
+    "Common", "Nato",     "Pact",     "Lod",     "High",
+};
+
+struct DictEntry {
+  // with backslashes, relative to the root of the dat
+  std::string path;
+  const GeneratedType *type;
+  uint64_t offset;
+  uint64_t size;
+};
+
+template <typename T> void append_le(std::string &data, T value) {
+  char bytes[sizeof(T)];
+  std::memcpy(bytes, &value, sizeof(T));
+  data.append(bytes, sizeof(T));
+}
+
+template <typename T> void write_le(char *data, T value) {
+  std::memcpy(data, &value, sizeof(T));
+}
+
+uint64_t align_up(uint64_t pos, uint64_t alignment) {
+  return (pos + alignment - 1) / alignment * alignment;
+}
+
+// writes the dictionary as the prefix tree EDatReader reads: directory
+// entries hold the common prefix of their subtree, file entries the rest of
+// the path. An entry size of 0 marks the last entry of a directory.
+class DictWriter {
+private:
+  const std::vector<DictEntry> &m_entries;
+  std::string m_dict;
+
+  // names are null terminated and padded to an even length
+  void append_name(std::string_view name) {
+    m_dict += name;
+    m_dict += '\0';
+    if (name.size() % 2 == 0) {
+      m_dict += '\0';
+    }
+  }
+
+  // -1 if the path ends at depth, so it sorts before its siblings
+  int key(size_t idx, size_t depth) const {
+    const std::string &path = m_entries[idx].path;
+    return depth < path.size() ? static_cast<unsigned char>(path[depth]) : -1;
+  }
+
+  size_t common_prefix(const std::string &a, const std::string &b,
+                       size_t depth) const {
+    size_t ret = depth;
+    while (ret < a.size() && ret < b.size() && a[ret] == b[ret]) {
+      ret++;
+    }
+    return ret - depth;
+  }
+
+  void write_file(const DictEntry &entry, size_t depth, bool last) {
+    size_t start = m_dict.size();
+    append_le<int32_t>(m_dict, 0);
+    append_le<uint32_t>(m_dict, 0);
+    append_le<uint64_t>(m_dict, entry.offset);
+    append_le<uint64_t>(m_dict, entry.size);
+    // like the python packer with disabled checksums
+    m_dict.append(edat_header::checksum_size, '\0');
+    append_name(std::string_view(entry.path).substr(depth));
+    if (!last) {
+      write_le<uint32_t>(m_dict.data() + start + 4, m_dict.size() - start);
+    }
+  }
+
+  // writes the entries [begin, end), whose first depth characters are
+  // written by the parent directories already
+  void write_level(size_t begin, size_t end, size_t depth) {
+    size_t idx = begin;
+    while (idx < end) {
+      size_t group_end = idx + 1;
+      while (group_end < end && key(group_end, depth) == key(idx, depth)) {
+        group_end++;
+      }
+      bool last = group_end == end;
+      if (group_end - idx == 1 || key(idx, depth) == -1) {
+        write_file(m_entries[idx], depth, last);
+        idx++;
+        continue;
+      }
+      // the entries are sorted, so the first and the last one share the
+      // prefix of the whole group
+      size_t prefix = common_prefix(m_entries[idx].path,
+                                    m_entries[group_end - 1].path, depth);
+      size_t start = m_dict.size();
+      append_le<int32_t>(m_dict, 0);
+      append_le<uint32_t>(m_dict, 0);
+      append_name(std::string_view(m_entries[idx].path).substr(depth, prefix));
+      write_level(idx, group_end, depth + prefix);
+      // the group id of directories is the size of their subtree
+      write_le<int32_t>(m_dict.data() + start, m_dict.size() - start);
+      if (!last) {
+        write_le<uint32_t>(m_dict.data() + start + 4, m_dict.size() - start);
+      }
+      idx = group_end;
+    }
+  }
+
+public:
+  explicit DictWriter(const std::vector<DictEntry> &entries)
+      : m_entries(entries) {}
+  std::string write() {
+    m_dict.clear();
+    write_level(0, m_entries.size(), 0);
+    return std::move(m_dict);
+  }
+};
+
+const GeneratedType &random_type(std::mt19937 &rng) {
+  static const uint32_t total_weight = [] {
+    uint32_t ret = 0;
+    for (auto &type : generated_types) {
+      ret += type.weight;
+    }
+    return ret;
+  }();
+  uint32_t value = rng() % total_weight;
+  for (auto &type : generated_types) {
+    if (value < type.weight) {
+      return type;
+    }
+    value -= type.weight;
+  }
+  return generated_types.back();
+}
+
+std::string random_path(const EDatGeneratorConfig &config,
+                        const GeneratedType &type, size_t idx,
+                        std::mt19937 &rng) {
+  std::string ret(type.root);
+  size_t depth = config.max_depth > 0 ? rng() % (config.max_depth + 1) : 0;
+  size_t fanout = std::max<size_t>(config.directory_fanout, 1);
+  for (size_t level = 0; level < depth; level++) {
+    const char *name = directory_names[level % directory_names.size()];
+    ret += std::format("{}_{}\\", name, rng() % fanout);
+  }
+  // the index keeps the paths unique and no path a prefix of another one
+  ret += std::format("{}_{:07}{}", type.prefix, idx, type.extension);
+  return ret;
+}
+
+} // namespace
+
+std::optional<std::vector<GeneratedEDatEntry>>
+wgrd_files::generate_edat(const fs::path &path,
+                          const EDatGeneratorConfig &config) {
+  std::mt19937 rng(config.seed);
+  size_t min_size = std::max(config.min_entry_size, file_type_header_size);
+  size_t max_size = std::max(config.max_entry_size, min_size);
+  uint64_t alignment = std::max<uint32_t>(config.alignment, 1);
+
+  std::vector<DictEntry> entries;
+  entries.reserve(config.entry_count);
+  for (size_t idx = 0; idx < config.entry_count; idx++) {
+    const GeneratedType &type = random_type(rng);
+    std::string entry_path = random_path(config, type, idx, rng);
+    uint64_t size = min_size + rng() % (max_size - min_size + 1);
+    entries.push_back({std::move(entry_path), &type, 0, size});
+  }
+  // the dictionary is sorted and the data is in the order of the dictionary
+  std::sort(entries.begin(), entries.end(),
+            [](const DictEntry &a, const DictEntry &b) {
+              return a.path < b.path;
+            });
+  uint64_t data_size = 0;
+  for (auto &entry : entries) {
+    entry.offset = align_up(data_size, alignment);
+    data_size = entry.offset + entry.size;
+  }
+
+  std::string dict = DictWriter(entries).write();
+  uint64_t dict_offset = edat_header::size;
+  uint64_t file_offset = align_up(dict_offset + dict.size(), alignment);
+  if (file_offset > UINT32_MAX) {
+    spdlog::error("generated edat dictionary of {} bytes is too large",
+                  dict.size());
+    return std::nullopt;
+  }
+
+  std::string head(file_offset, '\0');
+  std::memcpy(head.data() + edat_header::magic, "edat", 4);
+  write_le<uint32_t>(head.data() + edat_header::version, 2);
+  write_le<uint32_t>(head.data() + edat_header::dict_offset, dict_offset);
+  write_le<uint32_t>(head.data() + edat_header::dict_length, dict.size());
+  write_le<uint32_t>(head.data() + edat_header::file_offset, file_offset);
+  write_le<uint64_t>(head.data() + edat_header::file_length, data_size);
+  write_le<uint32_t>(head.data() + edat_header::sector_size, alignment);
+  std::memcpy(head.data() + dict_offset, dict.data(), dict.size());
+
+  std::ofstream file(path, std::ios::binary | std::ios::trunc);
+  if (!file) {
+    spdlog::error("Could not create {}", path.string());
+    return std::nullopt;
+  }
+  file.write(head.data(), head.size());
+
+  // the filler of all entries is cut from one random block
+  std::vector<char> filler(1 << 16);
+  for (auto &c : filler) {
+    c = static_cast<char>(rng());
+  }
+  std::vector<GeneratedEDatEntry> ret;
+  ret.reserve(entries.size());
+  uint64_t pos = 0;
+  static const char zeros[4096] = {};
+  for (size_t idx = 0; idx < entries.size(); idx++) {
+    auto &entry = entries[idx];
+    while (pos < entry.offset) {
+      size_t count = std::min<uint64_t>(entry.offset - pos, sizeof(zeros));
+      file.write(zeros, count);
+      pos += count;
+    }
+    // zeros don't match any magic, so only the written ones are detected
+    char header[file_type_header_size] = {};
+    for (auto &[offset, magic] : entry.type->magics) {
+      std::memcpy(header + offset, magic.data(), magic.size());
+    }
+    file.write(header, sizeof(header));
+    uint64_t left = entry.size - sizeof(header);
+    size_t filler_pos = (idx * 7919) % filler.size();
+    while (left > 0) {
+      size_t count = std::min<uint64_t>(left, filler.size() - filler_pos);
+      file.write(filler.data() + filler_pos, count);
+      left -= count;
+      filler_pos = 0;
+    }
+    pos = entry.offset + entry.size;
+
+    std::string vfs_path = "$/" + entry.path;
+    std::replace(vfs_path.begin(), vfs_path.end(), '\\', '/');
+    ret.push_back({std::move(vfs_path), entry.type->type, entry.size});
+  }
+  file.close();
+  if (!file) {
+    spdlog::error("Could not write {}", path.string());
+    return std::nullopt;
+  }
+  spdlog::info("Generated {} with {} entries, {} bytes of data",
+               path.string(), ret.size(), data_size);
+  return ret;
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "files/configs.hpp"
+
+namespace wgrd_files {
+
+// shape of a generated edat file, the same config always generates the same
+// file
+struct EDatGeneratorConfig {
+  size_t entry_count = 10000;
+  // sizes are uniformly distributed between these, entries are never smaller
+  // than the header needed to detect their type
+  size_t min_entry_size = 256;
+  size_t max_entry_size = 8192;
+  // directories between the root folder of the file type and the file
+  size_t max_depth = 6;
+  // different directory names per level
+  size_t directory_fanout = 8;
+  // the data of every entry starts at a multiple of it, 1 packs the entries
+  uint32_t alignment = 1;
+  uint32_t seed = 1;
+};
+
+struct GeneratedEDatEntry {
+  // starts with $/ and uses forward slashes, like the file tree
+  std::string vfs_path;
+  // the type detect_file_type returns for the entry
+  FileType type;
+  size_t size;
+};
+
+/*
+ * Writes a synthetic edat (version 2) file, so the dat code paths can be
+ * measured without a game install.
+ *
+ * The entries get paths below the folders the game uses for their type and
+ * start with the magic of the type, e.g. EUG0 / CNDF for ndfbins or TRAD for
+ * dictionaries. Everything after the magic is filler, so the entries can be
+ * sniffed, read and repacked, but not parsed. Returns the entries in the
+ * order of the dictionary, nullopt if writing failed.
+ * */
+std::optional<std::vector<GeneratedEDatEntry>>
+generate_edat(const fs::path &path, const EDatGeneratorConfig &config);
+
+} // namespace wgrd_files
@@ -0,0 +1,198 @@
+#include <catch2/catch_test_macros.hpp>
+#include <catch2/generators/catch_generators.hpp>
+
+#include <algorithm>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "edat_generator.hpp"
+#include "edat_reader.hpp"
+#include "edat_writer.hpp"
+#include "test_helpers.hpp"
+
+using namespace wgrd_files;
+
+namespace {
+
+// dictionary path -> data of the entry
+std::unordered_map<std::string, std::string> read_edat(const fs::path &path) {
+  EDatReader reader;
+  REQUIRE(reader.open(path));
+  auto entries = reader.read_entries();
+  REQUIRE(entries);
+  std::unordered_map<std::string, std::string> ret;
+  for (auto &entry : entries.value()) {
+    auto data = reader.get_file().subspan(entry.offset, entry.size);
+    ret[entry.path] = std::string(data.begin(), data.end());
+  }
+  return ret;
+}
+
+std::vector<std::string> read_paths(const fs::path &path) {
+  EDatReader reader;
+  REQUIRE(reader.open(path));
+  auto entries = reader.read_entries();
+  REQUIRE(entries);
+  std::vector<std::string> ret;
+  for (auto &entry : entries.value()) {
+    ret.push_back(entry.path);
+  }
+  return ret;
+}
+
+// temp files of the writer left behind next to its output
+bool has_temp_files(const fs::path &dir) {
+  return std::any_of(fs::directory_iterator(dir), fs::directory_iterator(),
+                     [](const fs::directory_entry &entry) {
+                       return entry.path().extension() == ".tmp";
+                     });
+}
+
+std::string to_dict_path(std::string vfs_path) {
+  vfs_path = vfs_path.substr(2);
+  std::replace(vfs_path.begin(), vfs_path.end(), '/', '\\');
+  return vfs_path;
+}
+
+} // namespace
+
+TEST_CASE("generated edat files can be read", "[edat]") {
+  TempDir dir;
+  EDatGeneratorConfig config;
+  config.entry_count = 500;
+  config.alignment = GENERATE(1u, 4096u);
+  auto generated = generate_edat(dir / "test.dat", config);
+  REQUIRE(generated);
+  REQUIRE(generated->size() == config.entry_count);
+
+  EDatReader reader;
+  REQUIRE(reader.open(dir / "test.dat"));
+  auto entries = reader.read_entries();
+  REQUIRE(entries);
+  REQUIRE(entries->size() == generated->size());
+  for (size_t i = 0; i < entries->size(); i++) {
+    REQUIRE(entries->at(i).path == to_dict_path(generated->at(i).vfs_path));
+    REQUIRE(entries->at(i).size == generated->at(i).size);
+  }
+}
+
+TEST_CASE("edat writer round trip", "[edat]") {
+  TempDir dir;
+  fs::path src_path = dir / "src.dat";
+  fs::path dst_path = dir / "dst.dat";
+  EDatGeneratorConfig config;
+  config.entry_count = 300;
+  config.alignment = GENERATE(1u, 4096u);
+  auto generated = generate_edat(src_path, config);
+  REQUIRE(generated);
+  auto src = read_edat(src_path);
+
+  // one entry grows, one becomes empty, one shrinks
+  std::vector<std::pair<std::string, std::string>> replacements = {
+      {generated->at(0).vfs_path, std::string(100000, 'a')},
+      {generated->at(100).vfs_path, ""},
+      {generated->back().vfs_path, "short"},
+  };
+  EDatWriter writer;
+  REQUIRE(writer.empty());
+  for (size_t i = 0; i < replacements.size(); i++) {
+    fs::path data_path = dir / ("replacement_" + std::to_string(i));
+    write_file(data_path, replacements[i].second);
+    writer.replace(replacements[i].first, data_path);
+  }
+  REQUIRE_FALSE(writer.empty());
+
+  auto require_written = [&](const fs::path &path) {
+    REQUIRE(read_paths(path) == read_paths(src_path));
+    auto dst = read_edat(path);
+    REQUIRE(dst.size() == src.size());
+    auto expected = src;
+    for (auto &[vfs_path, data] : replacements) {
+      expected[to_dict_path(vfs_path)] = data;
+    }
+    REQUIRE(dst == expected);
+  };
+
+  SECTION("to another file") {
+    REQUIRE(writer.write(src_path, dst_path));
+    require_written(dst_path);
+    REQUIRE_FALSE(has_temp_files(dir.path()));
+
+    // the alignment of the source is kept
+    EDatReader reader;
+    REQUIRE(reader.open(dst_path));
+    for (auto &entry : reader.read_entries().value()) {
+      REQUIRE(entry.offset % config.alignment == 0);
+    }
+  }
+  SECTION("in place") {
+    fs::copy_file(src_path, dst_path);
+    REQUIRE(writer.write(dst_path, dst_path));
+    require_written(dst_path);
+  }
+  SECTION("without replacements") {
+    REQUIRE(EDatWriter().write(src_path, dst_path));
+    REQUIRE(read_edat(dst_path) == src);
+  }
+  SECTION("two writers to the same file") {
+    // e.g. two workspaces with the same output dat
+    EDatWriter other;
+    for (size_t i = 0; i < replacements.size(); i++) {
+      other.replace(replacements[i].first,
+                    dir / ("replacement_" + std::to_string(i)));
+    }
+    bool ret = false;
+    std::thread thread([&]() { ret = other.write(src_path, dst_path); });
+    REQUIRE(writer.write(src_path, dst_path));
+    thread.join();
+    REQUIRE(ret);
+    require_written(dst_path);
+    REQUIRE_FALSE(has_temp_files(dir.path()));
+  }
+}
+
+TEST_CASE("edat writer rejects broken input", "[edat]") {
+  TempDir dir;
+  fs::path src_path = dir / "src.dat";
+  fs::path dst_path = dir / "dst.dat";
+  EDatGeneratorConfig config;
+  config.entry_count = 100;
+  auto generated = generate_edat(src_path, config);
+  REQUIRE(generated);
+  // the previous output must survive a failed write
+  write_file(dst_path, "previous output");
+
+  EDatWriter writer;
+  write_file(dir / "replacement", "data");
+  writer.replace(generated->at(10).vfs_path, dir / "replacement");
+
+  SECTION("unknown entry") {
+    writer.replace("$/pc/not/in/the/dat", dir / "replacement");
+    REQUIRE_FALSE(writer.write(src_path, dst_path));
+  }
+  SECTION("truncated data") {
+    truncate_file(src_path, 1);
+    REQUIRE_FALSE(writer.write(src_path, dst_path));
+  }
+  SECTION("truncated dictionary") {
+    fs::resize_file(src_path, edat_header::size + 16);
+    REQUIRE_FALSE(writer.write(src_path, dst_path));
+  }
+  SECTION("bad magic") {
+    corrupt_file(src_path, edat_header::magic);
+    REQUIRE_FALSE(writer.write(src_path, dst_path));
+  }
+  SECTION("other version") {
+    corrupt_file(src_path, edat_header::version);
+    REQUIRE_FALSE(writer.write(src_path, dst_path));
+  }
+  SECTION("missing source") {
+    fs::remove(src_path);
+    REQUIRE_FALSE(writer.write(src_path, dst_path));
+  }
+  REQUIRE(read_file(dst_path) == "previous output");
+  REQUIRE_FALSE(has_temp_files(dir.path()));
+}
@@ -1 +1,107 @@
 #include <catch2/catch_test_macros.hpp>
+
+#include <map>
+#include <string>
+#include <utility>
+
+#include <magic_enum.hpp>
+
+#include "edat_generator.hpp"
+#include "file_tree.hpp"
+#include "test_helpers.hpp"
+#include "vfs_cache.hpp"
+
+using namespace wgrd_files;
+
+namespace {
+
+// vfs_path -> type and size
+typedef std::map<std::string, std::pair<FileType, size_t>> TreeFiles;
+
+TreeFiles to_tree_files(const std::vector<GeneratedEDatEntry> &entries) {
+  TreeFiles ret;
+  for (auto &entry : entries) {
+    ret[entry.vfs_path] = {entry.type, entry.size};
+  }
+  return ret;
+}
+
+TreeFiles read_tree(FileTree &tree, const fs::path &dat_path) {
+  TreeFiles ret;
+  for (FileType type : magic_enum::enum_values<FileType>()) {
+    for (auto &metas : tree.get_files_of_type(type)) {
+      REQUIRE(metas.size() == 1);
+      auto &meta = metas.back();
+      REQUIRE(meta.fs_path == dat_path);
+      REQUIRE(meta.type == type);
+      REQUIRE(ret.emplace(meta.vfs_path, std::pair{type, meta.size}).second);
+    }
+  }
+  return ret;
+}
+
+} // namespace
+
+TEST_CASE("file tree of a dat file", "[file_tree]") {
+  TempDir dir;
+  fs::path dat_path = dir / "test.dat";
+  EDatGeneratorConfig config;
+  config.entry_count = 1000;
+  auto generated = generate_edat(dat_path, config);
+  REQUIRE(generated);
+
+  FileTree tree;
+  REQUIRE(tree.init_from_path(dat_path));
+  REQUIRE(read_tree(tree, dat_path) == to_tree_files(generated.value()));
+}
+
+TEST_CASE("file tree cache", "[file_tree]") {
+  TempDir dir;
+  fs::path dat_path = dir / "test.dat";
+  fs::path cache_dir = dir / "db";
+  fs::path cache_path = VfsCache::get_cache_path(cache_dir, dat_path);
+  EDatGeneratorConfig config;
+  config.entry_count = 1000;
+  auto generated = generate_edat(dat_path, config);
+  REQUIRE(generated);
+  TreeFiles expected = to_tree_files(generated.value());
+
+  {
+    FileTree tree;
+    tree.set_cache_dir(cache_dir);
+    REQUIRE(tree.init_from_path(dat_path));
+    REQUIRE(read_tree(tree, dat_path) == expected);
+  }
+  REQUIRE(fs::exists(cache_path));
+  auto cache = VfsCache::load(cache_path);
+  REQUIRE(cache);
+  REQUIRE(cache->entries.size() == expected.size());
+
+  SECTION("reopening uses the cache") {
+    // a cache that differs from the dat shows whether it was used
+    cache->entries.pop_back();
+    REQUIRE(cache->save(cache_path));
+    FileTree tree;
+    tree.set_cache_dir(cache_dir);
+    REQUIRE(tree.init_from_path(dat_path));
+    REQUIRE(read_tree(tree, dat_path).size() == expected.size() - 1);
+  }
+  SECTION("a corrupt cache is rebuilt") {
+    corrupt_file(cache_path, fs::file_size(cache_path) / 2);
+    FileTree tree;
+    tree.set_cache_dir(cache_dir);
+    REQUIRE(tree.init_from_path(dat_path));
+    REQUIRE(read_tree(tree, dat_path) == expected);
+    REQUIRE(VfsCache::load(cache_path));
+  }
+  SECTION("a changed dat invalidates the cache") {
+    config.seed = 2;
+    config.entry_count = 500;
+    generated = generate_edat(dat_path, config);
+    REQUIRE(generated);
+    FileTree tree;
+    tree.set_cache_dir(cache_dir);
+    REQUIRE(tree.init_from_path(dat_path));
+    REQUIRE(read_tree(tree, dat_path) == to_tree_files(generated.value()));
+  }
+}
@@ -0,0 +1,113 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <cstring>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "ndf_codec.hpp"
+
+using namespace wgrd_files;
+
+namespace {
+
+// uncompressed ndfbin with a compressible body of the given size
+std::vector<char> make_ndfbin(size_t body_size, uint32_t seed = 1) {
+  std::vector<char> ret(ndfbin_header::size + body_size);
+  std::memcpy(ret.data() + ndfbin_header::magic, "EUG0", 4);
+  std::memcpy(ret.data() + ndfbin_header::cndf_magic, "CNDF", 4);
+  uint64_t footer_offset = ret.size();
+  std::memcpy(ret.data() + ndfbin_header::footer_offset, &footer_offset, 8);
+  std::mt19937 rng(seed);
+  for (size_t i = ndfbin_header::size; i < ret.size(); i++) {
+    // few distinct values, like the tables of real ndfbins
+    ret[i] = static_cast<char>(rng() % 16);
+  }
+  return ret;
+}
+
+std::string compress(const std::vector<char> &data) {
+  std::stringstream stream;
+  REQUIRE(compress_ndfbin(data, stream));
+  return stream.str();
+}
+
+std::span<const char> as_span(const std::string &data) {
+  return std::span<const char>(data.data(), data.size());
+}
+
+} // namespace
+
+TEST_CASE("ndfbin codec round trip", "[ndf_codec]") {
+  // larger than the output buffer of compress_ndfbin
+  for (size_t body_size : {size_t(0), size_t(1), size_t(4096),
+                           size_t(300 * 1024)}) {
+    auto ndfbin = make_ndfbin(body_size);
+    std::string compressed = compress(ndfbin);
+
+    uint32_t flag;
+    std::memcpy(&flag, compressed.data() + ndfbin_header::compressed, 4);
+    REQUIRE(flag == ndfbin_header::compressed_flag);
+    uint32_t stored_size;
+    std::memcpy(&stored_size, compressed.data() + ndfbin_header::size, 4);
+    REQUIRE(stored_size == body_size);
+    if (body_size > 4096) {
+      REQUIRE(compressed.size() < ndfbin.size());
+    }
+
+    auto decompressed = decompress_ndfbin(as_span(compressed));
+    REQUIRE(decompressed);
+    REQUIRE(decompressed.value() == ndfbin);
+  }
+}
+
+TEST_CASE("uncompressed ndfbins are returned as is", "[ndf_codec]") {
+  auto ndfbin = make_ndfbin(1024);
+  auto decompressed = decompress_ndfbin(ndfbin);
+  REQUIRE(decompressed);
+  REQUIRE(decompressed.value() == ndfbin);
+}
+
+TEST_CASE("broken ndfbins are rejected", "[ndf_codec]") {
+  auto ndfbin = make_ndfbin(64 * 1024);
+  std::string compressed = compress(ndfbin);
+
+  SECTION("no ndfbin") {
+    std::string data(ndfbin_header::size + 16, 'x');
+    REQUIRE_FALSE(decompress_ndfbin(as_span(data)));
+    std::stringstream stream;
+    REQUIRE_FALSE(compress_ndfbin(as_span(data), stream));
+    // a rejected ndfbin leaves no partial header behind
+    REQUIRE(stream.str().empty());
+  }
+  SECTION("truncated header") {
+    REQUIRE_FALSE(decompress_ndfbin(
+        as_span(compressed).subspan(0, ndfbin_header::size - 1)));
+    REQUIRE_FALSE(decompress_ndfbin(
+        as_span(compressed).subspan(0, ndfbin_header::size + 2)));
+  }
+  SECTION("truncated body") {
+    for (size_t count : {size_t(1), size_t(16), compressed.size() / 2}) {
+      REQUIRE_FALSE(decompress_ndfbin(
+          as_span(compressed).subspan(0, compressed.size() - count)));
+    }
+  }
+  SECTION("corrupt body") {
+    // the adler32 at the end of the zlib stream catches what inflate doesn't
+    for (size_t pos : {ndfbin_header::size + 4 + 2, compressed.size() / 2,
+                       compressed.size() - 1}) {
+      std::string corrupt = compressed;
+      corrupt[pos] = static_cast<char>(~corrupt[pos]);
+      REQUIRE_FALSE(decompress_ndfbin(as_span(corrupt)));
+    }
+  }
+  SECTION("wrong size") {
+    uint32_t body_size = 64 * 1024 - 1;
+    std::memcpy(compressed.data() + ndfbin_header::size, &body_size, 4);
+    REQUIRE_FALSE(decompress_ndfbin(as_span(compressed)));
+    body_size = 64 * 1024 + 1;
+    std::memcpy(compressed.data() + ndfbin_header::size, &body_size, 4);
+    REQUIRE_FALSE(decompress_ndfbin(as_span(compressed)));
+  }
+}
@@ -0,0 +1,280 @@
+#include "ndf_generator.hpp"
+
+#include <format>
+#include <memory>
+#include <random>
+#include <sstream>
+
+#include "spdlog/spdlog.h"
+
+#include "ndf_codec.hpp"
+
+using namespace wgrd_files;
+
+namespace {
+
+template <typename T>
+std::unique_ptr<T> make_property(const char *name, NDFPropertyType type) {
+  auto ret = std::make_unique<T>();
+  ret->property_name = name;
+  ret->property_type = type;
+  return ret;
+}
+
+void add_property(NDFObject &object, std::unique_ptr<NDFProperty> property) {
+  object.property_map[property->property_name] = object.properties.size();
+  object.properties.push_back(std::move(property));
+}
+
+std::string random_hex(std::mt19937 &rng, size_t length) {
+  std::string ret;
+  ret.reserve(length);
+  for (size_t i = 0; i < length; i++) {
+    ret += "0123456789abcdef"[rng() % 16];
+  }
+  return ret;
+}
+
+int32_t random_int(std::mt19937 &rng, int32_t max) {
+  return static_cast<int32_t>(rng() % static_cast<uint32_t>(max));
+}
+
+// std distributions differ between standard libraries, the raw output of the
+// engine doesn't
+float random_float(std::mt19937 &rng) {
+  return static_cast<float>(rng() % 100000) / 100.0f;
+}
+
+std::unique_ptr<NDFPropertyObjectReference>
+make_reference(const char *name, std::string object_name) {
+  auto ret = make_property<NDFPropertyObjectReference>(
+      name, NDFPropertyType::ObjectReference);
+  ret->object_name = std::move(object_name);
+  return ret;
+}
+
+std::unique_ptr<NDFPropertyInt32> make_int32(const char *name,
+                                             int32_t value) {
+  auto ret = make_property<NDFPropertyInt32>(name, NDFPropertyType::Int32);
+  ret->value = value;
+  return ret;
+}
+
+NDFObject generate_object(const NdfGeneratorConfig &config, size_t idx,
+                          std::mt19937 &rng) {
+  namespace prop = generated_property;
+  NDFObject object;
+  object.name = generated_object_name(idx);
+  object.class_name = generated_class_name(generated_class_idx(config, idx));
+  object.is_top_object =
+      config.top_object_every > 0 && idx % config.top_object_every == 0;
+  if (object.is_top_object) {
+    object.export_path = "$/Generated/" + object.name;
+  }
+  // references only go to objects generated before, the first one points
+  // to itself
+  auto earlier = [&]() {
+    return generated_object_name(idx == 0 ? 0 : rng() % idx);
+  };
+
+  {
+    auto p = make_property<NDFPropertyBool>(prop::Bool, NDFPropertyType::Bool);
+    p->value = rng() % 2;
+    add_property(object, std::move(p));
+  }
+  {
+    auto p =
+        make_property<NDFPropertyUInt8>(prop::UInt8, NDFPropertyType::UInt8);
+    p->value = random_int(rng, 100);
+    add_property(object, std::move(p));
+  }
+  {
+    auto p =
+        make_property<NDFPropertyUInt16>(prop::UInt16, NDFPropertyType::UInt16);
+    p->value = random_int(rng, 65536);
+    add_property(object, std::move(p));
+  }
+  {
+    auto p =
+        make_property<NDFPropertyInt16>(prop::Int16, NDFPropertyType::Int16);
+    p->value = random_int(rng, 2000) - 1000;
+    add_property(object, std::move(p));
+  }
+  add_property(object, make_int32(prop::Int32, random_int(rng, 10000)));
+  {
+    auto p =
+        make_property<NDFPropertyUInt32>(prop::UInt32, NDFPropertyType::UInt32);
+    p->value = rng();
+    add_property(object, std::move(p));
+  }
+  {
+    auto p = make_property<NDFPropertyFloat32>(prop::Float32,
+                                               NDFPropertyType::Float32);
+    p->value = random_float(rng);
+    add_property(object, std::move(p));
+  }
+  {
+    auto p = make_property<NDFPropertyFloat64>(prop::Float64,
+                                               NDFPropertyType::Float64);
+    p->value = random_float(rng);
+    add_property(object, std::move(p));
+  }
+  {
+    auto p =
+        make_property<NDFPropertyString>(prop::String, NDFPropertyType::String);
+    p->value = std::format("'{}_{}'", object.class_name, idx);
+    add_property(object, std::move(p));
+  }
+  {
+    auto p = make_property<NDFPropertyWideString>(prop::WideString,
+                                                  NDFPropertyType::WideString);
+    p->value = std::format("Generated unit {}", idx);
+    add_property(object, std::move(p));
+  }
+  {
+    auto p =
+        make_property<NDFPropertyGUID>(prop::GUID, NDFPropertyType::NDFGUID);
+    p->guid = random_hex(rng, 32);
+    add_property(object, std::move(p));
+  }
+  {
+    auto p = make_property<NDFPropertyLocalisationHash>(
+        prop::LocalisationHash, NDFPropertyType::LocalisationHash);
+    p->hash = random_hex(rng, 16);
+    add_property(object, std::move(p));
+  }
+  {
+    auto p = make_property<NDFPropertyHash>(prop::Hash, NDFPropertyType::Hash);
+    p->hash = random_hex(rng, 24);
+    add_property(object, std::move(p));
+  }
+  {
+    auto p = make_property<NDFPropertyPathReference>(
+        prop::PathReference, NDFPropertyType::PathReference);
+    p->path = std::format("GameData:/Generated/Model_{:04}.fbx", rng() % 1000);
+    add_property(object, std::move(p));
+  }
+  add_property(object, make_reference(prop::ObjectReference, earlier()));
+  {
+    auto p = make_property<NDFPropertyImportReference>(
+        prop::ImportReference, NDFPropertyType::ImportReference);
+    p->import_name = std::format("$/GFX/Imported/Import_{:04}", rng() % 1000);
+    add_property(object, std::move(p));
+  }
+  {
+    auto p = make_property<NDFPropertyF32_vec2>(prop::F32_vec2,
+                                                NDFPropertyType::F32_vec2);
+    p->x = random_float(rng);
+    p->y = random_float(rng);
+    add_property(object, std::move(p));
+  }
+  {
+    auto p = make_property<NDFPropertyF32_vec3>(prop::F32_vec3,
+                                                NDFPropertyType::F32_vec3);
+    p->x = random_float(rng);
+    p->y = random_float(rng);
+    p->z = random_float(rng);
+    add_property(object, std::move(p));
+  }
+  {
+    auto p = make_property<NDFPropertyF32_vec4>(prop::F32_vec4,
+                                                NDFPropertyType::F32_vec4);
+    p->x = random_float(rng);
+    p->y = random_float(rng);
+    p->z = random_float(rng);
+    p->w = random_float(rng);
+    add_property(object, std::move(p));
+  }
+  {
+    auto p =
+        make_property<NDFPropertyColor>(prop::Color, NDFPropertyType::Color);
+    p->r = random_int(rng, 256);
+    p->g = random_int(rng, 256);
+    p->b = random_int(rng, 256);
+    p->a = 255;
+    add_property(object, std::move(p));
+  }
+  {
+    auto p = make_property<NDFPropertyS32_vec2>(prop::S32_vec2,
+                                                NDFPropertyType::S32_vec2);
+    p->x = random_int(rng, 1000);
+    p->y = random_int(rng, 1000);
+    add_property(object, std::move(p));
+  }
+  {
+    auto p = make_property<NDFPropertyS32_vec3>(prop::S32_vec3,
+                                                NDFPropertyType::S32_vec3);
+    p->x = random_int(rng, 1000);
+    p->y = random_int(rng, 1000);
+    p->z = random_int(rng, 1000);
+    add_property(object, std::move(p));
+  }
+  {
+    auto p = make_property<NDFPropertyList>(prop::List, NDFPropertyType::List);
+    for (size_t i = 0; i < config.list_size; i++) {
+      p->values.push_back(make_reference("ListItem", earlier()));
+    }
+    add_property(object, std::move(p));
+  }
+  {
+    auto p = make_property<NDFPropertyMap>(prop::Map, NDFPropertyType::Map);
+    for (size_t i = 0; i < config.list_size; i++) {
+      auto key = make_property<NDFPropertyString>("Key",
+                                                  NDFPropertyType::String);
+      key->value = std::format("'Tag{}'", i);
+      p->values.emplace_back(std::move(key),
+                             make_int32("Value", random_int(rng, 100)));
+    }
+    add_property(object, std::move(p));
+  }
+  {
+    auto p = make_property<NDFPropertyPair>(prop::Pair, NDFPropertyType::Pair);
+    int32_t min = random_int(rng, 1000);
+    p->first = make_int32("First", min);
+    p->second = make_int32("Second", min + random_int(rng, 1000));
+    add_property(object, std::move(p));
+  }
+  return object;
+}
+
+} // namespace
+
+std::string wgrd_files::generated_object_name(size_t idx) {
+  return std::format("Descriptor_Unit_{:07}", idx);
+}
+
+std::string wgrd_files::generated_class_name(size_t idx) {
+  return std::format("TGeneratedDescriptor{:03}", idx);
+}
+
+size_t wgrd_files::generated_class_idx(const NdfGeneratorConfig &config,
+                                       size_t idx) {
+  return config.class_count > 0 ? idx % config.class_count : 0;
+}
+
+void wgrd_files::generate_ndf(NDF &ndf, const NdfGeneratorConfig &config) {
+  ndf.clear();
+  std::mt19937 rng(config.seed);
+  for (size_t i = 0; i < config.object_count; i++) {
+    auto object = generate_object(config, i, rng);
+    std::string name = object.name;
+    ndf.object_map.insert({std::move(name), std::move(object)});
+  }
+}
+
+std::vector<char>
+wgrd_files::generate_ndfbin(const NdfGeneratorConfig &config) {
+  NDF ndf;
+  generate_ndf(ndf, config);
+  std::stringstream uncompressed;
+  ndf.save_as_ndfbin_stream(uncompressed);
+  std::string_view data = uncompressed.view();
+  std::stringstream compressed;
+  if (!compress_ndfbin(std::span<const char>(data.data(), data.size()),
+                       compressed)) {
+    spdlog::error("Could not compress the generated ndfbin");
+    return {};
+  }
+  std::string_view ret = compressed.view();
+  return std::vector<char>(ret.begin(), ret.end());
+}
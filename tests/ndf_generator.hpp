@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "ndf.hpp"
+
+namespace wgrd_files {
+
+// properties every generated object has, one per ndf property type
+namespace generated_property {
+constexpr const char *Bool = "IsEnabled";
+constexpr const char *UInt8 = "Priority";
+constexpr const char *UInt16 = "Flags";
+constexpr const char *Int16 = "Offset";
+constexpr const char *Int32 = "Cost";
+constexpr const char *UInt32 = "Count";
+constexpr const char *Float32 = "Speed";
+constexpr const char *Float64 = "Weight";
+constexpr const char *String = "Name";
+constexpr const char *WideString = "DisplayName";
+constexpr const char *GUID = "DescriptorId";
+constexpr const char *LocalisationHash = "NameToken";
+constexpr const char *Hash = "TextureHash";
+constexpr const char *PathReference = "Model";
+constexpr const char *ObjectReference = "Parent";
+constexpr const char *ImportReference = "Import";
+constexpr const char *F32_vec2 = "Size";
+constexpr const char *F32_vec3 = "Position";
+constexpr const char *F32_vec4 = "Rotation";
+constexpr const char *Color = "Color";
+constexpr const char *S32_vec2 = "GridSize";
+constexpr const char *S32_vec3 = "GridPosition";
+// object references to objects generated before the owner
+constexpr const char *List = "Modules";
+// string keys, int32 values
+constexpr const char *Map = "Tags";
+// two int32
+constexpr const char *Pair = "Range";
+} // namespace generated_property
+
+// shape of a generated object graph, the same config always generates the
+// same graph
+struct NdfGeneratorConfig {
+  size_t object_count = 10000;
+  size_t class_count = 64;
+  // items of the list and map of every object
+  size_t list_size = 4;
+  // every n-th object is a top object with an export path
+  size_t top_object_every = 4;
+  uint32_t seed = 1;
+};
+
+std::string generated_object_name(size_t idx);
+std::string generated_class_name(size_t idx);
+// the class of the idx-th object
+size_t generated_class_idx(const NdfGeneratorConfig &config, size_t idx);
+
+// replaces the content of ndf with the generated objects
+void generate_ndf(NDF &ndf, const NdfGeneratorConfig &config);
+// the generated ndf compressed like the ndfbins in the dat files, empty if
+// writing it failed
+std::vector<char> generate_ndfbin(const NdfGeneratorConfig &config);
+
+} // namespace wgrd_files
@@ -0,0 +1,156 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <string>
+#include <vector>
+
+#include "ndf_journal.hpp"
+#include "test_helpers.hpp"
+
+using namespace wgrd_files;
+
+namespace {
+
+using Op = NdfJournal::Op;
+
+const std::vector<NdfJournal::Record> records = {
+    {Op::APPLY, "first transaction"},
+    {Op::END_INTERACTION, ""},
+    {Op::APPLY, std::string(100000, 'x')},
+    {Op::UNDO, ""},
+    {Op::REDO, ""},
+    {Op::APPLY, std::string("with\0null", 9)},
+};
+
+void append_records(const fs::path &path) {
+  NdfJournal journal;
+  REQUIRE(journal.open(path));
+  for (auto &record : records) {
+    REQUIRE(journal.append(record.op, record.payload));
+  }
+}
+
+void require_records(const std::vector<NdfJournal::Record> &read,
+                     size_t count) {
+  REQUIRE(read.size() == count);
+  for (size_t i = 0; i < count; i++) {
+    REQUIRE(read[i].op == records[i].op);
+    REQUIRE(read[i].payload == records[i].payload);
+  }
+}
+
+} // namespace
+
+TEST_CASE("journal round trip", "[ndf_journal]") {
+  TempDir dir;
+  fs::path path = dir / "undo" / "file.journal";
+  append_records(path);
+
+  NdfJournal journal;
+  auto read = journal.open(path);
+  REQUIRE(read);
+  require_records(read.value(), records.size());
+
+  SECTION("appends after reopening") {
+    REQUIRE(journal.append(Op::UNDO));
+    journal.close();
+    read = journal.open(path);
+    REQUIRE(read);
+    REQUIRE(read->size() == records.size() + 1);
+    REQUIRE(read->back().op == Op::UNDO);
+  }
+  SECTION("reset drops all records") {
+    REQUIRE(journal.reset());
+    REQUIRE(journal.append(Op::APPLY, "after reset"));
+    journal.close();
+    read = journal.open(path);
+    REQUIRE(read);
+    REQUIRE(read->size() == 1);
+    REQUIRE(read->front().payload == "after reset");
+  }
+}
+
+TEST_CASE("torn and corrupt journal records are cut off", "[ndf_journal]") {
+  TempDir dir;
+  fs::path path = dir / "file.journal";
+  append_records(path);
+  size_t last_size = 9 + records.back().payload.size();
+
+  SECTION("torn payload") {
+    truncate_file(path, 1);
+  }
+  SECTION("torn record header") {
+    truncate_file(path, last_size - 3);
+  }
+  SECTION("bad crc") {
+    corrupt_file(path, -static_cast<int64_t>(last_size) + 4);
+  }
+  SECTION("corrupt payload") {
+    corrupt_file(path, -2);
+  }
+
+  NdfJournal journal;
+  auto read = journal.open(path);
+  REQUIRE(read);
+  // everything before the broken record is kept
+  require_records(read.value(), records.size() - 1);
+  // the broken record was cut off, new records are readable again
+  REQUIRE(journal.append(records.back().op, records.back().payload));
+  journal.close();
+  read = journal.open(path);
+  REQUIRE(read);
+  require_records(read.value(), records.size());
+}
+
+TEST_CASE("a corrupt record hides all following ones", "[ndf_journal]") {
+  TempDir dir;
+  fs::path path = dir / "file.journal";
+  append_records(path);
+  // inside the payload of the first record
+  corrupt_file(path, 8 + 9 + 2);
+
+  NdfJournal journal;
+  auto read = journal.open(path);
+  REQUIRE(read);
+  REQUIRE(read->empty());
+}
+
+TEST_CASE("invalid journals are moved aside", "[ndf_journal]") {
+  TempDir dir;
+  fs::path path = dir / "file.journal";
+  fs::path bak_path = dir / "file.journal.bak";
+  append_records(path);
+
+  SECTION("bad magic") {
+    corrupt_file(path, 0);
+  }
+  SECTION("other version") {
+    corrupt_file(path, 4);
+  }
+  SECTION("truncated header") {
+    fs::resize_file(path, 6);
+  }
+  std::string invalid = read_file(path);
+
+  NdfJournal journal;
+  auto read = journal.open(path);
+  REQUIRE(read);
+  REQUIRE(read->empty());
+  // nothing is lost, the old file can still be recovered
+  REQUIRE(fs::exists(bak_path));
+  REQUIRE(read_file(bak_path) == invalid);
+  REQUIRE(journal.append(Op::APPLY, "new"));
+  journal.close();
+  read = journal.open(path);
+  REQUIRE(read);
+  REQUIRE(read->size() == 1);
+}
+
+TEST_CASE("new journals are empty", "[ndf_journal]") {
+  TempDir dir;
+  NdfJournal journal;
+  auto read = journal.open(dir / "new.journal");
+  REQUIRE(read);
+  REQUIRE(read->empty());
+  REQUIRE(journal.is_open());
+  REQUIRE_FALSE(fs::exists(dir / "new.journal.bak"));
+}
@@ -0,0 +1,302 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "files/file.hpp"
+#include "files/file_type.hpp"
+#include "helpers.hpp"
+#include "ndf_generator.hpp"
+#include "ndf_journal.hpp"
+#include "ndftransactions.hpp"
+#include "test_helpers.hpp"
+
+using namespace wgrd_files;
+
+namespace {
+
+const std::string test_vfs_path = "$/Test/Generated.ndfbin";
+
+NdfGeneratorConfig small_config() {
+  NdfGeneratorConfig config;
+  config.object_count = 200;
+  config.class_count = 8;
+  return config;
+}
+
+void load_generated(NdfBinFile &ndfbin) {
+  static const std::vector<char> data = generate_ndfbin(small_config());
+  REQUIRE_FALSE(data.empty());
+  ndfbin.start_parsing(test_vfs_path, std::span<const char>(data));
+  REQUIRE(ndfbin.get_object_count() == small_config().object_count);
+}
+
+// the whole content of the ndf, used to compare two files
+std::string save_ndfbin(NdfBinFile &ndfbin) {
+  std::stringstream stream;
+  REQUIRE(ndfbin.save_ndfbin_to_stream(stream));
+  return stream.str();
+}
+
+// names of objects that aren't exported depend on the ndfbin loader
+std::unique_ptr<NdfTransaction> change_export_path(NdfBinFile &ndfbin,
+                                                   size_t idx) {
+  auto ret = std::make_unique<NdfTransactionChangeObjectExportPath>();
+  ret->object_name = ndfbin.get_object_at_index(idx).name;
+  ret->export_path = "$/Changed/" + ret->object_name;
+  return ret;
+}
+
+std::unique_ptr<NdfTransaction> change_top_object(NdfBinFile &ndfbin,
+                                                  size_t idx) {
+  auto ret = std::make_unique<NdfTransactionChangeObjectTopObject>();
+  ret->object_name = ndfbin.get_object_at_index(idx).name;
+  ret->top_object = true;
+  return ret;
+}
+
+} // namespace
+
+TEST_CASE("snapshot round trip", "[snapshot]") {
+  TempDir dir;
+  fs::path path = dir / "bin" / "file.ndfbin.snapshot";
+  NdfBinFile ndfbin;
+  load_generated(ndfbin);
+  ndfbin.apply_transaction(change_export_path(ndfbin, 3));
+  std::string expected = save_ndfbin(ndfbin);
+
+  for (bool modified : {false, true}) {
+    REQUIRE(ndfbin.save_snapshot(path, modified));
+    REQUIRE_FALSE(fs::exists(fs::path(path) += ".tmp"));
+
+    NdfBinFile loaded;
+    bool loaded_modified = !modified;
+    REQUIRE(loaded.load_snapshot(path, loaded_modified));
+    REQUIRE(loaded_modified == modified);
+    REQUIRE(loaded.get_object_count() == ndfbin.get_object_count());
+    REQUIRE(save_ndfbin(loaded) == expected);
+  }
+}
+
+TEST_CASE("broken snapshots are rejected", "[snapshot]") {
+  TempDir dir;
+  fs::path path = dir / "file.ndfbin.snapshot";
+  NdfBinFile ndfbin;
+  load_generated(ndfbin);
+  REQUIRE(ndfbin.save_snapshot(path, true));
+  size_t size = fs::file_size(path);
+
+  SECTION("empty") {
+    write_file(path, "");
+  }
+  SECTION("truncated header") {
+    fs::resize_file(path, 12);
+  }
+  SECTION("truncated body") {
+    truncate_file(path, 1);
+  }
+  SECTION("bad magic") {
+    corrupt_file(path, 0);
+  }
+  SECTION("unknown version") {
+    std::string data = read_file(path);
+    uint32_t version = 1000;
+    std::memcpy(data.data() + 4, &version, 4);
+    write_file(path, data);
+  }
+  SECTION("bad crc") {
+    corrupt_file(path, 16);
+  }
+  SECTION("corrupt body") {
+    corrupt_file(path, size / 2);
+  }
+  std::string broken = read_file(path);
+
+  // a failed load leaves the file and the loaded ndf alone
+  NdfBinFile other;
+  load_generated(other);
+  other.apply_transaction(change_top_object(other, 5));
+  std::string before = save_ndfbin(other);
+  bool modified = false;
+  REQUIRE_FALSE(other.load_snapshot(path, modified));
+  REQUIRE(save_ndfbin(other) == before);
+  REQUIRE(read_file(path) == broken);
+}
+
+TEST_CASE("the journal replays edits on top of the snapshot", "[snapshot]") {
+  TempDir dir;
+  fs::path snapshot_path = dir / "file.ndfbin.snapshot";
+  fs::path journal_path = fs::path(snapshot_path) += ".journal";
+  fs::path bak_path = fs::path(journal_path) += ".bak";
+
+  NdfBinFile ndfbin;
+  load_generated(ndfbin);
+  REQUIRE(ndfbin.save_snapshot(snapshot_path, false));
+  REQUIRE(ndfbin.open_journal(journal_path, false) == 0);
+  ndfbin.apply_transaction(change_export_path(ndfbin, 1));
+  ndfbin.end_interaction();
+  ndfbin.apply_transaction(change_top_object(ndfbin, 2));
+  ndfbin.undo_transaction();
+  ndfbin.apply_transaction(change_export_path(ndfbin, 4));
+  std::string expected = save_ndfbin(ndfbin);
+
+  SECTION("replay") {
+    NdfBinFile loaded;
+    bool modified = false;
+    REQUIRE(loaded.load_snapshot(snapshot_path, modified));
+    REQUIRE(loaded.open_journal(journal_path, true) == 5);
+    REQUIRE(save_ndfbin(loaded) == expected);
+  }
+  SECTION("records that aren't replayed are moved aside") {
+    NdfBinFile loaded;
+    load_generated(loaded);
+    REQUIRE(loaded.open_journal(journal_path, false) == 0);
+    REQUIRE(fs::exists(bak_path));
+
+    // the edits can still be recovered from the backup
+    NdfBinFile recovered;
+    bool modified = false;
+    REQUIRE(recovered.load_snapshot(snapshot_path, modified));
+    REQUIRE(recovered.open_journal(bak_path, true) == 5);
+    REQUIRE(save_ndfbin(recovered) == expected);
+  }
+  SECTION("a checkpoint drops the records") {
+    ndfbin.checkpoint_journal();
+    NdfBinFile loaded;
+    bool modified = false;
+    REQUIRE(loaded.load_snapshot(snapshot_path, modified));
+    REQUIRE(loaded.open_journal(journal_path, true) == 0);
+    REQUIRE_FALSE(fs::exists(bak_path));
+  }
+}
+
+TEST_CASE("undo and redo of edits before the snapshot are replayed",
+          "[snapshot]") {
+  TempDir dir;
+  fs::path snapshot_path = dir / "file.ndfbin.snapshot";
+  fs::path journal_path = fs::path(snapshot_path) += ".journal";
+
+  NdfBinFile ndfbin;
+  load_generated(ndfbin);
+  REQUIRE(ndfbin.open_journal(journal_path, false) == 0);
+  ndfbin.apply_transaction(change_export_path(ndfbin, 1));
+  ndfbin.end_interaction();
+  ndfbin.apply_transaction(change_top_object(ndfbin, 2));
+  ndfbin.end_interaction();
+  std::string applied = save_ndfbin(ndfbin);
+  // what NdfBin::save_snapshot does
+  auto checkpoint = [&]() {
+    REQUIRE(ndfbin.save_snapshot(snapshot_path, true));
+    ndfbin.checkpoint_journal();
+  };
+  checkpoint();
+  auto reopen = [&](NdfBinFile &loaded) {
+    bool modified = false;
+    REQUIRE(loaded.load_snapshot(snapshot_path, modified));
+    REQUIRE(loaded.open_journal(journal_path, true) > 0);
+  };
+
+  SECTION("undo") {
+    ndfbin.undo_transaction();
+    ndfbin.undo_transaction();
+    // applied on top of the undone edits
+    ndfbin.apply_transaction(change_export_path(ndfbin, 4));
+    std::string expected = save_ndfbin(ndfbin);
+    NdfBinFile loaded;
+    reopen(loaded);
+    REQUIRE(save_ndfbin(loaded) == expected);
+
+    // the replayed undo steps are gone with the new edit, like in the
+    // original history
+    loaded.undo_transaction();
+    loaded.undo_transaction();
+    REQUIRE(save_ndfbin(loaded) != applied);
+  }
+  SECTION("undo and redo") {
+    ndfbin.undo_transaction();
+    ndfbin.undo_transaction();
+    ndfbin.redo_transaction();
+    std::string expected = save_ndfbin(ndfbin);
+    NdfBinFile loaded;
+    reopen(loaded);
+    REQUIRE(save_ndfbin(loaded) == expected);
+    // the undone edit can still be redone after the reopen
+    loaded.redo_transaction();
+    REQUIRE(save_ndfbin(loaded) == applied);
+  }
+  SECTION("redo of steps undone before the snapshot") {
+    ndfbin.undo_transaction();
+    checkpoint();
+    ndfbin.redo_transaction();
+    NdfBinFile loaded;
+    reopen(loaded);
+    REQUIRE(save_ndfbin(loaded) == applied);
+    loaded.undo_transaction();
+    ndfbin.undo_transaction();
+    REQUIRE(save_ndfbin(loaded) == save_ndfbin(ndfbin));
+  }
+}
+
+TEST_CASE("ndfbins with a broken snapshot keep their edits",
+          "[snapshot]") {
+  TempDir dir;
+  WorkspaceConfig config;
+  config.name = "tests";
+  config.fs_path = dir.path();
+  config.dat_path = dir / "dat";
+  config.bin_path = dir / "bin";
+  config.xml_path = dir / "xml";
+  config.db_path = dir / "db";
+  config.tmp_path = dir / "tmp";
+  fs::create_directories(config.db_path);
+
+  fs::path ndfbin_path = dir / "generated.ndfbin";
+  auto data = generate_ndfbin(small_config());
+  REQUIRE_FALSE(data.empty());
+  write_file(ndfbin_path, std::string_view(data.data(), data.size()));
+  fs::path snapshot_path =
+      fs::path(config.bin_path / remove_dollar(test_vfs_path)) +=
+      ".snapshot";
+  fs::path journal_path = fs::path(snapshot_path) += ".journal";
+
+  Files files(config);
+  File *file = files.add_file({FileMeta{test_vfs_path, ndfbin_path, 0,
+                                        data.size(), 0, FileType::NDFBIN}},
+                              false);
+  REQUIRE(file);
+  auto parse = [&]() {
+    REQUIRE(file->prepare_parsing());
+    bool ret = file->parse();
+    file->check_parsing();
+    return ret;
+  };
+  // the first parse reads the ndfbin and saves the snapshot
+  REQUIRE(parse());
+  REQUIRE(fs::exists(snapshot_path));
+
+  // edits done after the snapshot, as left behind by a crash
+  {
+    NdfJournal journal;
+    REQUIRE(journal.open(journal_path));
+    // object 0 is exported, so its name doesn't depend on the loader
+    auto transaction = std::make_unique<NdfTransactionChangeObjectExportPath>();
+    transaction->object_name = generated_object_name(0);
+    transaction->export_path = "$/Changed/" + transaction->object_name;
+    auto payload = serialize_transaction(*transaction);
+    REQUIRE(payload);
+    REQUIRE(journal.append(NdfJournal::Op::APPLY, payload.value()));
+  }
+  corrupt_file(snapshot_path, fs::file_size(snapshot_path) / 2);
+  std::string broken = read_file(snapshot_path);
+  std::string journal = read_file(journal_path);
+
+  // falls back to the ndfbin, but neither file is overwritten
+  REQUIRE(parse());
+  REQUIRE(read_file(fs::path(snapshot_path) += ".bak") == broken);
+  REQUIRE(read_file(fs::path(journal_path) += ".bak") == journal);
+  bool modified = false;
+  NdfBinFile rebuilt;
+  REQUIRE(rebuilt.load_snapshot(snapshot_path, modified));
+}
@@ -0,0 +1,394 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "ndf_generator.hpp"
+#include "ndftransactions.hpp"
+#include "test_helpers.hpp"
+
+using namespace wgrd_files;
+
+namespace {
+
+namespace prop = generated_property;
+
+void load_generated(NdfBinFile &file, size_t object_count = 16) {
+  NdfGeneratorConfig config;
+  config.object_count = object_count;
+  auto ndfbin = generate_ndfbin(config);
+  REQUIRE_FALSE(ndfbin.empty());
+  file.start_parsing("generated.ndfbin", std::span<const char>(ndfbin));
+  REQUIRE(file.get_object_count() == object_count);
+}
+
+// names of objects that aren't exported depend on the ndfbin loader
+std::string name_at(NdfBinFile &file, size_t idx) {
+  return file.get_object_at_index(idx).name;
+}
+
+int32_t get_cost(NdfBinFile &file, size_t idx) {
+  auto &property = file.get_object_at_index(idx).get_property(prop::Int32);
+  return reinterpret_cast<std::unique_ptr<NDFPropertyInt32> &>(property)
+      ->value;
+}
+
+std::unique_ptr<NdfTransactionChangeProperty_Int32>
+set_cost(NdfBinFile &file, size_t idx, int32_t value) {
+  auto ret = std::make_unique<NdfTransactionChangeProperty_Int32>();
+  ret->object_name = name_at(file, idx);
+  ret->property_name = prop::Int32;
+  ret->value = value;
+  return ret;
+}
+
+NDFPropertyList &get_modules(NdfBinFile &file, size_t idx) {
+  auto &property = file.get_object_at_index(idx).get_property(prop::List);
+  return *reinterpret_cast<std::unique_ptr<NDFPropertyList> &>(property);
+}
+
+std::string get_module(NdfBinFile &file, size_t idx, uint32_t item) {
+  auto &value = get_modules(file, idx).values.at(item);
+  return reinterpret_cast<std::unique_ptr<NDFPropertyObjectReference> &>(value)
+      ->object_name;
+}
+
+std::unique_ptr<NdfTransactionChangeProperty_ChangeListItem>
+set_module(NdfBinFile &file, size_t idx, uint32_t item, size_t target) {
+  auto change = std::make_unique<NdfTransactionChangeProperty_ObjectReference>();
+  change->object_name = name_at(file, idx);
+  change->property_name = "ListItem";
+  change->value = name_at(file, target);
+  auto ret = std::make_unique<NdfTransactionChangeProperty_ChangeListItem>();
+  ret->object_name = name_at(file, idx);
+  ret->property_name = prop::List;
+  ret->index = item;
+  ret->change = std::move(change);
+  return ret;
+}
+
+} // namespace
+
+TEST_CASE("sets during one interaction are one undo step",
+          "[ndf_transactions]") {
+  NdfBinFile file;
+  load_generated(file);
+  int32_t original = get_cost(file, 1);
+
+  for (int32_t value = 1; value <= 10; value++) {
+    file.apply_transaction(set_cost(file, 1, value));
+  }
+  REQUIRE(get_cost(file, 1) == 10);
+  REQUIRE(file.applied_transactions.size() == 1);
+
+  SECTION("undo restores the value before the first set") {
+    file.undo_transaction();
+    REQUIRE(get_cost(file, 1) == original);
+    file.redo_transaction();
+    REQUIRE(get_cost(file, 1) == 10);
+  }
+  SECTION("a new interaction starts a new undo step") {
+    file.end_interaction();
+    file.apply_transaction(set_cost(file, 1, 20));
+    REQUIRE(file.applied_transactions.size() == 2);
+    file.undo_transaction();
+    REQUIRE(get_cost(file, 1) == 10);
+  }
+  SECTION("sets of other targets are not merged") {
+    file.apply_transaction(set_cost(file, 2, 5));
+    file.apply_transaction(set_cost(file, 1, 11));
+    REQUIRE(file.applied_transactions.size() == 3);
+  }
+  SECTION("undo ends the interaction") {
+    file.apply_transaction(set_cost(file, 2, 5));
+    file.undo_transaction();
+    file.apply_transaction(set_cost(file, 1, 11));
+    REQUIRE(file.applied_transactions.size() == 2);
+  }
+}
+
+TEST_CASE("sets of list items are coalesced per item", "[ndf_transactions]") {
+  NdfBinFile file;
+  load_generated(file);
+  std::string original = get_module(file, 5, 0);
+
+  for (size_t target = 0; target < 4; target++) {
+    file.apply_transaction(set_module(file, 5, 0, target));
+  }
+  REQUIRE(get_module(file, 5, 0) == name_at(file, 3));
+  REQUIRE(file.applied_transactions.size() == 1);
+  file.apply_transaction(set_module(file, 5, 1, 2));
+  REQUIRE(file.applied_transactions.size() == 2);
+
+  file.undo_transaction();
+  file.undo_transaction();
+  REQUIRE(get_module(file, 5, 0) == original);
+  REQUIRE(file.applied_transactions.empty());
+}
+
+namespace {
+
+std::unique_ptr<NdfTransactionRemoveObject> remove_object(std::string name) {
+  auto ret = std::make_unique<NdfTransactionRemoveObject>();
+  ret->object_name = std::move(name);
+  return ret;
+}
+
+std::unique_ptr<NdfTransactionChangeProperty_RemoveListItem>
+remove_module(NdfBinFile &file, size_t idx, uint32_t item) {
+  auto ret = std::make_unique<NdfTransactionChangeProperty_RemoveListItem>();
+  ret->object_name = name_at(file, idx);
+  ret->property_name = prop::List;
+  ret->index = item;
+  return ret;
+}
+
+std::unique_ptr<NdfTransactionChangeProperty_AddListItem>
+add_module(NdfBinFile &file, size_t idx, uint32_t item, size_t target) {
+  auto value = std::make_unique<NDFPropertyObjectReference>();
+  value->property_name = "ListItem";
+  value->property_type = NDFPropertyType::ObjectReference;
+  value->object_name = name_at(file, target);
+  auto ret = std::make_unique<NdfTransactionChangeProperty_AddListItem>();
+  ret->object_name = name_at(file, idx);
+  ret->property_name = prop::List;
+  ret->index = item;
+  ret->value = std::move(value);
+  return ret;
+}
+
+std::vector<std::string> get_module_names(NdfBinFile &file,
+                                          const std::string &name) {
+  std::vector<std::string> ret;
+  auto &property = file.get_object(name).get_property(prop::List);
+  for (auto &value :
+       reinterpret_cast<std::unique_ptr<NDFPropertyList> &>(property)->values) {
+    ret.push_back(
+        reinterpret_cast<std::unique_ptr<NDFPropertyObjectReference> &>(value)
+            ->object_name);
+  }
+  return ret;
+}
+
+// applies one undo step of every kind that holds ndf values, each in its
+// own interaction
+void apply_edits(NdfBinFile &file) {
+  file.apply_transaction(set_cost(file, 1, 1000));
+  file.end_interaction();
+  file.apply_transaction(remove_module(file, 5, 1));
+  file.end_interaction();
+  file.apply_transaction(add_module(file, 7, 0, 2));
+  file.end_interaction();
+  // moves the objects after it, so it comes after the edits by position
+  file.apply_transaction(remove_object(name_at(file, 6)));
+  file.end_interaction();
+  file.apply_transaction(set_cost(file, 1, 2000));
+  file.end_interaction();
+}
+constexpr size_t edit_count = 5;
+
+} // namespace
+
+TEST_CASE("undo steps over the budget are spilled and paged back",
+          "[ndf_transactions]") {
+  TempDir dir;
+  NdfBinFile file;
+  load_generated(file);
+  int32_t original_cost = get_cost(file, 1);
+  std::string removed_name = name_at(file, 6);
+  auto removed_modules = get_module_names(file, removed_name);
+  auto modules_5 = get_module_names(file, name_at(file, 5));
+  auto modules_7 = get_module_names(file, name_at(file, 7));
+  std::string name_7 = name_at(file, 7);
+  std::string name_5 = name_at(file, 5);
+
+  SECTION("entry budget") {
+    file.set_history_budget(2, std::numeric_limits<size_t>::max(),
+                            dir / "undo" / "file.spill");
+    apply_edits(file);
+    REQUIRE(file.applied_transactions.size() == 2);
+    REQUIRE(file.get_spilled_count() == edit_count - 2);
+  }
+  SECTION("byte budget") {
+    file.set_history_budget(std::numeric_limits<size_t>::max(),
+                            ndf_property_size_estimate,
+                            dir / "undo" / "file.spill");
+    apply_edits(file);
+    REQUIRE(file.get_history_bytes() <= ndf_property_size_estimate);
+    REQUIRE(file.get_spilled_count() > 0);
+  }
+
+  REQUIRE_FALSE(file.contains_object(removed_name));
+  REQUIRE(get_module_names(file, name_5).size() == modules_5.size() - 1);
+  REQUIRE(get_module_names(file, name_7).size() == modules_7.size() + 1);
+  for (size_t i = 0; i < edit_count; i++) {
+    file.undo_transaction();
+  }
+  REQUIRE(file.get_spilled_count() == 0);
+  REQUIRE(get_cost(file, 1) == original_cost);
+  REQUIRE(file.contains_object(removed_name));
+  REQUIRE(get_module_names(file, removed_name) == removed_modules);
+  REQUIRE(get_module_names(file, name_5) == modules_5);
+  REQUIRE(get_module_names(file, name_7) == modules_7);
+
+  // paged in steps are redone from memory, the budget only keeps the
+  // nearest redo steps
+  file.redo_transaction();
+  REQUIRE(get_cost(file, 1) == 1000);
+}
+
+TEST_CASE("undo steps that can't be spilled stay in memory",
+          "[ndf_transactions]") {
+  TempDir dir;
+  NdfBinFile file;
+  load_generated(file);
+  int32_t original_cost = get_cost(file, 1);
+  std::string removed_name = name_at(file, 6);
+  // the spill file can't be created below a file
+  write_file(dir / "file", "");
+  file.set_history_budget(2, std::numeric_limits<size_t>::max(),
+                          dir / "file" / "file.spill");
+  apply_edits(file);
+  REQUIRE(file.get_spilled_count() == 0);
+  REQUIRE(file.applied_transactions.size() == edit_count);
+
+  for (size_t i = 0; i < edit_count; i++) {
+    file.undo_transaction();
+  }
+  REQUIRE(file.applied_transactions.empty());
+  REQUIRE(get_cost(file, 1) == original_cost);
+  REQUIRE(file.contains_object(removed_name));
+}
+
+TEST_CASE("without a spill file the budget drops old undo steps",
+          "[ndf_transactions]") {
+  NdfBinFile file;
+  load_generated(file);
+  file.set_history_budget(2, std::numeric_limits<size_t>::max(), "");
+  apply_edits(file);
+  REQUIRE(file.applied_transactions.size() == 2);
+  REQUIRE(file.get_spilled_count() == 0);
+  file.undo_transaction();
+  file.undo_transaction();
+  file.undo_transaction();
+  REQUIRE(file.applied_transactions.empty());
+  // only the removal of the object and the last set were kept
+  REQUIRE(get_cost(file, 1) == 1000);
+}
+
+namespace {
+
+std::unique_ptr<NDFPropertyInt32> make_int32(int32_t value) {
+  auto ret = std::make_unique<NDFPropertyInt32>();
+  ret->property_name = "Value";
+  ret->property_type = NDFPropertyType::Int32;
+  ret->value = value;
+  return ret;
+}
+
+std::unique_ptr<NdfTransactionChangeProperty_AddMapItem>
+add_tag(NdfBinFile &file, size_t idx, uint32_t item, std::string key,
+        int32_t value) {
+  auto key_property = std::make_unique<NDFPropertyString>();
+  key_property->property_name = "Key";
+  key_property->property_type = NDFPropertyType::String;
+  key_property->value = std::move(key);
+  auto ret = std::make_unique<NdfTransactionChangeProperty_AddMapItem>();
+  ret->object_name = name_at(file, idx);
+  ret->property_name = prop::Map;
+  ret->index = item;
+  ret->value = {std::move(key_property), make_int32(value)};
+  return ret;
+}
+
+std::vector<std::pair<std::string, int32_t>> get_tags(NdfBinFile &file,
+                                                      size_t idx) {
+  std::vector<std::pair<std::string, int32_t>> ret;
+  auto &property = file.get_object_at_index(idx).get_property(prop::Map);
+  for (auto &[key, value] :
+       reinterpret_cast<std::unique_ptr<NDFPropertyMap> &>(property)->values) {
+    ret.emplace_back(
+        reinterpret_cast<std::unique_ptr<NDFPropertyString> &>(key)->value,
+        reinterpret_cast<std::unique_ptr<NDFPropertyInt32> &>(value)->value);
+  }
+  return ret;
+}
+
+// an edit the journal can't hold
+struct UnreplayableSet : NdfTransactionChangeProperty_Int32 {
+  bool is_replayable() const override { return false; }
+};
+
+} // namespace
+
+TEST_CASE("journaled edits are replayed on a fresh load",
+          "[ndf_transactions]") {
+  TempDir dir;
+  fs::path journal_path = dir / "file.journal";
+  std::vector<std::string> modules;
+  std::vector<std::pair<std::string, int32_t>> tags;
+  size_t object_count = 0;
+  {
+    NdfBinFile file;
+    load_generated(file);
+    REQUIRE(file.open_journal(journal_path, true) == 0);
+    apply_edits(file);
+    file.apply_transaction(add_tag(file, 3, 0, "'Added'", 42));
+    file.end_interaction();
+    // undone edits are replayed as undone
+    file.apply_transaction(add_module(file, 3, 0, 1));
+    file.undo_transaction();
+    REQUIRE_FALSE(file.take_checkpoint_request());
+    modules = get_module_names(file, name_at(file, 7));
+    tags = get_tags(file, 3);
+    object_count = file.get_object_count();
+  }
+
+  NdfBinFile file;
+  load_generated(file);
+  REQUIRE(file.open_journal(journal_path, true) > 0);
+  REQUIRE(get_cost(file, 1) == 2000);
+  REQUIRE(get_module_names(file, name_at(file, 7)) == modules);
+  REQUIRE(get_tags(file, 3) == tags);
+  REQUIRE(tags.front() == std::make_pair(std::string("'Added'"), 42));
+  REQUIRE(file.get_object_count() == object_count);
+
+  // the replayed adds can still be undone
+  file.undo_transaction();
+  file.undo_transaction();
+  REQUIRE(get_tags(file, 3).size() == tags.size() - 1);
+  REQUIRE(get_cost(file, 1) == 1000);
+}
+
+TEST_CASE("edits the journal can't hold request a checkpoint",
+          "[ndf_transactions]") {
+  TempDir dir;
+  fs::path journal_path = dir / "file.journal";
+  NdfBinFile file;
+  load_generated(file);
+  file.open_journal(journal_path, true);
+  file.apply_transaction(set_cost(file, 1, 1000));
+  file.end_interaction();
+  REQUIRE_FALSE(file.take_checkpoint_request());
+
+  auto unreplayable = std::make_unique<UnreplayableSet>();
+  unreplayable->object_name = name_at(file, 2);
+  unreplayable->property_name = prop::Int32;
+  unreplayable->value = 7;
+  file.apply_transaction(std::move(unreplayable));
+  file.end_interaction();
+  REQUIRE(file.take_checkpoint_request());
+  // requested once
+  REQUIRE_FALSE(file.take_checkpoint_request());
+
+  // journaling resumes after the checkpoint
+  file.checkpoint_journal();
+  file.apply_transaction(set_cost(file, 1, 2000));
+  file.end_interaction();
+  NdfBinFile replayed;
+  load_generated(replayed);
+  REQUIRE(replayed.open_journal(journal_path, true) > 0);
+  REQUIRE(get_cost(replayed, 1) == 2000);
+}
@@ -0,0 +1,128 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "ndf_generator.hpp"
+#include "ndftransactions.hpp"
+#include "object_digests.hpp"
+
+using namespace wgrd_files;
+
+namespace {
+
+// the digest must match what the properties return
+void require_matches(ObjectDigests::Digest digest, NDFObject &object,
+                     SymbolTable &symbols) {
+  REQUIRE(digest.properties.size() == object.properties.size());
+  std::vector<Symbol> object_references;
+  std::vector<Symbol> import_references;
+  for (size_t i = 0; i < object.properties.size(); i++) {
+    auto &property = object.properties[i];
+    REQUIRE(symbols.str(digest.properties[i].property_name) ==
+            property->property_name);
+    REQUIRE(digest.value(digest.properties[i]) == property->as_string());
+    for (auto &ref : property->get_object_references()) {
+      object_references.push_back(symbols.intern(ref));
+    }
+    for (auto &ref : property->get_import_references()) {
+      import_references.push_back(symbols.intern(ref));
+    }
+  }
+  REQUIRE(std::vector<Symbol>(digest.object_references.begin(),
+                              digest.object_references.end()) ==
+          object_references);
+  REQUIRE(std::vector<Symbol>(digest.import_references.begin(),
+                              digest.import_references.end()) ==
+          import_references);
+}
+
+} // namespace
+
+TEST_CASE("object digests copy values and references", "[object_digests]") {
+  NdfGeneratorConfig config;
+  config.object_count = 2000;
+  NDF ndf;
+  generate_ndf(ndf, config);
+  SymbolTable symbols;
+  ObjectDigests digests;
+
+  auto check_all = [&]() {
+    for (auto &[name, object] : ndf.object_map) {
+      Symbol symbol = symbols.intern(name);
+      require_matches(digests.get(symbol, object, symbols), object, symbols);
+    }
+  };
+  check_all();
+  size_t memory = digests.memory_usage();
+  // digests are only built once
+  check_all();
+  REQUIRE(digests.memory_usage() == memory);
+
+  SECTION("invalidated digests are rebuilt from the object") {
+    auto &object = ndf.object_map.begin().value();
+    Symbol symbol = symbols.intern(object.name);
+    auto &property = object.get_property(generated_property::Int32);
+    reinterpret_cast<std::unique_ptr<NDFPropertyInt32> &>(property)->value =
+        -12345;
+    // stale until invalidated
+    auto digest = digests.get(symbol, object, symbols);
+    REQUIRE(digest.value(digest.properties[object.property_map.at(
+                generated_property::Int32)]) != "-12345");
+    digests.invalidate(symbol);
+    require_matches(digests.get(symbol, object, symbols), object, symbols);
+  }
+  SECTION("compaction keeps the other digests") {
+    // drops and rebuilds every digest until the arrays get compacted
+    for (int round = 0; round < 3; round++) {
+      for (auto &[name, object] : ndf.object_map) {
+        digests.invalidate(symbols.intern(name));
+      }
+      check_all();
+    }
+    REQUIRE(digests.memory_usage() < 2 * memory);
+  }
+  SECTION("cleared") {
+    digests.clear();
+    REQUIRE(digests.memory_usage() == 0);
+    check_all();
+  }
+}
+
+TEST_CASE("transactions drop the digests of changed objects",
+          "[object_digests]") {
+  NdfGeneratorConfig config;
+  config.object_count = 16;
+  auto ndfbin = generate_ndfbin(config);
+  REQUIRE_FALSE(ndfbin.empty());
+  NdfBinFile file;
+  file.start_parsing("generated.ndfbin", std::span<const char>(ndfbin));
+  auto check_all = [&]() {
+    for (Symbol name : file.get_object_names()) {
+      require_matches(file.get_digest(name), file.get_object(name),
+                      file.get_symbols());
+    }
+  };
+  check_all();
+
+  auto set_cost = std::make_unique<NdfTransactionChangeProperty_Int32>();
+  set_cost->object_name = file.get_object_at_index(3).name;
+  set_cost->property_name = generated_property::Int32;
+  set_cost->value = -12345;
+  file.apply_transaction(std::move(set_cost));
+  check_all();
+  file.undo_transaction();
+  check_all();
+
+  // references to the renamed object are fixed in other objects
+  Symbol referenced =
+      file.get_digest(file.get_symbols().intern(
+                          file.get_object_at_index(15).name))
+          .object_references.front();
+  auto rename = std::make_unique<NdfTransactionChangeObjectName>();
+  rename->object_name = std::string(file.get_symbols().str(referenced));
+  rename->name = "Renamed";
+  file.apply_transaction(std::move(rename));
+  check_all();
+}
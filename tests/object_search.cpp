@@ -0,0 +1,154 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "object_search.hpp"
+#include "symbol_table.hpp"
+
+using namespace wgrd_files;
+
+namespace {
+
+const auto never = []() { return false; };
+
+std::vector<Symbol> find(const TrigramIndex &index, std::string_view needle) {
+  auto ret = index.find(needle, never);
+  REQUIRE(ret);
+  return ret.value();
+}
+
+// waits for the result of the latest query
+std::vector<Symbol> wait_result(ObjectSearch &search) {
+  auto timeout = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+  while (search.is_pending()) {
+    if (auto ret = search.take_result()) {
+      return ret.value();
+    }
+    REQUIRE(std::chrono::steady_clock::now() < timeout);
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+  }
+  FAIL("no query is pending");
+  return {};
+}
+
+} // namespace
+
+TEST_CASE("trigram index substring queries", "[object_search]") {
+  TrigramIndex index;
+  index.add(1, "Descriptor_Unit_T72");
+  index.add(2, "Descriptor_Unit_M1A1");
+  index.add(3, "Weapon_T72_Gun");
+  REQUIRE(index.size() == 3);
+
+  // queries are lowercase, the texts are lowercased when added
+  REQUIRE(find(index, "descriptor") == std::vector<Symbol>{1, 2});
+  REQUIRE(find(index, "t72") == std::vector<Symbol>{1, 3});
+  REQUIRE(find(index, "unit_m1") == std::vector<Symbol>{2});
+  REQUIRE(find(index, "tank").empty());
+  // all trigrams of the needle exist, but not next to each other
+  REQUIRE(find(index, "unit_t72_gun").empty());
+
+  SECTION("needles shorter than a trigram") {
+    REQUIRE(find(index, "").size() == 3);
+    REQUIRE(find(index, "m1") == std::vector<Symbol>{2});
+    REQUIRE(find(index, "_") == std::vector<Symbol>{1, 2, 3});
+  }
+  SECTION("removed texts are not found") {
+    index.remove(1);
+    index.remove(42);
+    REQUIRE(index.size() == 2);
+    REQUIRE(find(index, "t72") == std::vector<Symbol>{3});
+    REQUIRE(find(index, "descriptor") == std::vector<Symbol>{2});
+  }
+  SECTION("adding an id again replaces its text") {
+    index.add(3, "Weapon_M1A1_Gun");
+    REQUIRE(index.size() == 3);
+    REQUIRE(find(index, "t72") == std::vector<Symbol>{1});
+    REQUIRE(find(index, "m1a1") == std::vector<Symbol>{2, 3});
+  }
+  SECTION("cleared") {
+    index.clear();
+    REQUIRE(index.size() == 0);
+    REQUIRE(find(index, "t72").empty());
+  }
+}
+
+TEST_CASE("trigram index queries can be cancelled", "[object_search]") {
+  TrigramIndex index;
+  for (Symbol i = 0; i < 5000; i++) {
+    index.add(i, "Descriptor_Unit_" + std::to_string(i));
+  }
+  const auto always = []() { return true; };
+  REQUIRE_FALSE(index.find("un", always));
+  REQUIRE_FALSE(index.find("unit_1", always));
+  REQUIRE(find(index, "unit_1").size() == 1111);
+}
+
+TEST_CASE("object search by object and class name", "[object_search]") {
+  SymbolTable symbols;
+  auto search = std::make_shared<ObjectSearch>();
+  auto add = [&](std::string_view name, std::string_view class_name) {
+    Symbol ret = symbols.intern(name);
+    search->add_object(ret, name, symbols.intern(class_name), class_name);
+    return ret;
+  };
+  Symbol t72 = add("Descriptor_Unit_T72", "TEntityDescriptor");
+  Symbol m1 = add("Descriptor_Unit_M1A1", "TEntityDescriptor");
+  Symbol gun = add("Weapon_T72_Gun", "TWeaponManagerModuleDescriptor");
+  auto sorted = [](std::vector<Symbol> symbols) {
+    std::sort(symbols.begin(), symbols.end());
+    return symbols;
+  };
+
+  REQUIRE_FALSE(search->is_pending());
+  search->start_query("", "");
+  REQUIRE(wait_result(*search) == sorted({t72, m1, gun}));
+  search->start_query("t72", "");
+  REQUIRE(wait_result(*search) == sorted({t72, gun}));
+  search->start_query("", "entitydescriptor");
+  REQUIRE(wait_result(*search) == sorted({t72, m1}));
+  search->start_query("t72", "entity");
+  REQUIRE(wait_result(*search) == std::vector<Symbol>{t72});
+  search->start_query("t72", "tank");
+  REQUIRE(wait_result(*search).empty());
+
+  SECTION("the latest query wins") {
+    search->start_query("m1a1", "");
+    search->start_query("gun", "");
+    REQUIRE(wait_result(*search) == std::vector<Symbol>{gun});
+    REQUIRE_FALSE(search->is_pending());
+  }
+  SECTION("cancelled queries return nothing") {
+    search->start_query("t72", "");
+    search->cancel();
+    REQUIRE_FALSE(search->is_pending());
+    REQUIRE_FALSE(search->take_result());
+  }
+  SECTION("removed objects are not found") {
+    search->remove_object(t72);
+    search->start_query("t72", "");
+    REQUIRE(wait_result(*search) == std::vector<Symbol>{gun});
+    // the last object of a class takes the class with it
+    search->remove_object(gun);
+    search->start_query("", "weapon");
+    REQUIRE(wait_result(*search).empty());
+  }
+  SECTION("objects can change their class") {
+    add("Weapon_T72_Gun", "TEntityDescriptor");
+    search->start_query("", "entity");
+    REQUIRE(wait_result(*search) == sorted({t72, m1, gun}));
+    search->start_query("", "weapon");
+    REQUIRE(wait_result(*search).empty());
+  }
+  SECTION("cleared") {
+    search->clear();
+    search->start_query("", "");
+    REQUIRE(wait_result(*search).empty());
+  }
+}
@@ -0,0 +1,123 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <map>
+#include <set>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+#include "reference_index.hpp"
+
+using namespace wgrd_files;
+
+namespace {
+
+typedef std::unordered_map<std::string, std::unordered_set<std::string>>
+    FileImports;
+
+// vfs_path -> object names, flattened for comparing
+std::map<std::string, std::set<std::string>>
+importers_of(const ReferenceIndex &index, const std::string &export_path) {
+  std::map<std::string, std::set<std::string>> ret;
+  auto importers = index.get_importers(export_path);
+  if (importers) {
+    for (auto &[vfs_path, object_names] : *importers) {
+      ret[vfs_path] = *object_names;
+    }
+  }
+  return ret;
+}
+
+} // namespace
+
+TEST_CASE("imports of all files are merged per export path",
+          "[reference_index]") {
+  ReferenceIndex index;
+  index.set_file_imports("a.ndfbin", {{"$/Unit/T72", {"Weapon_A", "Pack_A"}},
+                                      {"$/Unit/M1A1", {"Pack_A"}}});
+  index.set_file_imports("b.ndfbin", {{"$/Unit/T72", {"Deck_B"}}});
+
+  REQUIRE(importers_of(index, "$/Unit/T72") ==
+          std::map<std::string, std::set<std::string>>{
+              {"a.ndfbin", {"Pack_A", "Weapon_A"}}, {"b.ndfbin", {"Deck_B"}}});
+  REQUIRE(importers_of(index, "$/Unit/M1A1").size() == 1);
+  REQUIRE_FALSE(index.get_importers("$/Unit/Missing"));
+
+  SECTION("setting the imports of a file again replaces them") {
+    index.set_file_imports("a.ndfbin", {{"$/Unit/T72", {"Weapon_A"}}});
+    REQUIRE(importers_of(index, "$/Unit/T72")["a.ndfbin"] ==
+            std::set<std::string>{"Weapon_A"});
+    REQUIRE_FALSE(index.get_importers("$/Unit/M1A1"));
+  }
+  SECTION("single export paths are updated") {
+    index.set_imports("b.ndfbin", "$/Unit/M1A1", {"Deck_B"});
+    REQUIRE(importers_of(index, "$/Unit/M1A1").size() == 2);
+    // an empty set removes the file from the importers
+    index.set_imports("a.ndfbin", "$/Unit/T72", {});
+    REQUIRE(importers_of(index, "$/Unit/T72") ==
+            std::map<std::string, std::set<std::string>>{
+                {"b.ndfbin", {"Deck_B"}}});
+  }
+  SECTION("removed files import nothing") {
+    index.remove_file("a.ndfbin");
+    index.remove_file("c.ndfbin");
+    REQUIRE(importers_of(index, "$/Unit/T72").size() == 1);
+    REQUIRE_FALSE(index.get_importers("$/Unit/M1A1"));
+  }
+}
+
+TEST_CASE("importers held by readers don't change", "[reference_index]") {
+  ReferenceIndex index;
+  index.set_file_imports("a.ndfbin", {{"$/Unit/T72", {"Weapon_A"}}});
+  auto held = index.get_importers("$/Unit/T72");
+  REQUIRE(held);
+
+  index.set_file_imports("b.ndfbin", {{"$/Unit/T72", {"Deck_B"}}});
+  index.set_imports("a.ndfbin", "$/Unit/T72", {"Pack_A"});
+  REQUIRE(held->size() == 1);
+  REQUIRE(*held->at("a.ndfbin") == std::set<std::string>{"Weapon_A"});
+  REQUIRE(importers_of(index, "$/Unit/T72").size() == 2);
+
+  // the object sets of untouched files are shared with the held importers
+  auto b_held = index.get_importers("$/Unit/T72");
+  index.set_imports("a.ndfbin", "$/Unit/T72", {"Weapon_A"});
+  REQUIRE(index.get_importers("$/Unit/T72")->at("b.ndfbin") ==
+          b_held->at("b.ndfbin"));
+
+  index.remove_file("a.ndfbin");
+  index.remove_file("b.ndfbin");
+  REQUIRE(held->size() == 1);
+  REQUIRE_FALSE(index.get_importers("$/Unit/T72"));
+}
+
+TEST_CASE("many files importing the same export path", "[reference_index]") {
+  ReferenceIndex index;
+  constexpr int file_count = 2000;
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; t++) {
+    threads.emplace_back([&index, t]() {
+      for (int i = t; i < file_count; i += 4) {
+        std::string vfs_path = "file_" + std::to_string(i) + ".ndfbin";
+        index.set_file_imports(vfs_path,
+                               {{"$/Shared", {"Object_" + std::to_string(i)}},
+                                {"$/Own_" + std::to_string(i), {"Object"}}});
+        // readers in between force copies
+        if (i % 100 == 0) {
+          auto importers = index.get_importers("$/Shared");
+          (void)importers;
+        }
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  auto importers = index.get_importers("$/Shared");
+  REQUIRE(importers);
+  REQUIRE(importers->size() == file_count);
+  REQUIRE(*importers->at("file_7.ndfbin") ==
+          std::set<std::string>{"Object_7"});
+  REQUIRE(index.get_importers("$/Own_1999"));
+}
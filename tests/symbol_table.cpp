@@ -0,0 +1,68 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "symbol_table.hpp"
+
+using namespace wgrd_files;
+
+TEST_CASE("symbols of equal strings are equal", "[symbol_table]") {
+  SymbolTable table;
+  Symbol a = table.intern("TUniteDescriptor");
+  Symbol b = table.intern("TModuleSelector");
+  REQUIRE(a != b);
+  REQUIRE(table.intern(std::string("TUniteDescriptor")) == a);
+  REQUIRE(table.size() == 2);
+  REQUIRE(table.str(a) == "TUniteDescriptor");
+  REQUIRE(table.str(b) == "TModuleSelector");
+  REQUIRE(std::strcmp(table.c_str(b), "TModuleSelector") == 0);
+}
+
+TEST_CASE("symbols are only found after interning", "[symbol_table]") {
+  SymbolTable table;
+  REQUIRE_FALSE(table.find("Descriptor_Unit_A"));
+  Symbol symbol = table.intern("Descriptor_Unit_A");
+  REQUIRE(table.find("Descriptor_Unit_A") == symbol);
+  REQUIRE_FALSE(table.find("Descriptor_Unit"));
+  REQUIRE(table.size() == 1);
+}
+
+TEST_CASE("the empty string and embedded nulls", "[symbol_table]") {
+  SymbolTable table;
+  Symbol empty = table.intern("");
+  Symbol with_null = table.intern(std::string_view("a\0b", 3));
+  Symbol prefix = table.intern("a");
+  REQUIRE(table.str(empty).empty());
+  REQUIRE(table.c_str(empty)[0] == '\0');
+  REQUIRE(table.str(with_null) == std::string_view("a\0b", 3));
+  REQUIRE(with_null != prefix);
+}
+
+TEST_CASE("interned strings never move", "[symbol_table]") {
+  SymbolTable table;
+  // enough names to fill several blocks, and some larger than a quarter of
+  // a block that get their own allocation
+  std::vector<std::string> names;
+  for (int i = 0; i < 20000; i++) {
+    names.push_back("Descriptor_Unit_" + std::to_string(i));
+    if (i % 5000 == 0) {
+      names.push_back(std::string(20000 + i, 'x'));
+    }
+  }
+  std::vector<Symbol> symbols;
+  std::vector<const char *> pointers;
+  for (auto &name : names) {
+    symbols.push_back(table.intern(name));
+    pointers.push_back(table.c_str(symbols.back()));
+  }
+  REQUIRE(table.size() == names.size());
+  REQUIRE(table.memory_usage() > 64 * 1024);
+  for (size_t i = 0; i < names.size(); i++) {
+    REQUIRE(table.str(symbols[i]) == names[i]);
+    REQUIRE(table.c_str(symbols[i]) == pointers[i]);
+    REQUIRE(table.intern(names[i]) == symbols[i]);
+  }
+}
@@ -0,0 +1,117 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <atomic>
+#include <future>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+#include "task_scheduler.hpp"
+
+using namespace wgrd_files;
+
+TEST_CASE("tasks return results and exceptions", "[task_scheduler]") {
+  TaskScheduler scheduler(2);
+  REQUIRE(scheduler.get_worker_count() == 2);
+  REQUIRE_FALSE(scheduler.is_worker());
+  REQUIRE_FALSE(scheduler.run_pending());
+
+  auto value = scheduler.submit(TaskPriority::VISIBLE, []() { return 42; });
+  auto error = scheduler.submit(TaskPriority::VISIBLE, []() -> int {
+    throw std::runtime_error("task failed");
+  });
+  auto on_worker = scheduler.submit(TaskPriority::BACKGROUND, [&]() {
+    return scheduler.is_worker();
+  });
+  REQUIRE(value.get() == 42);
+  REQUIRE_THROWS_AS(error.get(), std::runtime_error);
+  REQUIRE(on_worker.get());
+}
+
+TEST_CASE("all submitted tasks run", "[task_scheduler]") {
+  TaskScheduler scheduler(4);
+  std::atomic_int count = 0;
+  std::vector<std::future<void>> futures;
+  for (int i = 0; i < 10000; i++) {
+    auto priority = static_cast<TaskPriority>(i % task_priority_count);
+    futures.push_back(scheduler.submit(priority, [&]() { count++; }));
+  }
+  for (auto &future : futures) {
+    future.get();
+  }
+  REQUIRE(count == 10000);
+}
+
+TEST_CASE("tasks submitted by tasks can be waited for", "[task_scheduler]") {
+  // a single worker has to run the children while waiting for them
+  TaskScheduler scheduler(1);
+  auto parent = scheduler.submit(TaskPriority::INTERACTIVE, [&]() {
+    std::vector<std::future<int>> children;
+    for (int i = 0; i < 100; i++) {
+      children.push_back(
+          scheduler.submit(TaskPriority::BACKGROUND, [i]() { return i; }));
+    }
+    int sum = 0;
+    for (auto &child : children) {
+      scheduler.wait(child);
+      sum += child.get();
+    }
+    return sum;
+  });
+  scheduler.wait(parent);
+  REQUIRE(parent.get() == 4950);
+}
+
+TEST_CASE("higher priorities run first", "[task_scheduler]") {
+  TaskScheduler scheduler(1);
+  // keeps the only worker busy until everything is queued
+  std::promise<void> release;
+  auto blocker = scheduler.submit(TaskPriority::INTERACTIVE,
+                                  [future = release.get_future()]() mutable {
+                                    future.wait();
+                                  });
+  std::mutex mutex;
+  std::vector<TaskPriority> order;
+  std::vector<std::future<void>> futures;
+  for (auto priority : {TaskPriority::BACKGROUND, TaskPriority::VISIBLE,
+                        TaskPriority::INTERACTIVE, TaskPriority::BACKGROUND,
+                        TaskPriority::INTERACTIVE}) {
+    futures.push_back(scheduler.submit(priority, [&, priority]() {
+      std::lock_guard lock(mutex);
+      order.push_back(priority);
+    }));
+  }
+  release.set_value();
+  for (auto &future : futures) {
+    future.get();
+  }
+  REQUIRE(order == std::vector<TaskPriority>{
+                       TaskPriority::INTERACTIVE, TaskPriority::INTERACTIVE,
+                       TaskPriority::VISIBLE, TaskPriority::BACKGROUND,
+                       TaskPriority::BACKGROUND});
+}
+
+TEST_CASE("cancelled tasks are dropped", "[task_scheduler]") {
+  TaskScheduler scheduler(1);
+  std::promise<void> release;
+  auto blocker = scheduler.submit(TaskPriority::INTERACTIVE,
+                                  [future = release.get_future()]() mutable {
+                                    future.wait();
+                                  });
+  CancellationToken token;
+  std::atomic_int ran = 0;
+  auto first =
+      scheduler.submit(TaskPriority::VISIBLE, [&]() { ran++; }, token);
+  // copies share the cancellation
+  auto second = scheduler.submit(
+      TaskPriority::VISIBLE, [&]() { ran++; }, CancellationToken(token));
+  auto other = scheduler.submit(TaskPriority::VISIBLE, [&]() { ran++; });
+  token.cancel();
+  REQUIRE(token.is_cancelled());
+  release.set_value();
+
+  other.get();
+  REQUIRE_THROWS_AS(first.get(), std::future_error);
+  REQUIRE_THROWS_AS(second.get(), std::future_error);
+  REQUIRE(ran == 1);
+}
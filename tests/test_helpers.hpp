@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstdint>
+#include <fstream>
+#include <random>
+#include <string>
+#include <string_view>
+
+#include <filesystem>
+namespace fs = std::filesystem;
+
+namespace wgrd_files {
+
+// unique directory below the system temp directory, removed with everything
+// in it when destroyed
+class TempDir {
+private:
+  fs::path m_path;
+
+public:
+  TempDir() {
+    std::random_device rd;
+    do {
+      m_path = fs::temp_directory_path() /
+               ("modding_suite_test_" + std::to_string(rd()));
+    } while (!fs::create_directory(m_path));
+  }
+  TempDir(const TempDir &) = delete;
+  TempDir &operator=(const TempDir &) = delete;
+  ~TempDir() {
+    std::error_code ec;
+    fs::remove_all(m_path, ec);
+  }
+  const fs::path &path() const { return m_path; }
+  fs::path operator/(const fs::path &name) const { return m_path / name; }
+};
+
+inline std::string read_file(const fs::path &path) {
+  std::ifstream in(path, std::ios::binary);
+  return std::string(std::istreambuf_iterator<char>(in), {});
+}
+
+inline void write_file(const fs::path &path, std::string_view data) {
+  std::ofstream out(path, std::ios::binary | std::ios::trunc);
+  out.write(data.data(), data.size());
+}
+
+// flips the bits of the byte at pos, pos counts from the end if negative
+inline void corrupt_file(const fs::path &path, int64_t pos) {
+  std::string data = read_file(path);
+  size_t idx = pos < 0 ? data.size() + pos : pos;
+  data[idx] = static_cast<char>(~data[idx]);
+  write_file(path, data);
+}
+
+// cuts the last count bytes off the file
+inline void truncate_file(const fs::path &path, size_t count) {
+  fs::resize_file(path, fs::file_size(path) - count);
+}
+
+} // namespace wgrd_files
@@ -0,0 +1,146 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include <thread>
+#include <vector>
+
+#include "test_helpers.hpp"
+#include "vfs_cache.hpp"
+
+using namespace wgrd_files;
+
+namespace {
+
+VfsCache make_cache() {
+  VfsCache cache;
+  cache.dats.push_back({"/dats/ZZ_Win/pc/ndf/NDF_Win.dat", 123456,
+                        1700000000, 0x0123456789abcdefULL});
+  cache.dats.push_back({"/dats/ZZ_1.dat", 42, -5, 7});
+  cache.strings = {"pc", "ndf", "patchable", "gfx", "everything.ndfbin",
+                   "texture", "unit.tgv"};
+  cache.entries.push_back(
+      {{0, 1, 2, 3, 4},
+       {{0, 0x41, 1000, FileType::NDFBIN}, {1, 0x200, 2000, FileType::NDFBIN}}});
+  cache.entries.push_back({{0, 5, 6}, {{0, 0x1000, 0, FileType::TGV}}});
+  return cache;
+}
+
+void require_equal(const VfsCache &a, const VfsCache &b) {
+  REQUIRE(a.dats == b.dats);
+  REQUIRE(a.strings == b.strings);
+  REQUIRE(a.entries.size() == b.entries.size());
+  for (size_t i = 0; i < a.entries.size(); i++) {
+    REQUIRE(a.entries[i].parts == b.entries[i].parts);
+    REQUIRE(a.entries[i].metas.size() == b.entries[i].metas.size());
+    for (size_t j = 0; j < a.entries[i].metas.size(); j++) {
+      auto &meta_a = a.entries[i].metas[j];
+      auto &meta_b = b.entries[i].metas[j];
+      REQUIRE(meta_a.dat_idx == meta_b.dat_idx);
+      REQUIRE(meta_a.offset == meta_b.offset);
+      REQUIRE(meta_a.size == meta_b.size);
+      REQUIRE(meta_a.type == meta_b.type);
+    }
+  }
+}
+
+} // namespace
+
+TEST_CASE("vfs cache round trip", "[vfs_cache]") {
+  TempDir dir;
+  fs::path path = VfsCache::get_cache_path(dir.path(), "/dats");
+  VfsCache cache = make_cache();
+  REQUIRE(cache.save(path));
+  // no temporary file is left next to the cache
+  REQUIRE(std::distance(fs::directory_iterator(dir.path()),
+                        fs::directory_iterator()) == 1);
+
+  auto loaded = VfsCache::load(path);
+  REQUIRE(loaded);
+  require_equal(cache, loaded.value());
+
+  SECTION("saving again replaces the cache") {
+    cache.entries.pop_back();
+    REQUIRE(cache.save(path));
+    loaded = VfsCache::load(path);
+    REQUIRE(loaded);
+    require_equal(cache, loaded.value());
+  }
+}
+
+TEST_CASE("concurrent vfs cache saves", "[vfs_cache]") {
+  TempDir dir;
+  fs::path path = VfsCache::get_cache_path(dir.path(), "/dats");
+  VfsCache small = make_cache();
+  small.entries.pop_back();
+  std::vector<VfsCache> caches = {make_cache(), small};
+
+  // writers of the same cache never mix their files, the cache is always
+  // one of the saved ones
+  // catch assertions are not thread safe, the threads only count failures
+  std::vector<int> failed(caches.size());
+  std::vector<std::thread> threads;
+  for (size_t i = 0; i < caches.size(); i++) {
+    threads.emplace_back([&, i] {
+      for (int j = 0; j < 50; j++) {
+        failed[i] += !caches[i].save(path);
+      }
+    });
+  }
+  for (auto &thread : threads) {
+    thread.join();
+  }
+  REQUIRE(failed == std::vector<int>(caches.size()));
+  auto loaded = VfsCache::load(path);
+  REQUIRE(loaded);
+  require_equal(loaded->entries.size() == small.entries.size() ? small
+                                                                : caches[0],
+                loaded.value());
+  REQUIRE(std::distance(fs::directory_iterator(dir.path()),
+                        fs::directory_iterator()) == 1);
+}
+
+TEST_CASE("vfs cache paths depend on the root", "[vfs_cache]") {
+  REQUIRE(VfsCache::get_cache_path("db", "/a") ==
+          VfsCache::get_cache_path("db", "/a"));
+  REQUIRE(VfsCache::get_cache_path("db", "/a") !=
+          VfsCache::get_cache_path("db", "/b"));
+}
+
+TEST_CASE("broken vfs caches are rejected", "[vfs_cache]") {
+  TempDir dir;
+  fs::path path = dir / "vfs.cache";
+  REQUIRE(make_cache().save(path));
+  size_t size = fs::file_size(path);
+
+  SECTION("missing") {
+    fs::remove(path);
+    REQUIRE_FALSE(VfsCache::load(path));
+  }
+  SECTION("empty") {
+    write_file(path, "");
+    REQUIRE_FALSE(VfsCache::load(path));
+  }
+  SECTION("truncated") {
+    for (size_t count : {size_t(1), size_t(4), size_t(9), size / 2,
+                         size - 4}) {
+      REQUIRE(make_cache().save(path));
+      truncate_file(path, count);
+      REQUIRE_FALSE(VfsCache::load(path));
+    }
+  }
+  SECTION("bad magic") {
+    corrupt_file(path, 0);
+    REQUIRE_FALSE(VfsCache::load(path));
+  }
+  SECTION("other version") {
+    corrupt_file(path, 4);
+    REQUIRE_FALSE(VfsCache::load(path));
+  }
+  SECTION("flipped byte in the body") {
+    corrupt_file(path, size / 2);
+    REQUIRE_FALSE(VfsCache::load(path));
+  }
+  SECTION("bad crc") {
+    corrupt_file(path, -1);
+    REQUIRE_FALSE(VfsCache::load(path));
+  }
+}